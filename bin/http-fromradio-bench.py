@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""Time a full config download over the HTTP API, polling one FromRadio per request (what web clients do today) against the
+framed batch mode (?framed=true) and the streaming mode (?stream=true, Linux native only).
+
+    bin/http-fromradio-bench.py --host meshtastic.local [--https] [--port 443] [--runs 5] [--clients 2]
+
+Only needs the python standard library.  Each run asks for the config with a fresh want_config_id and stops when the node
+sends the matching config_complete_id.  Clients keep the session cookie like a browser does, with --clients several of them
+download the config at the same time and each has to get all of it.
+"""
+
+import argparse
+import http.client
+import random
+import ssl
+import statistics
+import struct
+import threading
+import time
+
+START1, START2 = 0x94, 0xC3
+FROMRADIO_CONFIG_COMPLETE_ID = 7
+TORADIO_WANT_CONFIG_ID = 3
+RUN_TIMEOUT_SEC = 60
+
+
+def varint(v):
+    out = bytearray()
+    while True:
+        b = v & 0x7F
+        v >>= 7
+        if v:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return bytes(out)
+
+
+def read_varint(buf, i):
+    shift = v = 0
+    while True:
+        b = buf[i]
+        i += 1
+        v |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return v, i
+
+
+def config_complete_id(msg):
+    """The config_complete_id of an encoded FromRadio, or None"""
+    i = 0
+    while i < len(msg):
+        key, i = read_varint(msg, i)
+        field, wire = key >> 3, key & 7
+        if wire == 0:
+            v, i = read_varint(msg, i)
+            if field == FROMRADIO_CONFIG_COMPLETE_ID:
+                return v
+        elif wire == 2:
+            n, i = read_varint(msg, i)
+            i += n
+        elif wire == 5:
+            i += 4
+        elif wire == 1:
+            i += 8
+        else:
+            return None
+    return None
+
+
+def split_frames(data):
+    """Split a body of stream API frames into messages, returns (messages, leftover bytes)"""
+    msgs = []
+    i = 0
+    while len(data) - i >= 4:
+        if data[i] != START1 or data[i + 1] != START2:
+            raise ValueError("lost framing at byte %d" % i)
+        n = struct.unpack(">H", data[i + 2 : i + 4])[0]
+        if len(data) - i - 4 < n:
+            break
+        msgs.append(data[i + 4 : i + 4 + n])
+        i += 4 + n
+    return msgs, data[i:]
+
+
+class Client:
+    def __init__(self, args):
+        self.args = args
+        self.cookie = None  # the Linux native webserver keeps a PhoneAPI per client, this tells it which one we are
+
+    def connect(self):
+        if self.args.https:
+            return http.client.HTTPSConnection(
+                self.args.host, self.args.port, timeout=30, context=ssl._create_unverified_context()
+            )
+        return http.client.HTTPConnection(self.args.host, self.args.port, timeout=30)
+
+    def request(self, conn, method, path, body=None, headers={}):
+        headers = dict(headers)
+        if self.cookie:
+            headers["Cookie"] = self.cookie
+        conn.request(method, path, body, headers)
+        resp = conn.getresponse()
+        cookie = resp.getheader("Set-Cookie")
+        if cookie:
+            self.cookie = cookie.split(";")[0]
+        if resp.status != 200:
+            raise RuntimeError("%s %s: HTTP %d" % (method, path, resp.status))
+        return resp
+
+    def want_config(self, conn, nonce):
+        body = bytes([TORADIO_WANT_CONFIG_ID << 3]) + varint(nonce)
+        self.request(conn, "PUT", "/api/v1/toradio", body, {"Content-Type": "application/x-protobuf"}).read()
+
+
+def check_timeout(start):
+    if time.monotonic() - start > RUN_TIMEOUT_SEC:
+        raise RuntimeError("no config_complete_id after %d s" % RUN_TIMEOUT_SEC)
+
+
+def run_poll(client, nonce):
+    start = time.monotonic()
+    conn = client.connect()
+    client.want_config(conn, nonce)
+    msgs = requests = 0
+    while True:
+        check_timeout(start)
+        msg = client.request(conn, "GET", "/api/v1/fromradio").read()
+        requests += 1
+        if not msg:
+            continue  # nothing ready yet
+        msgs += 1
+        if config_complete_id(msg) == nonce:
+            return msgs, requests
+
+
+def run_framed(client, nonce):
+    start = time.monotonic()
+    conn = client.connect()
+    client.want_config(conn, nonce)
+    msgs = requests = 0
+    while True:
+        check_timeout(start)
+        frames, _ = split_frames(client.request(conn, "GET", "/api/v1/fromradio?framed=true").read())
+        requests += 1
+        for msg in frames:
+            msgs += 1
+            if config_complete_id(msg) == nonce:
+                return msgs, requests
+
+
+def run_stream(client, nonce):
+    conn = client.connect()
+    client.want_config(conn, nonce)
+    resp = client.request(conn, "GET", "/api/v1/fromradio?stream=true")
+    conn.sock.settimeout(RUN_TIMEOUT_SEC)
+    msgs = 0
+    pending = b""
+    while True:
+        chunk = resp.read1(4096)
+        if not chunk:
+            raise RuntimeError("stream ended before the config was complete")
+        frames, pending = split_frames(pending + chunk)
+        for msg in frames:
+            msgs += 1
+            if config_complete_id(msg) == nonce:
+                conn.close()
+                return msgs, 1
+
+
+def run_clients(run, clients):
+    """Run a download on each client at the same time, returns a (messages, requests) or an exception per client"""
+    results = [None] * len(clients)
+
+    def one(i):
+        try:
+            results[i] = run(clients[i], random.randint(1, 0xFFFFFFFF))
+        except Exception as e:  # e.g. stream mode on an ESP32
+            results[i] = e
+
+    threads = [threading.Thread(target=one, args=(i,)) for i in range(len(clients))]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="localhost")
+    parser.add_argument("--port", type=int)
+    parser.add_argument("--https", action="store_true")
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument("--clients", type=int, default=1, help="how many clients download the config at the same time")
+    parser.add_argument("--modes", default="poll,framed,stream", help="comma separated, from poll, framed and stream")
+    args = parser.parse_args()
+    if args.port is None:
+        args.port = 443 if args.https else 80
+
+    clients = [Client(args) for _ in range(args.clients)]
+    modes = {"poll": run_poll, "framed": run_framed, "stream": run_stream}
+    for name in args.modes.split(","):
+        times = []
+        for _ in range(args.runs):
+            start = time.monotonic()
+            results = run_clients(modes[name], clients)
+            failed = [(i, r) for i, r in enumerate(results) if isinstance(r, Exception)]
+            for i, e in failed:
+                print("%-7s client %d failed: %s" % (name, i, e))
+            if failed:
+                break
+            times.append(time.monotonic() - start)
+        if times:
+            for i, (msgs, requests) in enumerate(results):
+                label = name if len(clients) == 1 else "%s/%d" % (name, i)
+                print(
+                    "%-9s %4d messages, %4d requests, full config, session %s"
+                    % (label, msgs, requests, (clients[i].cookie or "-").split("=")[-1][:8])
+                )
+            print("%-9s median %7.1f ms, best %7.1f ms" % (name, statistics.median(times) * 1000, min(times) * 1000))
+
+
+if __name__ == "__main__":
+    main()
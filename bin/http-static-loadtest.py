@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""Load the web client from a node's /static files with several clients at once, like a room full of phones opening the page.
+
+    bin/http-static-loadtest.py --host meshtastic.local [--https] [--port 443] [--clients 4] [--rounds 3]
+
+Only needs the python standard library.  Each client fetches index.html and every script, stylesheet and image it references,
+first from scratch and then again sending the ETags it got (If-None-Match), which should all come back 304 Not Modified.
+"""
+
+import argparse
+import gzip
+import http.client
+import re
+import ssl
+import statistics
+import threading
+import time
+
+ASSET_RE = re.compile(rb'(?:src|href)="(/[^"#?]+)"')
+
+
+def connect(args):
+    if args.https:
+        return http.client.HTTPSConnection(args.host, args.port, timeout=60, context=ssl._create_unverified_context())
+    return http.client.HTTPConnection(args.host, args.port, timeout=60)
+
+
+def fetch(conn, path, etags):
+    """GET path, revalidating if we have an ETag for it, returns (status, body bytes)"""
+    headers = {"Accept-Encoding": "gzip"}
+    if path in etags:
+        headers["If-None-Match"] = etags[path]
+    conn.request("GET", path, headers=headers)
+    resp = conn.getresponse()
+    body = resp.read()
+    if resp.getheader("ETag"):
+        etags[path] = resp.getheader("ETag")
+    return resp.status, body
+
+
+def load_page(args, etags, stats):
+    """Fetch the page and its assets over one keep-alive connection, like a browser would (well, with fewer connections)"""
+    conn = connect(args)
+    start = time.monotonic()
+    status, body = fetch(conn, args.path, etags)
+    paths = [args.path]
+    if status == 200:
+        if body[:2] == b"\x1f\x8b":
+            body = gzip.decompress(body)
+        assets = sorted(set(m.decode() for m in ASSET_RE.findall(body)))
+        etags.setdefault("_assets", assets)
+    paths += etags.get("_assets", [])
+
+    counts = {}
+    nbytes = len(body)
+    counts[status] = 1
+    for path in paths[1:]:
+        status, body = fetch(conn, path, etags)
+        counts[status] = counts.get(status, 0) + 1
+        nbytes += len(body)
+    conn.close()
+    stats.append((time.monotonic() - start, nbytes, counts))
+
+
+def run(args, label, rounds_etags):
+    stats = []
+    threads = [threading.Thread(target=load_page, args=(args, rounds_etags[i], stats)) for i in range(args.clients)]
+    start = time.monotonic()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    wall = time.monotonic() - start
+
+    if not stats:
+        print("%-11s every client failed" % label)
+        return
+    times = [s[0] for s in stats]
+    counts = {}
+    for s in stats:
+        for status, n in s[2].items():
+            counts[status] = counts.get(status, 0) + n
+    print(
+        "%-11s %d clients, %7.1f kB, median %7.1f ms, worst %7.1f ms, all done in %7.1f ms, statuses %s"
+        % (
+            label,
+            len(stats),
+            sum(s[1] for s in stats) / 1024,
+            statistics.median(times) * 1000,
+            max(times) * 1000,
+            wall * 1000,
+            " ".join("%d:%d" % kv for kv in sorted(counts.items())),
+        )
+    )
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="meshtastic.local")
+    parser.add_argument("--port", type=int)
+    parser.add_argument("--https", action="store_true")
+    parser.add_argument("--path", default="/static/index.html")
+    parser.add_argument("--clients", type=int, default=4)
+    parser.add_argument("--rounds", type=int, default=3)
+    args = parser.parse_args()
+    if args.port is None:
+        args.port = 443 if args.https else 80
+
+    for r in range(args.rounds):
+        etags = [{} for _ in range(args.clients)]
+        run(args, "cold %d" % (r + 1), etags)
+        run(args, "revalidate", etags)
+
+
+if __name__ == "__main__":
+    main()
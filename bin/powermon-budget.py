@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""Replay a meshtasticd power trace (Logging: PowerTraceFile in config.yaml) and estimate the charge used by each subsystem.
+
+    bin/powermon-budget.py /var/log/meshtasticd-power.csv [--ma lora_tx=90 --ma gps=30] [--hours 24]
+
+Each line of the trace is "millis,0xstates,reason", written whenever a PowerMon state changes.  The time in each state is
+charged the same way PowerMon::account() does it, with the default currents below (PowerMon.h), which --ma overrides so
+the same trace can be priced for different boards.  --hours scales the result, e.g. to size a solar relay for a day.
+"""
+
+import argparse
+
+# meshtastic_PowerMon_State
+CPU_DEEPSLEEP = 1
+CPU_LIGHTSLEEP = 2
+LORA_RXON = 8
+LORA_TXON = 16
+BT_ON = 64
+LED_ON = 128
+SCREEN_ON = 256
+WIFI_ON = 1024
+GPS_ACTIVE = 2048
+
+DEFAULT_MA = {
+    "cpu": 25.0,
+    "cpu_lightsleep": 0.8,
+    "lora_rx": 6.0,
+    "lora_tx": 118.0,
+    "bluetooth": 1.0,
+    "wifi": 80.0,
+    "screen": 10.0,
+    "gps": 25.0,
+    "led": 5.0,
+}
+
+
+def consumers(states):
+    """Which consumers draw current in this state"""
+    on = []
+    if states & CPU_LIGHTSLEEP:
+        on.append("cpu_lightsleep")
+    elif not states & CPU_DEEPSLEEP:
+        on.append("cpu")
+    if states & LORA_TXON:
+        on.append("lora_tx")
+    elif states & LORA_RXON:
+        on.append("lora_rx")
+    for bit, name in ((BT_ON, "bluetooth"), (WIFI_ON, "wifi"), (SCREEN_ON, "screen"), (GPS_ACTIVE, "gps"), (LED_ON, "led")):
+        if states & bit:
+            on.append(name)
+    return on
+
+
+def replay(path):
+    """Returns ({consumer: msec}, traced msec), a new boot line starts counting again from 0"""
+    msec = {name: 0 for name in DEFAULT_MA}
+    total = 0
+    last = None
+    states = 0
+    with open(path) as f:
+        for line in f:
+            parts = line.rstrip("\n").split(",", 2)
+            if len(parts) < 2:
+                continue
+            now, new_states = int(parts[0]), int(parts[1], 16)
+            if last is not None and not (len(parts) > 2 and parts[2] == "boot"):
+                elapsed = (now - last) & 0xFFFFFFFF
+                total += elapsed
+                for name in consumers(states):
+                    msec[name] += elapsed
+            last, states = now, new_states
+    return msec, total
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("trace")
+    parser.add_argument("--ma", action="append", default=[], metavar="NAME=MA", help="current of a consumer in mA")
+    parser.add_argument("--hours", type=float, help="scale the result to this many hours")
+    args = parser.parse_args()
+
+    ma = dict(DEFAULT_MA)
+    for override in args.ma:
+        name, value = override.split("=", 1)
+        if name not in ma:
+            parser.error("unknown consumer %s, one of %s" % (name, ", ".join(ma)))
+        ma[name] = float(value)
+
+    msec, total = replay(args.trace)
+    if total == 0:
+        print("Nothing traced")
+        return
+    scale = args.hours * 3600 * 1000 / total if args.hours else 1.0
+
+    print("Traced %.1f s%s" % (total / 1000, ", scaled to %g h" % args.hours if args.hours else ""))
+    print("%-15s %7s %9s %10s" % ("consumer", "on %", "mA", "mAh"))
+    charge = 0.0
+    for name, t in msec.items():
+        mah = t * ma[name] / 3600e3 * scale
+        charge += mah
+        if t:
+            print("%-15s %6.1f%% %9.1f %10.3f" % (name, 100.0 * t / total, ma[name], mah))
+    print("%-15s %7s %9.2f %10.3f" % ("total", "", charge * 3600e3 / (total * scale), charge))
+
+
+if __name__ == "__main__":
+    main()
@@ -13,6 +13,8 @@
 #define FROMNUM_UUID "ed9da18c-a800-4f66-a670-aa7547e34453"
 #define LEGACY_LOGRADIO_UUID "6c6fd238-78fa-436b-aacf-15c5be1ef2e2"
 #define LOGRADIO_UUID "5a3d6e49-06e6-4423-9944-e9de8cdf9547"
+// FromRadios framed like the serial API (0x94 0xc3 len16 protobuf), as many as fit in each read or notify (NimBLE only)
+#define FROMRADIOSTREAM_UUID "3beee7e7-2dd2-4659-b6d8-7f03cd2c9f7b"
 
 // NRF52 wants these constants as byte arrays
 // Generated here https://yupana-engineering.com/online-uuid-to-c-array-converter - but in REVERSE BYTE ORDER
@@ -142,6 +142,15 @@ using namespace meshtastic;
 #endif
 #endif
 
+#ifndef BATTERY_SENSE_RESOLUTION_BITS
+#define BATTERY_SENSE_RESOLUTION_BITS 10
+#endif
+
+#if defined(ARCH_NRF52) && !defined(BATTERY_SENSE_OVERSAMPLING)
+// The SAADC averages this many conversions (a power of 2) into each analogRead(), in hardware
+#define BATTERY_SENSE_OVERSAMPLING 16
+#endif
+
 /**
  * If this board has a battery level sensor, set this to a valid implementation
  */
@@ -203,8 +212,17 @@ class AnalogBatteryLevel : public HasBatteryLevel
         }
 #endif
 
-        float v = getBattVoltage();
+        uint16_t v = getBattVoltage();
+        // The voltage only changes every few seconds, but we're asked for the percentage several times each time
+        if (v == percent_for_mv)
+            return last_percent;
+        percent_for_mv = v;
+        last_percent = voltageToPercent(v);
+        return last_percent;
+    }
 
+    int voltageToPercent(uint16_t v)
+    {
         if (v < noBatVolt)
             return -1; // If voltage is super low assume no battery installed
 
@@ -282,26 +300,36 @@ class AnalogBatteryLevel : public HasBatteryLevel
             scaled = esp_adc_cal_raw_to_voltage(raw, adc_characs);
             scaled *= operativeAdcMultiplier;
 #else // block for all other platforms
+#ifdef BATTERY_SENSE_OVERSAMPLING
+            // Already the average of BATTERY_SENSE_OVERSAMPLING conversions.  Oversampling is a SAADC setting for every pin,
+            // so it is back off for the other analogRead() users (sensors, the five way button) once we are done
+            analogOversampling(BATTERY_SENSE_OVERSAMPLING);
+            raw = analogRead(BATTERY_PIN);
+            analogOversampling(1);
+#else
             for (uint32_t i = 0; i < BATTERY_SENSE_SAMPLES; i++) {
                 raw += analogRead(BATTERY_PIN);
             }
             raw = raw / BATTERY_SENSE_SAMPLES;
-            scaled = operativeAdcMultiplier * ((1000 * AREF_VOLTAGE) / pow(2, BATTERY_SENSE_RESOLUTION_BITS)) * raw;
+#endif
+            scaled = operativeAdcMultiplier * adcMvPerCount * raw;
 #endif
             adcDisable();
 
+            int32_t sample = (int32_t)(scaled * (1 << FILTER_FRACTION_BITS));
             if (!initial_read_done) {
                 // Flush the smoothing filter with an ADC reading, if the reading is plausibly correct
-                if (scaled > last_read_value)
-                    last_read_value = scaled;
+                if (sample > filtered_mv)
+                    filtered_mv = sample;
                 initial_read_done = true;
             } else {
                 // Already initialized - filter this reading
-                last_read_value += (scaled - last_read_value) * 0.5; // Virtual LPF
+                filtered_mv += (sample - filtered_mv) / 2; // Virtual LPF
             }
+            last_read_value = filtered_mv >> FILTER_FRACTION_BITS;
 
-            // LOG_DEBUG("battery gpio %d raw val=%u scaled=%u filtered=%u", BATTERY_PIN, raw, (uint32_t)(scaled), (uint32_t)
-            // (last_read_value));
+            // LOG_DEBUG("battery gpio %d raw val=%u scaled=%u filtered=%u", BATTERY_PIN, raw, (uint32_t)(scaled),
+            // last_read_value);
         }
         return last_read_value;
 #endif // BATTERY_PIN
@@ -430,8 +458,17 @@ class AnalogBatteryLevel : public HasBatteryLevel
     // that could trigger some events.
     // This value is over-written by the first ADC reading, it the voltage seems reasonable.
     bool initial_read_done = false;
-    float last_read_value = (OCV[NUM_OCV_POINTS - 1] * NUM_CELLS);
+    uint16_t last_read_value = (OCV[NUM_OCV_POINTS - 1] * NUM_CELLS);
     uint32_t last_read_time_ms = 0;
+    // The smoothed voltage in fixed point, mV with FILTER_FRACTION_BITS fraction bits
+    static const int FILTER_FRACTION_BITS = 4;
+    int32_t filtered_mv = (int32_t)last_read_value << FILTER_FRACTION_BITS;
+#if !defined(ARCH_ESP32) && defined(BATTERY_PIN)
+    static constexpr float adcMvPerCount = (1000 * AREF_VOLTAGE) / (1 << BATTERY_SENSE_RESOLUTION_BITS);
+#endif
+    // getBatteryPercent() of the last voltage it was asked about
+    uint16_t percent_for_mv = 0;
+    int last_percent = -1;
 
 #if defined(HAS_RAKPROT)
 
@@ -515,10 +552,6 @@ bool Power::analogInit()
     // disable any internal pullups
     pinMode(BATTERY_PIN, INPUT);
 
-#ifndef BATTERY_SENSE_RESOLUTION_BITS
-#define BATTERY_SENSE_RESOLUTION_BITS 10
-#endif
-
 #ifdef ARCH_ESP32 // ESP32 needs special analog stuff
 
 #ifndef ADC_WIDTH // max resolution by default
@@ -13,6 +13,7 @@
 #include "MeshService.h"
 #include "NodeDB.h"
 #include "PowerMon.h"
+#include "RadioLibInterface.h"
 #include "configuration.h"
 #include "graphics/Screen.h"
 #include "main.h"
@@ -200,6 +201,9 @@ static void powerEnter()
     } else {
         screen->setOn(true);
         setBluetoothEnable(true);
+        // No need to save power in the receiver either
+        if (RadioLibInterface::instance)
+            RadioLibInterface::instance->setLowPowerReceive(false);
         // within enter() the function getState() returns the state we came from
 
         // Mothballed: print change of power-state to device screen
@@ -223,6 +227,8 @@ static void powerExit()
 {
     screen->setOn(true);
     setBluetoothEnable(true);
+    if (RadioLibInterface::instance)
+        RadioLibInterface::instance->setLowPowerReceive(true);
 
     // Mothballed: print change of power-state to device screen
     /*if (!isPowered())
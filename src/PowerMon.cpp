@@ -1,6 +1,35 @@
 #include "PowerMon.h"
 #include "NodeDB.h"
 
+#ifdef ARCH_PORTDUINO
+#include "platform/portduino/PortduinoGlue.h"
+#include <fstream>
+
+// Every state change, for replaying with other current figures (bin/powermon-budget.py)
+static std::ofstream powerTraceFile;
+#endif
+
+static const float consumerMa[PowerMon::NUM_CONSUMERS] = {
+    POWERMON_CPU_AWAKE_MA, POWERMON_CPU_LIGHTSLEEP_MA, POWERMON_LORA_RX_MA, POWERMON_LORA_TX_MA, POWERMON_BT_MA,
+    POWERMON_WIFI_MA,      POWERMON_SCREEN_MA,         POWERMON_GPS_MA,     POWERMON_LED_MA};
+
+static const char *const consumerNames[PowerMon::NUM_CONSUMERS] = {
+    "cpu", "cpu_lightsleep", "lora_rx", "lora_tx", "bluetooth", "wifi", "screen", "gps", "led"};
+
+PowerMon::PowerMon()
+{
+    lastChangeMsec = millis();
+#ifdef ARCH_PORTDUINO
+    if (settingsStrings[powerTraceFilename] != "") {
+        powerTraceFile.open(settingsStrings[powerTraceFilename], std::ios::out | std::ios::app);
+        if (powerTraceFile.is_open())
+            powerTraceFile << lastChangeMsec << ",0x0,boot" << std::endl;
+        else
+            LOG_ERROR("Can't open power trace %s", settingsStrings[powerTraceFilename].c_str());
+    }
+#endif
+}
+
 // Use the 'live' config flag to figure out if we should be showing this message
 bool PowerMon::is_power_enabled(uint64_t m)
 {
@@ -12,23 +41,88 @@ bool PowerMon::is_power_enabled(uint64_t m)
 void PowerMon::setState(_meshtastic_PowerMon_State state, const char *reason)
 {
 #ifdef USE_POWERMON
-    auto oldstates = states;
-    states |= state;
-    if (oldstates != states && is_power_enabled(state)) {
-        emitLog(reason);
-    }
+    changeStates(states | state, state, reason);
 #endif
 }
 
 void PowerMon::clearState(_meshtastic_PowerMon_State state, const char *reason)
 {
 #ifdef USE_POWERMON
-    auto oldstates = states;
-    states &= ~state;
-    if (oldstates != states && is_power_enabled(state)) {
+    changeStates(states & ~state, state, reason);
+#endif
+}
+
+void PowerMon::changeStates(uint64_t newstates, _meshtastic_PowerMon_State state, const char *reason)
+{
+    if (newstates == states)
+        return;
+    uint32_t now = millis();
+    account(now); // what was on until now
+    states = newstates;
+
+#ifdef ARCH_PORTDUINO
+    if (powerTraceFile.is_open())
+        powerTraceFile << now << ",0x" << std::hex << (uint32_t)states << std::dec << "," << reason << std::endl;
+#endif
+
+    if (is_power_enabled(state))
         emitLog(reason);
+}
+
+void PowerMon::account(uint32_t now)
+{
+    uint32_t elapsed = now - lastChangeMsec;
+    lastChangeMsec = now;
+
+    if (states & meshtastic_PowerMon_State_CPU_LightSleep)
+        consumerMsec[CPU_LIGHTSLEEP] += elapsed;
+    else if (!(states & meshtastic_PowerMon_State_CPU_DeepSleep))
+        consumerMsec[CPU_AWAKE] += elapsed;
+
+    // The receiver isn't always turned off before we transmit, but it doesn't draw anything then
+    if (states & meshtastic_PowerMon_State_Lora_TXOn)
+        consumerMsec[LORA_TX] += elapsed;
+    else if (states & meshtastic_PowerMon_State_Lora_RXOn)
+        consumerMsec[LORA_RX] += elapsed;
+
+    if (states & meshtastic_PowerMon_State_BT_On)
+        consumerMsec[BLUETOOTH] += elapsed;
+    if (states & meshtastic_PowerMon_State_Wifi_On)
+        consumerMsec[WIFI] += elapsed;
+    if (states & meshtastic_PowerMon_State_Screen_On)
+        consumerMsec[SCREEN] += elapsed;
+    if (states & meshtastic_PowerMon_State_GPS_Active)
+        consumerMsec[GPS] += elapsed;
+    if (states & meshtastic_PowerMon_State_LED_On)
+        consumerMsec[LED] += elapsed;
+}
+
+uint64_t PowerMon::getMsec(Consumer c)
+{
+    account(millis()); // include the time since the last change
+    return consumerMsec[c];
+}
+
+float PowerMon::getMah(Consumer c)
+{
+    return getMsec(c) * consumerMa[c] / (3600.0f * 1000.0f);
+}
+
+const char *PowerMon::getName(Consumer c)
+{
+    return consumerNames[c];
+}
+
+void PowerMon::logEnergyBudget()
+{
+    float total = 0;
+    for (int c = 0; c < NUM_CONSUMERS; c++) {
+        float mah = getMah((Consumer)c);
+        total += mah;
+        if (consumerMsec[c])
+            LOG_DEBUG("Energy: %s on for %us, about %.2fmAh", consumerNames[c], (uint32_t)(consumerMsec[c] / 1000), mah);
     }
-#endif
+    LOG_INFO("Energy: about %.2fmAh since boot", total);
 }
 
 void PowerMon::emitLog(const char *reason)
@@ -44,4 +138,4 @@ PowerMon *powerMon;
 void powerMonInit()
 {
     powerMon = new PowerMon();
-}
\ No newline at end of file
+}
@@ -7,6 +7,48 @@
 #define USE_POWERMON // FIXME turn this only for certain builds
 #endif
 
+/*
+ * What each power state draws in mA, to estimate where the energy goes (PowerMon::getMah). These are typical datasheet
+ * figures, a variant.h can override them with what its board was measured at.
+ */
+#ifndef POWERMON_CPU_AWAKE_MA
+#if defined(ARCH_ESP32)
+#define POWERMON_CPU_AWAKE_MA 40.0f
+#elif defined(ARCH_NRF52)
+#define POWERMON_CPU_AWAKE_MA 3.0f
+#else
+#define POWERMON_CPU_AWAKE_MA 25.0f
+#endif
+#endif
+#ifndef POWERMON_CPU_LIGHTSLEEP_MA
+#define POWERMON_CPU_LIGHTSLEEP_MA 0.8f
+#endif
+#ifndef POWERMON_LORA_RX_MA
+#define POWERMON_LORA_RX_MA 6.0f
+#endif
+#ifndef POWERMON_LORA_TX_MA
+#define POWERMON_LORA_TX_MA 118.0f // SX1262 at 22dBm
+#endif
+#ifndef POWERMON_BT_MA
+#if defined(ARCH_ESP32)
+#define POWERMON_BT_MA 10.0f
+#else
+#define POWERMON_BT_MA 1.0f
+#endif
+#endif
+#ifndef POWERMON_WIFI_MA
+#define POWERMON_WIFI_MA 80.0f
+#endif
+#ifndef POWERMON_SCREEN_MA
+#define POWERMON_SCREEN_MA 10.0f
+#endif
+#ifndef POWERMON_GPS_MA
+#define POWERMON_GPS_MA 25.0f
+#endif
+#ifndef POWERMON_LED_MA
+#define POWERMON_LED_MA 5.0f
+#endif
+
 /**
  * The singleton class for monitoring power consumption of device
  * subsystems/modes.
@@ -25,13 +67,47 @@ class PowerMon
     bool force_enabled = false;
 
   public:
-    PowerMon() {}
+    /// Where the time goes, each is charged at its POWERMON_*_MA
+    enum Consumer {
+        CPU_AWAKE,
+        CPU_LIGHTSLEEP,
+        LORA_RX, // receiving or listening, but not while transmitting
+        LORA_TX,
+        BLUETOOTH,
+        WIFI,
+        SCREEN,
+        GPS,
+        LED,
+        NUM_CONSUMERS
+    };
+
+    PowerMon();
 
     // Mark entry/exit of a power consuming state
     void setState(_meshtastic_PowerMon_State state, const char *reason = "");
     void clearState(_meshtastic_PowerMon_State state, const char *reason = "");
 
+    /// Time spent in this state since boot, unlike the logging this is always counted
+    uint64_t getMsec(Consumer c);
+
+    /// Estimated charge used by this consumer since boot
+    float getMah(Consumer c);
+
+    static const char *getName(Consumer c);
+
+    /// Log the estimated charge used since boot, and (at debug level) what each consumer used
+    void logEnergyBudget();
+
   private:
+    uint64_t consumerMsec[NUM_CONSUMERS] = {0};
+    uint32_t lastChangeMsec = 0;
+
+    // Charge the time since the last change to whatever was on
+    void account(uint32_t now);
+
+    // Switch to newstates, state being the one that changed
+    void changeStates(uint64_t newstates, _meshtastic_PowerMon_State state, const char *reason);
+
     // Emit the coded log message
     void emitLog(const char *reason);
 
@@ -41,4 +117,4 @@ class PowerMon
 
 extern PowerMon *powerMon;
 
-void powerMonInit();
\ No newline at end of file
+void powerMonInit();
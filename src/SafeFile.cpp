@@ -18,33 +18,48 @@ static File openFile(const char *filename, bool fullAtomic)
 }
 
 SafeFile::SafeFile(const char *_filename, bool fullAtomic)
-    : filename(_filename), f(openFile(_filename, fullAtomic)), fullAtomic(fullAtomic)
+    : filename(_filename), f(openFile(_filename, fullAtomic)), fullAtomic(fullAtomic), buffer(new uint8_t[SAFEFILE_BUFFER_SIZE])
 {
 }
 
 size_t SafeFile::write(uint8_t ch)
 {
-    if (!f)
-        return 0;
-
-    hash ^= ch;
-    return f.write(ch);
+    return write(&ch, 1);
 }
 
-size_t SafeFile::write(const uint8_t *buffer, size_t size)
+size_t SafeFile::write(const uint8_t *data, size_t size)
 {
     if (!f)
         return 0;
 
-    for (size_t i = 0; i < size; i++) {
-        hash ^= buffer[i];
+    crc = crc32Update(data, size, crc);
+
+    size_t done = 0;
+    while (done < size) {
+        size_t n = min(size - done, (size_t)(SAFEFILE_BUFFER_SIZE - bufferUsed));
+        memcpy(buffer.get() + bufferUsed, data + done, n);
+        bufferUsed += n;
+        done += n;
+        if (bufferUsed == SAFEFILE_BUFFER_SIZE && !flushBuffer())
+            break;
+    }
+    return writeFailed ? 0 : size;
+}
+
+bool SafeFile::flushBuffer()
+{
+    if (bufferUsed) {
+        // This nasty cast is _IMPORTANT_ otherwise the correct adafruit method does not get used (they made a mistake in their
+        // typing)
+        if (f.write((uint8_t const *)buffer.get(), bufferUsed) != bufferUsed)
+            writeFailed = true;
+        bufferUsed = 0;
     }
-    return f.write((uint8_t const *)buffer, size); // This nasty cast is _IMPORTANT_ otherwise the correct adafruit method does
-                                                   // not get used (they made a mistake in their typing)
+    return !writeFailed;
 }
 
 /**
- * Atomically close the file (deleting any old versions) and readback the contents to confirm the hash matches
+ * Atomically close the file (deleting any old versions) and readback the contents to confirm the crc matches
  *
  * @return false for failure
  */
@@ -53,8 +68,15 @@ bool SafeFile::close()
     if (!f)
         return false;
 
+    bool flushed = flushBuffer();
     f.close();
-    if (!testReadback())
+    if (!flushed) {
+        LOG_ERROR("Write to tmp file failed");
+        return false;
+    }
+    bool readbackOk = testReadback();
+    buffer.reset(); // only needed while the file is open
+    if (!readbackOk)
         return false;
 
     // brief window of risk here ;-)
@@ -73,7 +95,7 @@ bool SafeFile::close()
     return true;
 }
 
-/// Read our (closed) tempfile back in and compare the hash
+/// Read our (closed) tempfile back in and compare the crc
 bool SafeFile::testReadback()
 {
     bool lfs_failed = lfs_assert_failed;
@@ -87,15 +109,16 @@ bool SafeFile::testReadback()
         return false;
     }
 
-    int c = 0;
-    uint8_t test_hash = 0;
-    while ((c = f2.read()) >= 0) {
-        test_hash ^= (uint8_t)c;
+    // Read back in chunks, a read() per byte goes through the whole filesystem stack every time
+    int n;
+    uint32_t test_crc = CRC32_INITIAL;
+    while ((n = f2.read(buffer.get(), SAFEFILE_BUFFER_SIZE)) > 0) {
+        test_crc = crc32Update(buffer.get(), n, test_crc);
     }
     f2.close();
 
-    if (test_hash != hash) {
-        LOG_ERROR("Readback failed hash mismatch");
+    if (test_crc != crc) {
+        LOG_ERROR("Readback failed crc mismatch");
         return false;
     }
 
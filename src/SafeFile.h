@@ -2,9 +2,16 @@
 
 #include "FSCommon.h"
 #include "configuration.h"
+#include <ErriezCRC32.h>
+#include <memory>
 
 #ifdef FSCom
 
+// Writes are collected into blocks of this size before they go to the filesystem, readback uses the same chunk size
+#ifndef SAFEFILE_BUFFER_SIZE
+#define SAFEFILE_BUFFER_SIZE 256
+#endif
+
 /**
  * This class provides 'safe'/paranoid file writing.
  *
@@ -12,12 +19,13 @@
  * be very careful about how we write files.  This class provides a restricted (Stream only) writing API for writing to files.
  *
  * Notably:
- * - we keep a simple xor hash of all characters that were written.
- * - We do not allow seeking (because we want to maintain our hash)
+ * - we keep a crc32 of all characters that were written (and buffer them on the heap so the filesystem sees block sized
+ * writes).
+ * - We do not allow seeking (because we want to maintain our crc)
  * - we provide an close() method which is similar to close but returns false if we were unable to successfully write the
  * file.  Also this method
  * - atomically replaces any old version of the file on the disk with our new file (after first rereading the file from the disk
- * to confirm the hash matches)
+ * to confirm the crc matches)
  * - Some files are super huge so we can't do the full atomic rename/copy (because of filesystem size limits).  If !fullAtomic
  * then we still do the readback to verify file is valid so higher level code can handle failures.
  */
@@ -30,20 +38,26 @@ class SafeFile : public Print
     virtual size_t write(const uint8_t *buffer, size_t size);
 
     /**
-     * Atomically close the file (deleting any old versions) and readback the contents to confirm the hash matches
+     * Atomically close the file (deleting any old versions) and readback the contents to confirm the crc matches
      *
      * @return false for failure
      */
     bool close();
 
   private:
-    /// Read our (closed) tempfile back in and compare the hash
+    /// Read our (closed) tempfile back in and compare the crc
     bool testReadback();
 
+    /// Write out whatever is in our buffer, returns false if the filesystem took less than we gave it
+    bool flushBuffer();
+
     String filename;
     File f;
     bool fullAtomic;
-    uint8_t hash = 0;
+    bool writeFailed = false;
+    uint32_t crc = CRC32_INITIAL;
+    uint16_t bufferUsed = 0;
+    std::unique_ptr<uint8_t[]> buffer; // SAFEFILE_BUFFER_SIZE, until close()
 };
 
 #endif
\ No newline at end of file
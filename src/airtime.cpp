@@ -28,17 +28,97 @@ void AirTime::logAirtime(reportTypes reportType, uint32_t airtime_ms)
     }
 
     // Log all airtime type for channel utilization
-    this->channelUtilization[this->getPeriodUtilMinute()] = channelUtilization[this->getPeriodUtilMinute()] + airtime_ms;
+    uint32_t now = millis();
+    updateSlots();
+    if (reportType == TX_LOG) {
+        // Logged as we start sending, updateSlots() marks it busy as it goes out
+        txCreditedMsec = now;
+        txEndMsec = now + airtime_ms;
+    } else {
+        markBusy(airtime_ms < now ? now - airtime_ms : 0, now);
+    }
 }
 
-uint8_t AirTime::currentPeriodIndex()
+static_assert(AIRTIME_SLOT_MSEC <= 255, "slotBusy is a uint8_t");
+
+const uint16_t AirTime::windowSlots[AIRTIME_WINDOWS] = {AIRTIME_WINDOW_SHORT_MSEC / AIRTIME_SLOT_MSEC,
+                                                         AIRTIME_WINDOW_MEDIUM_MSEC / AIRTIME_SLOT_MSEC, AIRTIME_SLOTS};
+
+void AirTime::updateSlots()
 {
-    return ((getSecondsSinceBoot() / SECONDS_PER_PERIOD) % PERIODS_TO_LOG);
+    uint32_t now = millis();
+    uint32_t nowSlot = now / AIRTIME_SLOT_MSEC;
+
+    if (nowSlot < headSlot || nowSlot - headSlot >= AIRTIME_SLOTS) {
+        // Nothing we have is recent enough (or millis() wrapped)
+        memset(slotBusy, 0, sizeof(slotBusy));
+        memset(windowBusy, 0, sizeof(windowBusy));
+        headSlot = nowSlot;
+    }
+
+    while (headSlot < nowSlot) {
+        headSlot++;
+        // Each window loses its oldest slot. For the full minute that is the slot we are about to reuse.
+        for (int i = 0; i < AIRTIME_WINDOWS; i++) {
+            if (headSlot >= windowSlots[i])
+                windowBusy[i] -= slotBusy[(headSlot - windowSlots[i]) % AIRTIME_SLOTS];
+        }
+        slotBusy[headSlot % AIRTIME_SLOTS] = 0;
+    }
+
+    if ((int32_t)(txEndMsec - txCreditedMsec) > 0) {
+        uint32_t upTo = (int32_t)(txEndMsec - now) > 0 ? now : txEndMsec;
+        markBusy(txCreditedMsec, upTo);
+        txCreditedMsec = upTo;
+    }
+}
+
+void AirTime::markBusy(uint32_t startMsec, uint32_t endMsec)
+{
+    uint32_t oldestMsec = headSlot >= AIRTIME_SLOTS - 1 ? (headSlot - (AIRTIME_SLOTS - 1)) * AIRTIME_SLOT_MSEC : 0;
+    if (startMsec < oldestMsec)
+        startMsec = oldestMsec;
+
+    while (startMsec < endMsec) {
+        uint32_t slot = startMsec / AIRTIME_SLOT_MSEC;
+        if (slot > headSlot)
+            break;
+        uint32_t slotEnd = min(endMsec, (slot + 1) * AIRTIME_SLOT_MSEC);
+
+        // The radio can't hear two packets at once, a slot is never more than completely busy
+        uint8_t &busy = slotBusy[slot % AIRTIME_SLOTS];
+        uint32_t added = min(slotEnd - startMsec, (uint32_t)(AIRTIME_SLOT_MSEC - busy));
+        busy += added;
+        for (int i = 0; i < AIRTIME_WINDOWS; i++) {
+            if (headSlot - slot < windowSlots[i])
+                windowBusy[i] += added;
+        }
+        startMsec = slotEnd;
+    }
 }
 
-uint8_t AirTime::getPeriodUtilMinute()
+float AirTime::busyPercent(uint32_t windowMsec)
 {
-    return (getSecondsSinceBoot() / 10) % CHANNEL_UTILIZATION_PERIODS;
+    updateSlots();
+
+    uint32_t numSlots = constrain(windowMsec / AIRTIME_SLOT_MSEC, 1, AIRTIME_SLOTS);
+    uint32_t sum = 0;
+    int i = 0;
+    while (i < AIRTIME_WINDOWS && windowSlots[i] != numSlots)
+        i++;
+    if (i < AIRTIME_WINDOWS) {
+        sum = windowBusy[i];
+    } else {
+        for (uint32_t age = 0; age < numSlots && age <= headSlot; age++)
+            sum += slotBusy[(headSlot - age) % AIRTIME_SLOTS];
+    }
+
+    return (float(sum) / float(numSlots * AIRTIME_SLOT_MSEC)) * 100;
+}
+
+uint8_t AirTime::currentPeriodIndex()
+{
+    return ((getSecondsSinceBoot() / SECONDS_PER_PERIOD) % PERIODS_TO_LOG);
 }
 
 uint8_t AirTime::getPeriodUtilHour()
@@ -102,12 +182,7 @@ uint32_t AirTime::getSecondsSinceBoot()
 
 float AirTime::channelUtilizationPercent()
 {
-    uint32_t sum = 0;
-    for (uint32_t i = 0; i < CHANNEL_UTILIZATION_PERIODS; i++) {
-        sum += this->channelUtilization[i];
-    }
-
-    return (float(sum) / float(CHANNEL_UTILIZATION_PERIODS * 10 * 1000)) * 100;
+    return busyPercent(AIRTIME_WINDOW_LONG_MSEC);
 }
 
 float AirTime::utilizationTXPercent()
@@ -163,7 +238,6 @@ int32_t AirTime::runOnce()
 {
     secSinceBoot++;
 
-    uint8_t utilPeriod = this->getPeriodUtilMinute();
     uint8_t utilPeriodTX = this->getPeriodUtilHour();
 
     if (firstTime) {
@@ -173,11 +247,6 @@ int32_t AirTime::runOnce()
             this->utilizationTX[i] = 0;
         }
 
-        // Init channelUtilization window to all 0
-        for (uint32_t i = 0; i < CHANNEL_UTILIZATION_PERIODS; i++) {
-            this->channelUtilization[i] = 0;
-        }
-
         // Init airtime windows to all 0
         for (int i = 0; i < PERIODS_TO_LOG; i++) {
             this->airtimes.periodTX[i] = 0;
@@ -189,17 +258,9 @@ int32_t AirTime::runOnce()
         }
 
         firstTime = false;
-        lastUtilPeriod = utilPeriod;
     } else {
         this->airtimeRotatePeriod();
 
-        // Reset the channelUtilization window when we roll over
-        if (lastUtilPeriod != utilPeriod) {
-            lastUtilPeriod = utilPeriod;
-
-            this->channelUtilization[utilPeriod] = 0;
-        }
-
         if (lastUtilPeriodTX != utilPeriodTX) {
             lastUtilPeriodTX = utilPeriodTX;
 
@@ -25,7 +25,18 @@
   RX_ALL_LOG - RX_LOG = Other lora radios on our frequency channel.
 */
 
-#define CHANNEL_UTILIZATION_PERIODS 6
+// Channel busy time is kept in slots of this many msecs, for the last AIRTIME_SLOTS slots (one minute)
+#ifndef AIRTIME_SLOT_MSEC
+#define AIRTIME_SLOT_MSEC 100
+#endif
+#define AIRTIME_SLOTS (60 * 1000 / AIRTIME_SLOT_MSEC)
+
+// Windows we keep a running busy sum for, so asking for them is O(1)
+#define AIRTIME_WINDOWS 3
+#define AIRTIME_WINDOW_SHORT_MSEC 1000
+#define AIRTIME_WINDOW_MEDIUM_MSEC (10 * 1000)
+#define AIRTIME_WINDOW_LONG_MSEC (AIRTIME_SLOTS * AIRTIME_SLOT_MSEC)
+
 #define SECONDS_PER_PERIOD 3600
 #define PERIODS_TO_LOG 8
 #define MINUTES_IN_HOUR 60
@@ -49,8 +60,13 @@ class AirTime : private concurrency::OSThread
     float channelUtilizationPercent();
     float utilizationTXPercent();
 
+    /**
+     * Percentage of the last windowMsec (up to a minute) the channel was busy with anyone's packets, ours included.
+     * AIRTIME_WINDOW_SHORT/MEDIUM/LONG_MSEC are O(1), other windows sum the slots.
+     */
+    float busyPercent(uint32_t windowMsec);
+
     float UtilizationPercentTX();
-    uint32_t channelUtilization[CHANNEL_UTILIZATION_PERIODS] = {0};
     uint32_t utilizationTX[MINUTES_IN_HOUR] = {0};
 
     void airtimeRotatePeriod();
@@ -64,7 +80,6 @@ class AirTime : private concurrency::OSThread
 
   private:
     bool firstTime = true;
-    uint8_t lastUtilPeriod = 0;
     uint8_t lastUtilPeriodTX = 0;
     uint32_t secSinceBoot = 0;
     uint8_t max_channel_util_percent = 40;
@@ -78,7 +93,23 @@ class AirTime : private concurrency::OSThread
         uint8_t lastPeriodIndex;
     } airtimes;
 
-    uint8_t getPeriodUtilMinute();
+    /**
+     * Busy msecs per AIRTIME_SLOT_MSEC slot, a ring indexed by (millis() / AIRTIME_SLOT_MSEC) % AIRTIME_SLOTS.
+     * Received packets are logged when they end, so we fill the slots before now.  Our own packets are logged when they start,
+     * they fill the slots as time passes (until txEndMsec).
+     */
+    uint8_t slotBusy[AIRTIME_SLOTS] = {0};
+    uint32_t headSlot = 0;                      // slot number of now, as of the last update
+    uint32_t windowBusy[AIRTIME_WINDOWS] = {0}; // running sum of the last windowSlots[i] slots
+    uint32_t txCreditedMsec = 0, txEndMsec = 0; // the part of our current transmission not in the slots yet
+
+    static const uint16_t windowSlots[AIRTIME_WINDOWS];
+
+    /// Move the ring up to now and add any of our transmission that has happened since
+    void updateSlots();
+    /// Mark [startMsec, endMsec) as busy, only the part inside the ring counts
+    void markBusy(uint32_t startMsec, uint32_t endMsec);
+
     uint8_t getPeriodUtilHour();
     uint8_t currentPeriodIndex();
 
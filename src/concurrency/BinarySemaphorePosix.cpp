@@ -3,9 +3,60 @@
 
 #ifndef HAS_FREE_RTOS
 
+#ifdef ARCH_PORTDUINO
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#endif
+
 namespace concurrency
 {
 
+#ifdef ARCH_PORTDUINO
+// Our "ISRs" and the web server's request threads are real pthreads here, and they wake the main loop through mainDelay
+struct PosixSemaphoreState {
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool given = false;
+};
+
+BinarySemaphorePosix::BinarySemaphorePosix() : state(new PosixSemaphoreState()) {}
+
+BinarySemaphorePosix::~BinarySemaphorePosix()
+{
+    delete (PosixSemaphoreState *)state;
+}
+
+/**
+ * Returns false if we timed out
+ */
+bool BinarySemaphorePosix::take(uint32_t msec)
+{
+    PosixSemaphoreState *s = (PosixSemaphoreState *)state;
+    std::unique_lock<std::mutex> lock(s->mutex);
+    if (msec == portMAX_DELAY)
+        s->cond.wait(lock, [s] { return s->given; });
+    else if (!s->cond.wait_for(lock, std::chrono::milliseconds(msec), [s] { return s->given; }))
+        return false;
+    s->given = false;
+    return true;
+}
+
+void BinarySemaphorePosix::give()
+{
+    PosixSemaphoreState *s = (PosixSemaphoreState *)state;
+    {
+        std::lock_guard<std::mutex> lock(s->mutex);
+        s->given = true;
+    }
+    s->cond.notify_one();
+}
+
+void BinarySemaphorePosix::giveFromISR(BaseType_t *pxHigherPriorityTaskWoken)
+{
+    give();
+}
+#else
 BinarySemaphorePosix::BinarySemaphorePosix() {}
 
 BinarySemaphorePosix::~BinarySemaphorePosix() {}
@@ -22,6 +73,7 @@ bool BinarySemaphorePosix::take(uint32_t msec)
 void BinarySemaphorePosix::give() {}
 
 IRAM_ATTR void BinarySemaphorePosix::giveFromISR(BaseType_t *pxHigherPriorityTaskWoken) {}
+#endif
 
 } // namespace concurrency
 
@@ -10,6 +10,7 @@ namespace concurrency
 class BinarySemaphorePosix
 {
     // SemaphoreHandle_t semaphore;
+    void *state = NULL; // mutex, condition variable and flag on portduino
 
   public:
     BinarySemaphorePosix();
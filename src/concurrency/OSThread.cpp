@@ -37,14 +37,37 @@ OSThread::OSThread(const char *_name, uint32_t period, ThreadController *_contro
         bool added = controller->add(this);
         assert(added);
     }
+
+    // The main loop only runs threads through mainScheduler, mainController is kept so the thread list can be walked
+    if (controller == &mainController) {
+        scheduled = true;
+        mainScheduler.add(this);
+    }
 }
 
 OSThread::~OSThread()
 {
+    if (scheduled)
+        mainScheduler.remove(this);
     if (controller)
         controller->remove(this);
 }
 
+void OSThread::scheduleChanged()
+{
+    // While we are in our own runOnce() the scheduler will reschedule us once we return
+    if (scheduled && currentThread != this) {
+        scheduleDirty = true;
+        mainScheduler.markDirty();
+    }
+}
+
+void OSThread::setInterval(unsigned long _interval)
+{
+    Thread::setInterval(_interval);
+    scheduleChanged();
+}
+
 /**
  * Wait a specified number msecs starting from the current time (rather than the last time we were run)
  */
@@ -55,6 +78,8 @@ void OSThread::setIntervalFromNow(unsigned long _interval)
 
     // Cache the next run based on the last_run
     _cached_next_run = millis() + interval;
+
+    scheduleChanged();
 }
 
 bool OSThread::shouldRun(unsigned long time)
@@ -82,7 +107,22 @@ void OSThread::run()
     auto heap = memGet.getFreeHeap();
 #endif
     currentThread = this;
+
+    int32_t late = -msecUntilRun(millis());
+    if (late > 0) {
+        stats.totalLatencyMsec += late;
+        if ((uint32_t)late > stats.maxLatencyMsec)
+            stats.maxLatencyMsec = late;
+    }
+    uint32_t start = micros();
+
     auto newDelay = runOnce();
+
+    uint32_t runTime = micros() - start;
+    stats.runTimeUs += runTime;
+    if (runTime > stats.maxRunTimeUs)
+        stats.maxRunTimeUs = runTime;
+    stats.runCount++;
 #ifdef DEBUG_HEAP
     auto newHeap = memGet.getFreeHeap();
     if (newHeap < heap)
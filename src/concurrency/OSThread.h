@@ -6,6 +6,7 @@
 #include "Thread.h"
 #include "ThreadController.h"
 #include "concurrency/InterruptableDelay.h"
+#include "concurrency/Scheduler.h"
 
 namespace concurrency
 {
@@ -30,8 +31,25 @@ extern InterruptableDelay mainDelay;
  */
 class OSThread : public Thread
 {
+    friend class Scheduler;
+
     ThreadController *controller;
 
+    /// Whether we were added to mainScheduler
+    bool scheduled = false;
+
+    /// Our position in the scheduler heap (-1 if not in the heap)
+    int32_t heapIndex = -1;
+
+    /// When the scheduler wants to run us next (in Scheduler time)
+    uint64_t deadline = 0;
+
+    /// Set when our schedule was changed from outside our own runOnce (maybe from an ISR)
+    volatile bool scheduleDirty = false;
+
+    /// We became due while disabled, the scheduler is waiting for us to be enabled again
+    bool isParked = false;
+
     /// Show debugging info for disabled threads
     static bool showDisabled;
 
@@ -42,6 +60,15 @@ class OSThread : public Thread
     static bool showWaiting;
 
   public:
+    /// Run statistics, maintained by run(). Cheap enough (two micros() calls per run) to always be on.
+    struct Stats {
+        uint32_t runCount = 0;         // number of runOnce() calls
+        uint64_t runTimeUs = 0;        // total time spent in runOnce()
+        uint32_t maxRunTimeUs = 0;     // longest single runOnce()
+        uint32_t maxLatencyMsec = 0;   // worst delay between when we wanted to run and when we actually ran
+        uint64_t totalLatencyMsec = 0; // sum of those delays
+    };
+
     /// For debug printing only (might be null)
     static const OSThread *currentThread;
 
@@ -60,6 +87,16 @@ class OSThread : public Thread
      */
     void setIntervalFromNow(unsigned long _interval);
 
+    /**
+     * Same as Thread::setInterval, but also lets the scheduler know our deadline changed
+     */
+    void setInterval(unsigned long _interval);
+
+    /// Number of msecs until we want to run (negative if we are overdue)
+    int32_t msecUntilRun(unsigned long time) const { return (int32_t)(_cached_next_run - time); }
+
+    const Stats &getStats() const { return stats; }
+
   protected:
     /**
      * The method that will be called each time our thread gets a chance to run
@@ -71,6 +108,12 @@ class OSThread : public Thread
 
     // Do not override this
     virtual void run();
+
+  private:
+    Stats stats;
+
+    /// Tell the scheduler about a schedule change, unless it will find out anyway because we are running
+    void scheduleChanged();
 };
 
 /**
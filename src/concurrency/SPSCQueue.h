@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <type_traits>
+
+#include "concurrency/OSThread.h"
+
+namespace concurrency
+{
+
+/**
+ * A bounded, lock-free, single-producer/single-consumer ring buffer.
+ *
+ * One context (the radio ISR or the main loop) may enqueue while another (a reader OSThread) dequeues, without any locking.
+ * Only atomic loads and stores are used, so this also works on cores without atomic read-modify-write (e.g. Cortex-M0+).
+ *
+ * Elements are copied by value, so T should be small and POD (normally a pointer).  When the queue is full new elements
+ * are rejected (the producer can't safely drop the oldest) and counted in getDropped().
+ */
+template <class T> class SPSCQueue
+{
+    static_assert(std::is_standard_layout<T>::value, "T must be standard layout");
+
+    T *buf;
+    uint32_t mask;                 // capacity - 1, capacity is a power of two
+    std::atomic<uint32_t> head{0}; // next slot to write, only written by the producer
+    std::atomic<uint32_t> tail{0}; // next slot to read, only written by the consumer
+    std::atomic<uint32_t> dropped{0};
+    uint32_t highWater = 0; // producer side only
+    OSThread *reader = NULL;
+
+    static uint32_t roundUpPow2(uint32_t n)
+    {
+        uint32_t r = 1;
+        while (r < n)
+            r <<= 1;
+        return r;
+    }
+
+    bool push(const T &x)
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t used = h - tail.load(std::memory_order_acquire);
+        if (used > mask) {
+            // Only the producer writes dropped, so a plain load/store is enough (no atomic RMW needed)
+            dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        buf[h & mask] = x;
+        head.store(h + 1, std::memory_order_release);
+        if (used + 1 > highWater)
+            highWater = used + 1;
+        return true;
+    }
+
+  public:
+    explicit SPSCQueue(uint32_t maxElements) : mask(roundUpPow2(maxElements ? maxElements : 1) - 1)
+    {
+        buf = new T[mask + 1];
+    }
+
+    ~SPSCQueue() { delete[] buf; }
+
+    SPSCQueue(const SPSCQueue &) = delete;
+    SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+    /// Number of elements this queue can hold
+    uint32_t capacity() const { return mask + 1; }
+
+    int numUsed() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+
+    int numFree() const { return capacity() - numUsed(); }
+
+    bool isEmpty() const { return numUsed() == 0; }
+
+    /// Number of elements rejected because the queue was full
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    /// Most elements that were ever queued at the same time
+    uint32_t getHighWater() const { return highWater; }
+
+    /**
+     * Enqueue an element, from the producer context. Returns false (and counts a drop) if the queue is full.
+     */
+    bool enqueue(const T &x)
+    {
+        bool ok = push(x);
+        if (ok && reader) {
+            reader->setInterval(0);
+            mainDelay.interrupt();
+        }
+        return ok;
+    }
+
+#ifdef HAS_FREE_RTOS
+    /**
+     * Enqueue an element from an ISR
+     */
+    bool enqueueFromISR(const T &x, BaseType_t *higherPriWoken)
+    {
+        bool ok = push(x);
+        if (ok && reader) {
+            reader->setInterval(0);
+            mainDelay.interruptFromISR(higherPriWoken);
+        }
+        return ok;
+    }
+#endif
+
+    /**
+     * Dequeue an element, from the consumer context. Returns false if the queue was empty.
+     */
+    bool dequeue(T *p)
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+            return false;
+        *p = buf[t & mask];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Set the thread that is reading from this queue, it will be scheduled to run ASAP whenever an element is enqueued.
+     *
+     * Note: thread will not be automatically enabled, just have its interval set to 0
+     */
+    void setReader(OSThread *t) { reader = t; }
+};
+
+} // namespace concurrency
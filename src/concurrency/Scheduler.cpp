@@ -0,0 +1,176 @@
+#include "concurrency/Scheduler.h"
+#include "concurrency/OSThread.h"
+#include "configuration.h"
+#include <algorithm>
+
+namespace concurrency
+{
+
+Scheduler mainScheduler;
+
+void Scheduler::add(OSThread *thread)
+{
+    threads.push_back(thread);
+    updateNow();
+    reschedule(thread);
+}
+
+void Scheduler::remove(OSThread *thread)
+{
+    threads.erase(std::remove(threads.begin(), threads.end(), thread), threads.end());
+    parked.erase(std::remove(parked.begin(), parked.end(), thread), parked.end());
+    // Might be removed while we are running due threads, don't touch it after this
+    std::replace(due.begin(), due.end(), thread, (OSThread *)NULL);
+    if (thread->heapIndex >= 0)
+        heapRemove(thread->heapIndex);
+    thread->isParked = false;
+}
+
+void Scheduler::updateNow()
+{
+    uint32_t ms = millis();
+    now += (uint32_t)(ms - lastMillis); // handles 32 bit millis() wraparound
+    lastMillis = ms;
+}
+
+void Scheduler::reschedule(OSThread *thread)
+{
+    if (thread->isParked)
+        return; // will be put back in the heap once enabled
+
+    thread->deadline = now + thread->msecUntilRun(lastMillis);
+    if (thread->heapIndex < 0) {
+        heap.push_back(thread);
+        heapSet(heap.size() - 1, thread);
+        siftUp(thread->heapIndex);
+    } else {
+        siftUp(thread->heapIndex);
+        siftDown(thread->heapIndex);
+    }
+}
+
+void Scheduler::processDirty()
+{
+    if (!dirty)
+        return;
+
+    dirty = false;
+    for (auto thread : threads) {
+        if (thread->scheduleDirty) {
+            // Clear before reading the new schedule, so a concurrent change just flags us again
+            thread->scheduleDirty = false;
+            reschedule(thread);
+        }
+    }
+}
+
+int32_t Scheduler::runOrDelay()
+{
+    updateNow();
+    processDirty();
+
+    // Threads that were enabled behind our back go back into the heap
+    for (size_t i = 0; i < parked.size();) {
+        OSThread *thread = parked[i];
+        if (thread->enabled) {
+            parked[i] = parked.back();
+            parked.pop_back();
+            thread->isParked = false;
+            reschedule(thread);
+        } else {
+            i++;
+        }
+    }
+
+    // Take everything that is due out of the heap first, so a thread that asks to run again immediately only runs once
+    // per pass (same as the old polling controller)
+    while (!heap.empty() && heap[0]->deadline <= now) {
+        OSThread *thread = heap[0];
+        heapRemove(0);
+        if (thread->enabled) {
+            due.push_back(thread);
+        } else {
+            thread->isParked = true;
+            parked.push_back(thread);
+        }
+    }
+
+    for (size_t i = 0; i < due.size(); i++) {
+        OSThread *thread = due[i];
+        if (!thread)
+            continue; // removed by an earlier thread in this pass
+
+        thread->run();
+
+        if (due[i]) { // a thread might delete itself
+            thread->scheduleDirty = false;
+            updateNow();
+            reschedule(thread);
+        }
+        processDirty();
+    }
+    due.clear();
+
+    updateNow();
+    processDirty();
+    if (heap.empty())
+        return INT32_MAX;
+
+    int64_t delay = (int64_t)(heap[0]->deadline - now);
+    if (heap[0]->deadline <= now)
+        delay = 0;
+    return delay > INT32_MAX ? INT32_MAX : (int32_t)delay;
+}
+
+void Scheduler::heapSet(int32_t index, OSThread *thread)
+{
+    heap[index] = thread;
+    thread->heapIndex = index;
+}
+
+void Scheduler::heapRemove(int32_t index)
+{
+    OSThread *removed = heap[index];
+    OSThread *last = heap.back();
+    heap.pop_back();
+    removed->heapIndex = -1;
+
+    if (index < (int32_t)heap.size()) {
+        heapSet(index, last);
+        siftUp(index);
+        siftDown(last->heapIndex);
+    }
+}
+
+void Scheduler::siftUp(int32_t index)
+{
+    OSThread *thread = heap[index];
+    while (index > 0) {
+        int32_t parent = (index - 1) / 2;
+        if (heap[parent]->deadline <= thread->deadline)
+            break;
+        heapSet(index, heap[parent]);
+        index = parent;
+    }
+    heapSet(index, thread);
+}
+
+void Scheduler::siftDown(int32_t index)
+{
+    OSThread *thread = heap[index];
+    int32_t size = heap.size();
+    for (;;) {
+        int32_t child = 2 * index + 1;
+        if (child >= size)
+            break;
+        if (child + 1 < size && heap[child + 1]->deadline < heap[child]->deadline)
+            child++;
+        if (thread->deadline <= heap[child]->deadline)
+            break;
+        heapSet(index, heap[child]);
+        index = child;
+    }
+    heapSet(index, thread);
+}
+
+} // namespace concurrency
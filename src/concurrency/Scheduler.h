@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace concurrency
+{
+
+class OSThread;
+
+/**
+ * @brief Tickless scheduler for OSThreads
+ *
+ * Threads are kept in a min-heap keyed by their next run time, so finding the next thread to run (and how long the main loop
+ * may sleep) is O(log n) instead of asking every thread whether it wants to run.
+ *
+ * Threads still change their own schedule with setInterval()/setIntervalFromNow() and flip their enabled flag, possibly from
+ * an ISR or another task.  Those paths only set a flag (see markDirty()), the heap itself is only ever touched from the main
+ * loop.  Threads that become due while disabled are parked outside of the heap until they are enabled again.
+ */
+class Scheduler
+{
+  public:
+    void add(OSThread *thread);
+    void remove(OSThread *thread);
+
+    /**
+     * Run all threads that are due, then return the number of msecs until the earliest deadline (which is how long the
+     * main loop may sleep on mainDelay).
+     */
+    int32_t runOrDelay();
+
+    /// Note that a thread changed its schedule outside of the main loop. Safe to call from an ISR.
+    void markDirty() { dirty = true; }
+
+    /// Number of threads we know about
+    size_t size() const { return threads.size(); }
+
+    /// Get a registered thread (for stats and debug printing), or NULL if out of range
+    OSThread *get(size_t index) const { return index < threads.size() ? threads[index] : NULL; }
+
+  private:
+    /// All registered threads
+    std::vector<OSThread *> threads;
+
+    /// Binary min-heap of threads ordered by deadline
+    std::vector<OSThread *> heap;
+
+    /// Threads that became due while disabled
+    std::vector<OSThread *> parked;
+
+    /// Threads being run by the current pass
+    std::vector<OSThread *> due;
+
+    /// Set when some thread changed its schedule from outside the main loop
+    volatile bool dirty = false;
+
+    /// millis() extended to 64 bits, so deadlines can be compared without worrying about wraparound
+    uint64_t now = 0;
+    uint32_t lastMillis = 0;
+
+    void updateNow();
+
+    /// Recompute the deadline of a thread and put it in the right place in the heap
+    void reschedule(OSThread *thread);
+
+    /// Reschedule all threads flagged by setInterval() from outside the main loop
+    void processDirty();
+
+    void heapRemove(int32_t index);
+    void siftUp(int32_t index);
+    void siftDown(int32_t index);
+    void heapSet(int32_t index, OSThread *thread);
+};
+
+extern Scheduler mainScheduler;
+
+} // namespace concurrency
@@ -2,7 +2,13 @@
 
 #if !MESHTASTIC_EXCLUDE_I2C
 
+#include "SafeFile.h"
 #include "concurrency/LockGuard.h"
+#include <assert.h>
+#include <string.h>
+#if defined(ARCH_ESP32) && WIRE_INTERFACES_COUNT == 2
+#include "concurrency/BinarySemaphoreFreeRTOS.h"
+#endif
 #if defined(ARCH_PORTDUINO)
 #include "linux/LinuxHardwareI2C.h"
 #endif
@@ -10,6 +16,12 @@
 #include "meshUtils.h" // vformat
 #endif
 
+// The devices found last boot, if the same addresses answer we skip identifying them again
+#define I2C_SCAN_CACHE_FILE "/prefs/i2c.dat"
+#define I2C_SCAN_CACHE_MAGIC 0x49324331 // "I2C1"
+// How long one address may hold up the scan, e.g. when a bus has no pull-ups
+#define I2C_SCAN_PROBE_TIMEOUT_MSEC 10
+
 // AXP192 and AXP2101 have the same device address, we just need to identify it in Power.cpp
 #ifndef XPOWERS_AXP192_AXP2101_ADDRESS
 #define XPOWERS_AXP192_AXP2101_ADDRESS 0x34
@@ -110,31 +122,18 @@ uint16_t ScanI2CTwoWire::getRegisterValue(const ScanI2CTwoWire::RegisterLocation
         type = T;                                                                                                                \
         break;
 
-void ScanI2CTwoWire::scanPort(I2CPort port, uint8_t *address, uint8_t asize)
+/// Which of the 112 usable addresses answer on this bus (only those in address[] if asize isn't 0)
+ScanI2CTwoWire::AddressSet ScanI2CTwoWire::probePort(I2CPort port, uint8_t *address, uint8_t asize) const
 {
-    concurrency::LockGuard guard((concurrency::Lock *)&lock);
-
-    LOG_DEBUG("Scan for I2C devices on port %d", port);
-
-    uint8_t err;
-
+    AddressSet present;
     DeviceAddress addr(port, 0x00);
+    TwoWire *i2cBus = fetchI2CBus(addr);
+    uint8_t err;
 
-    uint16_t registerValue = 0x00;
-    ScanI2C::DeviceType type;
-    TwoWire *i2cBus;
-#ifdef RV3028_RTC
-    Melopero_RV3028 rtc;
-#endif
-
-#if WIRE_INTERFACES_COUNT == 2
-    if (port == I2CPort::WIRE1) {
-        i2cBus = &Wire1;
-    } else {
-#endif
-        i2cBus = &Wire;
-#if WIRE_INTERFACES_COUNT == 2
-    }
+#ifdef ARCH_ESP32
+    // Without pull-ups every address would wait out the default timeout
+    uint16_t timeOut = i2cBus->getTimeOut();
+    i2cBus->setTimeOut(I2C_SCAN_PROBE_TIMEOUT_MSEC);
 #endif
 
     // We only need to scan 112 addresses, the rest is reserved for special purposes
@@ -161,294 +160,512 @@ void ScanI2CTwoWire::scanPort(I2CPort port, uint8_t *address, uint8_t asize)
 #else
         err = i2cBus->endTransmission();
 #endif
-        type = NONE;
         if (err == 0) {
-            switch (addr.address) {
-            case SSD1306_ADDRESS:
-                type = probeOLED(addr);
-                break;
+            present.set(addr.address);
+        } else if (err == 4) {
+            LOG_ERROR("Unknown error at address 0x%x", (uint8_t)addr.address);
+        }
+    }
+
+#ifdef ARCH_ESP32
+    i2cBus->setTimeOut(timeOut);
+#endif
+    return present;
+}
+
+#if defined(ARCH_ESP32) && WIRE_INTERFACES_COUNT == 2
+namespace
+{
+struct PortSweep {
+    const ScanI2CTwoWire *scanner;
+    ScanI2C::I2CPort port;
+    std::bitset<128> present;
+    concurrency::BinarySemaphoreFreeRTOS done;
+};
+} // namespace
+#endif
+
+void ScanI2CTwoWire::probePorts(const I2CPort *ports, size_t count, AddressSet *present) const
+{
+#if defined(ARCH_ESP32) && WIRE_INTERFACES_COUNT == 2
+    if (count == 2) {
+        // Wire and Wire1 are separate controllers, so sweep the second one from the other core meanwhile
+        PortSweep sweep;
+        sweep.scanner = this;
+        sweep.port = ports[1];
+        xTaskCreatePinnedToCore(
+            [](void *arg) {
+                PortSweep *sweep = (PortSweep *)arg;
+                sweep->present = sweep->scanner->probePort(sweep->port, nullptr, 0);
+                sweep->done.give();
+                vTaskDelete(NULL);
+            },
+            "i2cscan", 3 * 1024, &sweep, tskIDLE_PRIORITY + 1, NULL, 0);
+        present[0] = probePort(ports[0], nullptr, 0);
+        while (!sweep.done.take(1000))
+            ; // it's on our stack, no leaving before it's done
+        present[1] = sweep.present;
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; i++)
+        present[i] = probePort(ports[i], nullptr, 0);
+}
 
 #ifdef RV3028_RTC
-            case RV3028_RTC:
-                // foundDevices[addr] = RTC_RV3028;
-                type = RTC_RV3028;
-                logFoundDevice("RV3028", (uint8_t)addr.address);
-                rtc.initI2C(*i2cBus);
-                rtc.writeToRegister(0x35, 0x07); // no Clkout
-                rtc.writeToRegister(0x37, 0xB4);
-                break;
+void ScanI2CTwoWire::setupRV3028(ScanI2C::DeviceAddress addr) const
+{
+    Melopero_RV3028 rtc;
+    rtc.initI2C(*fetchI2CBus(addr));
+    rtc.writeToRegister(0x35, 0x07); // no Clkout
+    rtc.writeToRegister(0x37, 0xB4);
+}
+#endif
+
+/// What the device at this (answering) address is, NONE if we don't know
+ScanI2C::DeviceType ScanI2CTwoWire::identify(ScanI2C::DeviceAddress addr) const
+{
+    uint16_t registerValue = 0x00;
+    ScanI2C::DeviceType type = NONE;
+
+    switch (addr.address) {
+    case SSD1306_ADDRESS:
+        type = probeOLED(addr);
+        break;
+
+#ifdef RV3028_RTC
+    case RV3028_RTC:
+        // foundDevices[addr] = RTC_RV3028;
+        type = RTC_RV3028;
+        logFoundDevice("RV3028", (uint8_t)addr.address);
+        setupRV3028(addr);
+        break;
 #endif
 
 #ifdef PCF8563_RTC
-                SCAN_SIMPLE_CASE(PCF8563_RTC, RTC_PCF8563, "PCF8563", (uint8_t)addr.address)
+        SCAN_SIMPLE_CASE(PCF8563_RTC, RTC_PCF8563, "PCF8563", (uint8_t)addr.address)
 #endif
 
-            case CARDKB_ADDR:
-                // Do we have the RAK14006 instead?
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x04), 1);
-                if (registerValue == 0x02) {
-                    // KEYPAD_VERSION
-                    logFoundDevice("RAK14004", (uint8_t)addr.address);
-                    type = RAK14004;
-                } else {
-                    logFoundDevice("M5 cardKB", (uint8_t)addr.address);
-                    type = CARDKB;
-                }
-                break;
+    case CARDKB_ADDR:
+        // Do we have the RAK14006 instead?
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x04), 1);
+        if (registerValue == 0x02) {
+            // KEYPAD_VERSION
+            logFoundDevice("RAK14004", (uint8_t)addr.address);
+            type = RAK14004;
+        } else {
+            logFoundDevice("M5 cardKB", (uint8_t)addr.address);
+            type = CARDKB;
+        }
+        break;
 
-                SCAN_SIMPLE_CASE(TDECK_KB_ADDR, TDECKKB, "T-Deck keyboard", (uint8_t)addr.address);
-                SCAN_SIMPLE_CASE(BBQ10_KB_ADDR, BBQ10KB, "BB Q10", (uint8_t)addr.address);
+        SCAN_SIMPLE_CASE(TDECK_KB_ADDR, TDECKKB, "T-Deck keyboard", (uint8_t)addr.address);
+        SCAN_SIMPLE_CASE(BBQ10_KB_ADDR, BBQ10KB, "BB Q10", (uint8_t)addr.address);
 
-                SCAN_SIMPLE_CASE(ST7567_ADDRESS, SCREEN_ST7567, "ST7567", (uint8_t)addr.address);
+        SCAN_SIMPLE_CASE(ST7567_ADDRESS, SCREEN_ST7567, "ST7567", (uint8_t)addr.address);
 #ifdef HAS_NCP5623
-                SCAN_SIMPLE_CASE(NCP5623_ADDR, NCP5623, "NCP5623", (uint8_t)addr.address);
+        SCAN_SIMPLE_CASE(NCP5623_ADDR, NCP5623, "NCP5623", (uint8_t)addr.address);
 #endif
 #ifdef HAS_PMU
-                SCAN_SIMPLE_CASE(XPOWERS_AXP192_AXP2101_ADDRESS, PMU_AXP192_AXP2101, "AXP192/AXP2101", (uint8_t)addr.address)
+        SCAN_SIMPLE_CASE(XPOWERS_AXP192_AXP2101_ADDRESS, PMU_AXP192_AXP2101, "AXP192/AXP2101", (uint8_t)addr.address)
 #endif
-            case BME_ADDR:
-            case BME_ADDR_ALTERNATE:
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0xD0), 1); // GET_ID
-                switch (registerValue) {
-                case 0x61:
-                    logFoundDevice("BME680", (uint8_t)addr.address);
-                    type = BME_680;
-                    break;
-                case 0x60:
-                    logFoundDevice("BME280", (uint8_t)addr.address);
-                    type = BME_280;
-                    break;
-                case 0x55:
-                    logFoundDevice("BMP085/BMP180", (uint8_t)addr.address);
-                    type = BMP_085;
-                    break;
-                default:
-                    registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x00), 1); // GET_ID
-                    switch (registerValue) {
-                    case 0x50: // BMP-388 should be 0x50
-                        logFoundDevice("BMP-388", (uint8_t)addr.address);
-                        type = BMP_3XX;
-                        break;
-                    case 0x58: // BMP-280 should be 0x58
-                    default:
-                        logFoundDevice("BMP-280", (uint8_t)addr.address);
-                        type = BMP_280;
-                        break;
-                    }
-                    break;
-                }
+    case BME_ADDR:
+    case BME_ADDR_ALTERNATE:
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0xD0), 1); // GET_ID
+        switch (registerValue) {
+        case 0x61:
+            logFoundDevice("BME680", (uint8_t)addr.address);
+            type = BME_680;
+            break;
+        case 0x60:
+            logFoundDevice("BME280", (uint8_t)addr.address);
+            type = BME_280;
+            break;
+        case 0x55:
+            logFoundDevice("BMP085/BMP180", (uint8_t)addr.address);
+            type = BMP_085;
+            break;
+        default:
+            registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x00), 1); // GET_ID
+            switch (registerValue) {
+            case 0x50: // BMP-388 should be 0x50
+                logFoundDevice("BMP-388", (uint8_t)addr.address);
+                type = BMP_3XX;
                 break;
-#ifndef HAS_NCP5623
-            case AHT10_ADDR:
-                logFoundDevice("AHT10", (uint8_t)addr.address);
-                type = AHT10;
+            case 0x58: // BMP-280 should be 0x58
+            default:
+                logFoundDevice("BMP-280", (uint8_t)addr.address);
+                type = BMP_280;
                 break;
+            }
+            break;
+        }
+        break;
+#ifndef HAS_NCP5623
+    case AHT10_ADDR:
+        logFoundDevice("AHT10", (uint8_t)addr.address);
+        type = AHT10;
+        break;
 #endif
-            case INA_ADDR:
-            case INA_ADDR_ALTERNATE:
-            case INA_ADDR_WAVESHARE_UPS:
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0xFE), 2);
-                LOG_DEBUG("Register MFG_UID: 0x%x", registerValue);
-                if (registerValue == 0x5449) {
-                    logFoundDevice("INA260", (uint8_t)addr.address);
-                    type = INA260;
-                } else { // Assume INA219 if INA260 ID is not found
-                    logFoundDevice("INA219", (uint8_t)addr.address);
-                    type = INA219;
-                }
-                break;
-            case INA3221_ADDR:
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0xFE), 2);
-                LOG_DEBUG("Register MFG_UID FE: 0x%x", registerValue);
-                if (registerValue == 0x5449) {
-                    logFoundDevice("INA3221", (uint8_t)addr.address);
-                    type = INA3221;
-                } else {
-                    /* check the first 2 bytes of the 6 byte response register
-                    LARK FW 1.0 should return:
-                    RESPONSE_STATUS STATUS_SUCCESS (0x53)
-                    RESPONSE_CMD CMD_GET_VERSION (0x05)
-                    RESPONSE_LEN_L 0x02
-                    RESPONSE_LEN_H 0x00
-                    RESPONSE_PAYLOAD 0x01
-                    RESPONSE_PAYLOAD+1 0x00
-                    */
-                    registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x05), 2);
-                    LOG_DEBUG("Register MFG_UID 05: 0x%x", registerValue);
-                    if (registerValue == 0x5305) {
-                        logFoundDevice("DFRobot Lark", (uint8_t)addr.address);
-                        type = DFROBOT_LARK;
-                    }
-                    // else: probably a RAK12500/UBLOX GPS on I2C
-                }
-                break;
-            case MCP9808_ADDR:
-                // We need to check for STK8BAXX first, since register 0x07 is new data flag for the z-axis and can produce some
-                // weird result. and register 0x00 doesn't seems to be colliding with MCP9808 and LIS3DH chips.
-                {
+    case INA_ADDR:
+    case INA_ADDR_ALTERNATE:
+    case INA_ADDR_WAVESHARE_UPS:
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0xFE), 2);
+        LOG_DEBUG("Register MFG_UID: 0x%x", registerValue);
+        if (registerValue == 0x5449) {
+            logFoundDevice("INA260", (uint8_t)addr.address);
+            type = INA260;
+        } else { // Assume INA219 if INA260 ID is not found
+            logFoundDevice("INA219", (uint8_t)addr.address);
+            type = INA219;
+        }
+        break;
+    case INA3221_ADDR:
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0xFE), 2);
+        LOG_DEBUG("Register MFG_UID FE: 0x%x", registerValue);
+        if (registerValue == 0x5449) {
+            logFoundDevice("INA3221", (uint8_t)addr.address);
+            type = INA3221;
+        } else {
+            /* check the first 2 bytes of the 6 byte response register
+            LARK FW 1.0 should return:
+            RESPONSE_STATUS STATUS_SUCCESS (0x53)
+            RESPONSE_CMD CMD_GET_VERSION (0x05)
+            RESPONSE_LEN_L 0x02
+            RESPONSE_LEN_H 0x00
+            RESPONSE_PAYLOAD 0x01
+            RESPONSE_PAYLOAD+1 0x00
+            */
+            registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x05), 2);
+            LOG_DEBUG("Register MFG_UID 05: 0x%x", registerValue);
+            if (registerValue == 0x5305) {
+                logFoundDevice("DFRobot Lark", (uint8_t)addr.address);
+                type = DFROBOT_LARK;
+            }
+            // else: probably a RAK12500/UBLOX GPS on I2C
+        }
+        break;
+    case MCP9808_ADDR:
+        // We need to check for STK8BAXX first, since register 0x07 is new data flag for the z-axis and can produce some
+        // weird result. and register 0x00 doesn't seems to be colliding with MCP9808 and LIS3DH chips.
+        {
 #ifdef HAS_STK8XXX
-                    // Check register 0x00 for 0x8700 response to ID STK8BA53 chip.
-                    registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x00), 2);
-                    if (registerValue == 0x8700) {
-                        type = STK8BAXX;
-                        logFoundDevice("STK8BAXX", (uint8_t)addr.address);
-                        break;
-                    }
+            // Check register 0x00 for 0x8700 response to ID STK8BA53 chip.
+            registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x00), 2);
+            if (registerValue == 0x8700) {
+                type = STK8BAXX;
+                logFoundDevice("STK8BAXX", (uint8_t)addr.address);
+                break;
+            }
 #endif
 
-                    // Check register 0x07 for 0x0400 response to ID MCP9808 chip.
-                    registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x07), 2);
-                    if (registerValue == 0x0400) {
-                        type = MCP9808;
-                        logFoundDevice("MCP9808", (uint8_t)addr.address);
-                        break;
-                    }
+            // Check register 0x07 for 0x0400 response to ID MCP9808 chip.
+            registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x07), 2);
+            if (registerValue == 0x0400) {
+                type = MCP9808;
+                logFoundDevice("MCP9808", (uint8_t)addr.address);
+                break;
+            }
 
-                    // Check register 0x0F for 0x3300 response to ID LIS3DH chip.
-                    registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x0F), 2);
-                    if (registerValue == 0x3300 || registerValue == 0x3333) { // RAK4631 WisBlock has LIS3DH register at 0x3333
-                        type = LIS3DH;
-                        logFoundDevice("LIS3DH", (uint8_t)addr.address);
-                    }
-                    break;
-                }
-            case SHT31_4x_ADDR:
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x89), 2);
-                if (registerValue == 0x11a2 || registerValue == 0x11da || registerValue == 0xe9c) {
-                    type = SHT4X;
-                    logFoundDevice("SHT4X", (uint8_t)addr.address);
-                } else if (getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x7E), 2) == 0x5449) {
-                    type = OPT3001;
-                    logFoundDevice("OPT3001", (uint8_t)addr.address);
-                } else {
-                    type = SHT31;
-                    logFoundDevice("SHT31", (uint8_t)addr.address);
-                }
+            // Check register 0x0F for 0x3300 response to ID LIS3DH chip.
+            registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x0F), 2);
+            if (registerValue == 0x3300 || registerValue == 0x3333) { // RAK4631 WisBlock has LIS3DH register at 0x3333
+                type = LIS3DH;
+                logFoundDevice("LIS3DH", (uint8_t)addr.address);
+            }
+            break;
+        }
+    case SHT31_4x_ADDR:
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x89), 2);
+        if (registerValue == 0x11a2 || registerValue == 0x11da || registerValue == 0xe9c) {
+            type = SHT4X;
+            logFoundDevice("SHT4X", (uint8_t)addr.address);
+        } else if (getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x7E), 2) == 0x5449) {
+            type = OPT3001;
+            logFoundDevice("OPT3001", (uint8_t)addr.address);
+        } else {
+            type = SHT31;
+            logFoundDevice("SHT31", (uint8_t)addr.address);
+        }
 
-                break;
+        break;
 
-                SCAN_SIMPLE_CASE(SHTC3_ADDR, SHTC3, "SHTC3", (uint8_t)addr.address)
-            case RCWL9620_ADDR:
-                // get MAX30102 PARTID
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0xFF), 1);
-                if (registerValue == 0x15) {
-                    type = MAX30102;
-                    logFoundDevice("MAX30102", (uint8_t)addr.address);
-                    break;
-                } else {
-                    type = RCWL9620;
-                    logFoundDevice("RCWL9620", (uint8_t)addr.address);
-                }
-                break;
+        SCAN_SIMPLE_CASE(SHTC3_ADDR, SHTC3, "SHTC3", (uint8_t)addr.address)
+    case RCWL9620_ADDR:
+        // get MAX30102 PARTID
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0xFF), 1);
+        if (registerValue == 0x15) {
+            type = MAX30102;
+            logFoundDevice("MAX30102", (uint8_t)addr.address);
+            break;
+        } else {
+            type = RCWL9620;
+            logFoundDevice("RCWL9620", (uint8_t)addr.address);
+        }
+        break;
 
-            case LPS22HB_ADDR_ALT:
-                SCAN_SIMPLE_CASE(LPS22HB_ADDR, LPS22HB, "LPS22HB", (uint8_t)addr.address)
-                SCAN_SIMPLE_CASE(QMC6310_ADDR, QMC6310, "QMC6310", (uint8_t)addr.address)
+    case LPS22HB_ADDR_ALT:
+        SCAN_SIMPLE_CASE(LPS22HB_ADDR, LPS22HB, "LPS22HB", (uint8_t)addr.address)
+        SCAN_SIMPLE_CASE(QMC6310_ADDR, QMC6310, "QMC6310", (uint8_t)addr.address)
 
-            case QMI8658_ADDR:
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x0A), 1); // get ID
-                if (registerValue == 0xC0) {
-                    type = BQ24295;
-                    logFoundDevice("BQ24295", (uint8_t)addr.address);
-                    break;
-                }
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x0F), 1); // get ID
-                if (registerValue == 0x6A) {
-                    type = LSM6DS3;
-                    logFoundDevice("LSM6DS3", (uint8_t)addr.address);
-                } else {
-                    type = QMI8658;
-                    logFoundDevice("QMI8658", (uint8_t)addr.address);
-                }
-                break;
+    case QMI8658_ADDR:
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x0A), 1); // get ID
+        if (registerValue == 0xC0) {
+            type = BQ24295;
+            logFoundDevice("BQ24295", (uint8_t)addr.address);
+            break;
+        }
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x0F), 1); // get ID
+        if (registerValue == 0x6A) {
+            type = LSM6DS3;
+            logFoundDevice("LSM6DS3", (uint8_t)addr.address);
+        } else {
+            type = QMI8658;
+            logFoundDevice("QMI8658", (uint8_t)addr.address);
+        }
+        break;
 
-                SCAN_SIMPLE_CASE(QMC5883L_ADDR, QMC5883L, "QMC5883L", (uint8_t)addr.address)
-                SCAN_SIMPLE_CASE(HMC5883L_ADDR, HMC5883L, "HMC5883L", (uint8_t)addr.address)
+        SCAN_SIMPLE_CASE(QMC5883L_ADDR, QMC5883L, "QMC5883L", (uint8_t)addr.address)
+        SCAN_SIMPLE_CASE(HMC5883L_ADDR, HMC5883L, "HMC5883L", (uint8_t)addr.address)
 #ifdef HAS_QMA6100P
-                SCAN_SIMPLE_CASE(QMA6100P_ADDR, QMA6100P, "QMA6100P", (uint8_t)addr.address)
+        SCAN_SIMPLE_CASE(QMA6100P_ADDR, QMA6100P, "QMA6100P", (uint8_t)addr.address)
 #else
-                SCAN_SIMPLE_CASE(PMSA0031_ADDR, PMSA0031, "PMSA0031", (uint8_t)addr.address)
+        SCAN_SIMPLE_CASE(PMSA0031_ADDR, PMSA0031, "PMSA0031", (uint8_t)addr.address)
 #endif
-            case BMA423_ADDR: // this can also be LIS3DH_ADDR_ALT
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x0F), 2);
-                if (registerValue == 0x3300 || registerValue == 0x3333) { // RAK4631 WisBlock has LIS3DH register at 0x3333
-                    type = LIS3DH;
-                    logFoundDevice("LIS3DH", (uint8_t)addr.address);
-                } else {
-                    type = BMA423;
-                    logFoundDevice("BMA423", (uint8_t)addr.address);
-                }
-                break;
+    case BMA423_ADDR: // this can also be LIS3DH_ADDR_ALT
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x0F), 2);
+        if (registerValue == 0x3300 || registerValue == 0x3333) { // RAK4631 WisBlock has LIS3DH register at 0x3333
+            type = LIS3DH;
+            logFoundDevice("LIS3DH", (uint8_t)addr.address);
+        } else {
+            type = BMA423;
+            logFoundDevice("BMA423", (uint8_t)addr.address);
+        }
+        break;
 
-                SCAN_SIMPLE_CASE(LSM6DS3_ADDR, LSM6DS3, "LSM6DS3", (uint8_t)addr.address);
-                SCAN_SIMPLE_CASE(TCA9535_ADDR, TCA9535, "TCA9535", (uint8_t)addr.address);
-                SCAN_SIMPLE_CASE(TCA9555_ADDR, TCA9555, "TCA9555", (uint8_t)addr.address);
-                SCAN_SIMPLE_CASE(VEML7700_ADDR, VEML7700, "VEML7700", (uint8_t)addr.address);
-                SCAN_SIMPLE_CASE(TSL25911_ADDR, TSL2591, "TSL2591", (uint8_t)addr.address);
-                SCAN_SIMPLE_CASE(OPT3001_ADDR, OPT3001, "OPT3001", (uint8_t)addr.address);
-                SCAN_SIMPLE_CASE(MLX90632_ADDR, MLX90632, "MLX90632", (uint8_t)addr.address);
-                SCAN_SIMPLE_CASE(NAU7802_ADDR, NAU7802, "NAU7802", (uint8_t)addr.address);
-                SCAN_SIMPLE_CASE(FT6336U_ADDR, FT6336U, "FT6336U", (uint8_t)addr.address);
-                SCAN_SIMPLE_CASE(MAX1704X_ADDR, MAX17048, "MAX17048", (uint8_t)addr.address);
+        SCAN_SIMPLE_CASE(LSM6DS3_ADDR, LSM6DS3, "LSM6DS3", (uint8_t)addr.address);
+        SCAN_SIMPLE_CASE(TCA9535_ADDR, TCA9535, "TCA9535", (uint8_t)addr.address);
+        SCAN_SIMPLE_CASE(TCA9555_ADDR, TCA9555, "TCA9555", (uint8_t)addr.address);
+        SCAN_SIMPLE_CASE(VEML7700_ADDR, VEML7700, "VEML7700", (uint8_t)addr.address);
+        SCAN_SIMPLE_CASE(TSL25911_ADDR, TSL2591, "TSL2591", (uint8_t)addr.address);
+        SCAN_SIMPLE_CASE(OPT3001_ADDR, OPT3001, "OPT3001", (uint8_t)addr.address);
+        SCAN_SIMPLE_CASE(MLX90632_ADDR, MLX90632, "MLX90632", (uint8_t)addr.address);
+        SCAN_SIMPLE_CASE(NAU7802_ADDR, NAU7802, "NAU7802", (uint8_t)addr.address);
+        SCAN_SIMPLE_CASE(FT6336U_ADDR, FT6336U, "FT6336U", (uint8_t)addr.address);
+        SCAN_SIMPLE_CASE(MAX1704X_ADDR, MAX17048, "MAX17048", (uint8_t)addr.address);
 #ifdef HAS_TPS65233
-                SCAN_SIMPLE_CASE(TPS65233_ADDR, TPS65233, "TPS65233", (uint8_t)addr.address);
+        SCAN_SIMPLE_CASE(TPS65233_ADDR, TPS65233, "TPS65233", (uint8_t)addr.address);
 #endif
 
-            case MLX90614_ADDR_DEF:
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x0e), 1);
-                if (registerValue == 0x5a) {
-                    type = MLX90614;
-                    logFoundDevice("MLX90614", (uint8_t)addr.address);
-                } else {
-                    type = MPR121KB;
-                    logFoundDevice("MPR121KB", (uint8_t)addr.address);
-                }
-                break;
+    case MLX90614_ADDR_DEF:
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x0e), 1);
+        if (registerValue == 0x5a) {
+            type = MLX90614;
+            logFoundDevice("MLX90614", (uint8_t)addr.address);
+        } else {
+            type = MPR121KB;
+            logFoundDevice("MPR121KB", (uint8_t)addr.address);
+        }
+        break;
 
-            case ICM20948_ADDR:     // same as BMX160_ADDR
-            case ICM20948_ADDR_ALT: // same as MPU6050_ADDR
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x00), 1);
-                if (registerValue == 0xEA) {
-                    type = ICM20948;
-                    logFoundDevice("ICM20948", (uint8_t)addr.address);
-                    break;
-                } else if (addr.address == BMX160_ADDR) {
-                    type = BMX160;
-                    logFoundDevice("BMX160", (uint8_t)addr.address);
-                    break;
-                } else {
-                    type = MPU6050;
-                    logFoundDevice("MPU6050", (uint8_t)addr.address);
-                    break;
-                }
-                break;
+    case ICM20948_ADDR:     // same as BMX160_ADDR
+    case ICM20948_ADDR_ALT: // same as MPU6050_ADDR
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x00), 1);
+        if (registerValue == 0xEA) {
+            type = ICM20948;
+            logFoundDevice("ICM20948", (uint8_t)addr.address);
+            break;
+        } else if (addr.address == BMX160_ADDR) {
+            type = BMX160;
+            logFoundDevice("BMX160", (uint8_t)addr.address);
+            break;
+        } else {
+            type = MPU6050;
+            logFoundDevice("MPU6050", (uint8_t)addr.address);
+            break;
+        }
+        break;
 
-            case CGRADSENS_ADDR:
-                // Register 0x00 of the RadSens sensor contains is product identifier 0x7D
-                // Undocumented, but some devices return a product identifier of 0x7A
-                registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x00), 1);
-                if (registerValue == 0x7D || registerValue == 0x7A) {
-                    type = CGRADSENS;
-                    logFoundDevice("ClimateGuard RadSens", (uint8_t)addr.address);
-                    break;
-                } else {
-                    LOG_DEBUG("Unexpected Device ID for RadSense: addr=0x%x id=0x%x", CGRADSENS_ADDR, registerValue);
-                }
-                break;
+    case CGRADSENS_ADDR:
+        // Register 0x00 of the RadSens sensor contains is product identifier 0x7D
+        // Undocumented, but some devices return a product identifier of 0x7A
+        registerValue = getRegisterValue(ScanI2CTwoWire::RegisterLocation(addr, 0x00), 1);
+        if (registerValue == 0x7D || registerValue == 0x7A) {
+            type = CGRADSENS;
+            logFoundDevice("ClimateGuard RadSens", (uint8_t)addr.address);
+            break;
+        } else {
+            LOG_DEBUG("Unexpected Device ID for RadSense: addr=0x%x id=0x%x", CGRADSENS_ADDR, registerValue);
+        }
+        break;
 
-            default:
-                LOG_INFO("Device found at address 0x%x was not able to be enumerated", (uint8_t)addr.address);
+    default:
+        LOG_INFO("Device found at address 0x%x was not able to be enumerated", (uint8_t)addr.address);
+    }
+    return type;
+}
+
+void ScanI2CTwoWire::addDevice(ScanI2C::DeviceAddress addr, ScanI2C::DeviceType type)
+{
+    // Check if a type was found for the enumerated device - save, if so
+    if (type != NONE) {
+        deviceAddresses[type] = addr;
+        foundDevices[addr] = type;
+    }
+}
+
+void ScanI2CTwoWire::scanPort(I2CPort port, uint8_t *address, uint8_t asize)
+{
+    concurrency::LockGuard guard((concurrency::Lock *)&lock);
+
+    LOG_DEBUG("Scan for I2C devices on port %d", port);
+
+    AddressSet present = probePort(port, address, asize);
+    for (uint8_t a = 8; a < 120; a++) {
+        if (present[a]) {
+            DeviceAddress addr(port, a);
+            addDevice(addr, identify(addr));
+        }
+    }
+}
+
+void ScanI2CTwoWire::scanPorts(const I2CPort *ports, size_t count)
+{
+    concurrency::LockGuard guard((concurrency::Lock *)&lock);
+
+    assert(count <= I2C_SCAN_MAX_PORTS);
+    AddressSet present[I2C_SCAN_MAX_PORTS];
+    probePorts(ports, count, present);
+
+    CachedDevice cached[I2C_SCAN_CACHE_MAX];
+    int numCached = loadCache(cached, I2C_SCAN_CACHE_MAX);
+
+    CachedDevice current[I2C_SCAN_CACHE_MAX];
+    size_t numCurrent = 0;
+    bool changed = numCached < 0;
+
+    for (size_t i = 0; i < count; i++) {
+        AddressSet known;
+        for (int k = 0; k < numCached; k++) {
+            if (cached[k].port == ports[i])
+                known.set(cached[k].address);
+        }
+
+        if (numCached >= 0 && known == present[i]) {
+            // Same addresses as last boot, only those where several kinds of chip can answer are identified again
+            LOG_DEBUG("I2C devices on port %d unchanged since last boot", ports[i]);
+            for (int k = 0; k < numCached; k++) {
+                if (cached[k].port != ports[i])
+                    continue;
+                DeviceAddress addr(ports[i], cached[k].address);
+                ScanI2C::DeviceType type = (ScanI2C::DeviceType)cached[k].type;
+                if (isSharedAddress(cached[k].address)) {
+                    ScanI2C::DeviceType found = identify(addr);
+                    if (found != type) {
+                        LOG_INFO("I2C device at 0x%x on port %d was replaced", cached[k].address, ports[i]);
+                        type = found;
+                        changed = true;
+                    }
+                }
+#ifdef RV3028_RTC
+                else if (type == RTC_RV3028)
+                    setupRV3028(addr);
+#endif
+                addDevice(addr, type);
+                if (numCurrent < I2C_SCAN_CACHE_MAX)
+                    current[numCurrent] = CachedDevice{(uint8_t)ports[i], cached[k].address, (uint8_t)type};
+                numCurrent++;
             }
-        } else if (err == 4) {
-            LOG_ERROR("Unknown error at address 0x%x", (uint8_t)addr.address);
+            continue;
         }
 
-        // Check if a type was found for the enumerated device - save, if so
-        if (type != NONE) {
-            deviceAddresses[type] = addr;
-            foundDevices[addr] = type;
+        LOG_DEBUG("Scan for I2C devices on port %d", ports[i]);
+        changed = true;
+        for (uint8_t a = 8; a < 120; a++) {
+            if (!present[i][a])
+                continue;
+            DeviceAddress addr(ports[i], a);
+            ScanI2C::DeviceType type = identify(addr);
+            addDevice(addr, type);
+            if (numCurrent < I2C_SCAN_CACHE_MAX)
+                current[numCurrent] = CachedDevice{(uint8_t)ports[i], a, (uint8_t)type};
+            numCurrent++;
         }
     }
+
+    if (changed)
+        saveCache(current, numCurrent);
+}
+
+/// Whether identify() tells several kinds of chip apart at this address by their ID registers (e.g. BME280 or BMP280)
+bool ScanI2CTwoWire::isSharedAddress(uint8_t address)
+{
+    switch (address) {
+    case SSD1306_ADDRESS:
+    case CARDKB_ADDR:
+    case BME_ADDR:
+    case BME_ADDR_ALTERNATE:
+    case INA_ADDR:
+    case INA_ADDR_ALTERNATE:
+    case INA_ADDR_WAVESHARE_UPS:
+    case INA3221_ADDR:
+    case MCP9808_ADDR:
+    case SHT31_4x_ADDR:
+    case RCWL9620_ADDR:
+    case QMI8658_ADDR:
+    case BMA423_ADDR:
+    case MLX90614_ADDR_DEF:
+    case ICM20948_ADDR:
+    case ICM20948_ADDR_ALT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// The devices we found last boot, returns how many or -1 if there is no (usable) cache
+int ScanI2CTwoWire::loadCache(CachedDevice *devices, size_t maxDevices)
+{
+#ifdef FSCom
+    auto f = FSCom.open(I2C_SCAN_CACHE_FILE, FILE_O_READ);
+    if (!f)
+        return -1;
+
+    CacheHeader header;
+    int count = -1;
+    if (f.read((uint8_t *)&header, sizeof(header)) == sizeof(header) && header.magic == I2C_SCAN_CACHE_MAGIC &&
+        strncmp(header.firmware, optstr(APP_VERSION), sizeof(header.firmware)) == 0 && header.count <= maxDevices &&
+        f.read((uint8_t *)devices, header.count * sizeof(CachedDevice)) == header.count * sizeof(CachedDevice))
+        count = header.count;
+    f.close();
+    return count;
+#else
+    return -1;
+#endif
+}
+
+void ScanI2CTwoWire::saveCache(const CachedDevice *devices, size_t count)
+{
+#ifdef FSCom
+    if (count > I2C_SCAN_CACHE_MAX) {
+        // Won't fit, so scan everything every time
+        FSCom.remove(I2C_SCAN_CACHE_FILE);
+        return;
+    }
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = I2C_SCAN_CACHE_MAGIC;
+    strncpy(header.firmware, optstr(APP_VERSION), sizeof(header.firmware));
+    header.count = count;
+
+    FSCom.mkdir("/prefs");
+    SafeFile f(I2C_SCAN_CACHE_FILE);
+    f.write((const uint8_t *)&header, sizeof(header));
+    f.write((const uint8_t *)devices, count * sizeof(CachedDevice));
+    if (!f.close())
+        LOG_WARN("Can't save I2C devices, will scan everything next boot");
+#endif
 }
 
 void ScanI2CTwoWire::scanPort(I2CPort port)
@@ -3,6 +3,7 @@
 #include "configuration.h"
 #if !MESHTASTIC_EXCLUDE_I2C
 
+#include <bitset>
 #include <map>
 #include <memory>
 #include <stddef.h>
@@ -14,6 +15,11 @@
 
 #include "../concurrency/Lock.h"
 
+// WIRE and WIRE1
+#define I2C_SCAN_MAX_PORTS 2
+// More devices than this and we don't bother remembering them
+#define I2C_SCAN_CACHE_MAX 32
+
 class ScanI2CTwoWire : public ScanI2C
 {
   public:
@@ -21,6 +27,13 @@ class ScanI2CTwoWire : public ScanI2C
 
     void scanPort(ScanI2C::I2CPort, uint8_t *, uint8_t) override;
 
+    /**
+     * The boot scan of all our buses. Finding which addresses answer is quick (and done on both buses at once where they have
+     * their own controllers), telling the devices apart is what takes long, so if the same addresses answer as last boot we
+     * use the types we found then.
+     */
+    void scanPorts(const ScanI2C::I2CPort *, size_t);
+
     ScanI2C::FoundDevice find(ScanI2C::DeviceType) const override;
 
     TwoWire *fetchI2CBus(ScanI2C::DeviceAddress) const;
@@ -46,6 +59,21 @@ class ScanI2CTwoWire : public ScanI2C
 
     typedef uint8_t ResponseWidth;
 
+    typedef std::bitset<128> AddressSet;
+
+    /// What we remember of each address that answered, the type is NONE if we couldn't tell what it is
+    typedef struct CachedDevice {
+        uint8_t port;
+        uint8_t address;
+        uint8_t type;
+    } CachedDevice;
+
+    typedef struct CacheHeader {
+        uint32_t magic;
+        char firmware[18]; // the types are only valid for the firmware that found them
+        uint16_t count;
+    } CacheHeader;
+
     std::map<ScanI2C::DeviceAddress, ScanI2C::DeviceType> foundDevices;
 
     // note: prone to overwriting if multiple devices of a type are added at different addresses (rare?)
@@ -57,6 +85,24 @@ class ScanI2CTwoWire : public ScanI2C
 
     DeviceType probeOLED(ScanI2C::DeviceAddress) const;
 
+    AddressSet probePort(ScanI2C::I2CPort, uint8_t *, uint8_t) const;
+
+    void probePorts(const ScanI2C::I2CPort *, size_t, AddressSet *) const;
+
+    DeviceType identify(ScanI2C::DeviceAddress) const;
+
+#ifdef RV3028_RTC
+    void setupRV3028(ScanI2C::DeviceAddress) const;
+#endif
+
+    void addDevice(ScanI2C::DeviceAddress, ScanI2C::DeviceType);
+
+    static bool isSharedAddress(uint8_t);
+
+    static int loadCache(CachedDevice *, size_t);
+
+    static void saveCache(const CachedDevice *, size_t);
+
     static void logFoundDevice(const char *device, uint8_t address);
 };
 #endif
\ No newline at end of file
@@ -1022,7 +1022,7 @@ int32_t GPS::runOnce()
             LOG_WARN("GPS FactoryReset requested");
             if (gps->factoryReset()) { // If we don't succeed try again next time
                 devicestate.did_gps_reset = true;
-                nodeDB->saveToDisk(SEGMENT_DEVICESTATE);
+                nodeDB->saveToDiskLater(SEGMENT_DEVICESTATE);
             }
         }
         GPSInitFinished = true;
@@ -1045,7 +1045,7 @@ int32_t GPS::runOnce()
             if (devicestate.did_gps_reset && scheduling.elapsedSearchMs() > 60 * 1000UL && !hasFlow()) {
                 LOG_DEBUG("GPS is not found, try factory reset on next boot");
                 devicestate.did_gps_reset = false;
-                nodeDB->saveToDisk(SEGMENT_DEVICESTATE);
+                nodeDB->saveToDiskLater(SEGMENT_DEVICESTATE);
                 return disable(); // Stop the GPS thread as it can do nothing useful until next reboot.
             }
         }
@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "configuration.h"
 #if HAS_SCREEN
 #include <OLEDDisplay.h>
+#include <unordered_map>
 
 #include "DisplayFormatters.h"
 #if !MESHTASTIC_EXCLUDE_GPS
@@ -1357,6 +1358,110 @@ uint16_t Screen::getCompassDiam(uint32_t displayWidth, uint32_t displayHeight)
     return diam - 20;
 };
 
+/// Precomputed values shown on a node frame. Redrawing a frame (which happens many times a second while
+/// scrolling) only blits these strings, the geo math and formatting is redone when the node or our position changes.
+struct NodeDisplayRecord {
+    bool dirty = true;
+    bool hasPosition = false;   // both we and the node had a valid position when this was computed
+    float bearingToOther = 0;   // radians, relative to true north
+    int32_t ourLatI = 0, ourLonI = 0; // our position the distance/bearing were computed from
+    // Inputs NodeDB updates without notifying observers (see NodeDB::updateFrom)
+    float snr = 0;
+    uint32_t hopsAway = 0;
+    uint32_t ageKey = UINT32_MAX; // lastStr is valid for as long as this key doesn't change
+    meshtastic_Config_DisplayConfig_DisplayUnits units = meshtastic_Config_DisplayConfig_DisplayUnits_METRIC;
+    char signalStr[20] = "";
+    char lastStr[20] = "";
+    char distStr[20] = "";
+};
+
+/// Cache of the display records, keyed by node number. Only nodes that have been shown get an entry.
+static std::unordered_map<NodeNum, NodeDisplayRecord> nodeDisplayCache;
+
+/// How far (in 1e-7 degree units, roughly 10 m) we have to move before cached distances/bearings are recomputed
+#define NODE_DISPLAY_MOVE_THRESHOLD_I 900
+
+/// Mark the cached record of a node as stale
+static void invalidateNodeDisplayRecord(NodeNum num)
+{
+    auto it = nodeDisplayCache.find(num);
+    if (it != nodeDisplayCache.end())
+        it->second.dirty = true;
+}
+
+/// Return the (possibly recomputed) display record for a node
+static const NodeDisplayRecord &getNodeDisplayRecord(const meshtastic_NodeInfoLite *node, const meshtastic_NodeInfoLite *ourNode)
+{
+    NodeDisplayRecord &rec = nodeDisplayCache[node->num];
+
+    if (rec.units != config.display.units) {
+        rec.units = config.display.units;
+        rec.dirty = true;
+    }
+
+    bool hasPosition = ourNode && nodeDB->hasValidPosition(ourNode) && nodeDB->hasValidPosition(node);
+    if (hasPosition != rec.hasPosition)
+        rec.dirty = true;
+    else if (hasPosition && (abs(ourNode->position.latitude_i - rec.ourLatI) > NODE_DISPLAY_MOVE_THRESHOLD_I ||
+                             abs(ourNode->position.longitude_i - rec.ourLonI) > NODE_DISPLAY_MOVE_THRESHOLD_I))
+        rec.dirty = true;
+
+    if (rec.dirty || rec.snr != node->snr || rec.hopsAway != node->hops_away) {
+        rec.snr = node->snr;
+        rec.hopsAway = node->hops_away;
+        // section here to choose whether to display hops away rather than signal strength if more than 0 hops away.
+        if (node->hops_away > 0) {
+            snprintf(rec.signalStr, sizeof(rec.signalStr), "Hops Away: %d", node->hops_away);
+        } else {
+            snprintf(rec.signalStr, sizeof(rec.signalStr), "Signal: %d%%", clamp((int)((node->snr + 10) * 5), 0, 100));
+        }
+    }
+
+    // The age string only changes every second for the first two minutes, then at most once a minute
+    uint32_t agoSecs = sinceLastSeen(node);
+    uint32_t ageKey = (agoSecs < 120) ? agoSecs : (120 + agoSecs / SECONDS_IN_MINUTE);
+    if (rec.dirty || ageKey != rec.ageKey) {
+        rec.ageKey = ageKey;
+        screen->getTimeAgoStr(agoSecs, rec.lastStr, sizeof(rec.lastStr));
+    }
+
+    if (rec.dirty) {
+        rec.hasPosition = hasPosition;
+        if (config.display.units == meshtastic_Config_DisplayConfig_DisplayUnits_IMPERIAL) {
+            strncpy(rec.distStr, "? mi", sizeof(rec.distStr)); // might not have location data
+        } else {
+            strncpy(rec.distStr, "? km", sizeof(rec.distStr));
+        }
+
+        if (rec.hasPosition) {
+            const meshtastic_PositionLite &op = ourNode->position;
+            const meshtastic_PositionLite &p = node->position;
+            rec.ourLatI = op.latitude_i;
+            rec.ourLonI = op.longitude_i;
+            float d =
+                GeoCoord::latLongToMeter(DegD(p.latitude_i), DegD(p.longitude_i), DegD(op.latitude_i), DegD(op.longitude_i));
+
+            if (config.display.units == meshtastic_Config_DisplayConfig_DisplayUnits_IMPERIAL) {
+                if (d < (2 * MILES_TO_FEET))
+                    snprintf(rec.distStr, sizeof(rec.distStr), "%.0f ft", d * METERS_TO_FEET);
+                else
+                    snprintf(rec.distStr, sizeof(rec.distStr), "%.1f mi", d * METERS_TO_FEET / MILES_TO_FEET);
+            } else {
+                if (d < 2000)
+                    snprintf(rec.distStr, sizeof(rec.distStr), "%.0f m", d);
+                else
+                    snprintf(rec.distStr, sizeof(rec.distStr), "%.1f km", d / 1000);
+            }
+
+            rec.bearingToOther =
+                GeoCoord::bearing(DegD(op.latitude_i), DegD(op.longitude_i), DegD(p.latitude_i), DegD(p.longitude_i));
+        }
+        rec.dirty = false;
+    }
+
+    return rec;
+}
+
 static void drawNodeInfo(OLEDDisplay *display, OLEDDisplayUiState *state, int16_t x, int16_t y)
 {
     // We only advance our nodeIndex if the frame # has changed - because
@@ -1386,26 +1491,9 @@ static void drawNodeInfo(OLEDDisplay *display, OLEDDisplayUiState *state, int16_
 
     const char *username = node->has_user ? node->user.long_name : "Unknown Name";
 
-    static char signalStr[20];
-
-    // section here to choose whether to display hops away rather than signal strength if more than 0 hops away.
-    if (node->hops_away > 0) {
-        snprintf(signalStr, sizeof(signalStr), "Hops Away: %d", node->hops_away);
-    } else {
-        snprintf(signalStr, sizeof(signalStr), "Signal: %d%%", clamp((int)((node->snr + 10) * 5), 0, 100));
-    }
-
-    static char lastStr[20];
-    screen->getTimeAgoStr(sinceLastSeen(node), lastStr, sizeof(lastStr));
-
-    static char distStr[20];
-    if (config.display.units == meshtastic_Config_DisplayConfig_DisplayUnits_IMPERIAL) {
-        strncpy(distStr, "? mi", sizeof(distStr)); // might not have location data
-    } else {
-        strncpy(distStr, "? km", sizeof(distStr));
-    }
     meshtastic_NodeInfoLite *ourNode = nodeDB->getMeshNode(nodeDB->getNodeNum());
-    const char *fields[] = {username, lastStr, signalStr, distStr, NULL};
+    const NodeDisplayRecord &rec = getNodeDisplayRecord(node, ourNode);
+    const char *fields[] = {username, rec.lastStr, rec.signalStr, rec.distStr, NULL};
     int16_t compassX = 0, compassY = 0;
     uint16_t compassDiam = Screen::getCompassDiam(SCREEN_WIDTH, SCREEN_HEIGHT);
 
@@ -1428,27 +1516,10 @@ static void drawNodeInfo(OLEDDisplay *display, OLEDDisplayUiState *state, int16_
             myHeading = screen->estimatedHeading(DegD(op.latitude_i), DegD(op.longitude_i));
         screen->drawCompassNorth(display, compassX, compassY, myHeading);
 
-        if (nodeDB->hasValidPosition(node)) {
+        if (rec.hasPosition) {
             // display direction toward node
             hasNodeHeading = true;
-            const meshtastic_PositionLite &p = node->position;
-            float d =
-                GeoCoord::latLongToMeter(DegD(p.latitude_i), DegD(p.longitude_i), DegD(op.latitude_i), DegD(op.longitude_i));
-
-            if (config.display.units == meshtastic_Config_DisplayConfig_DisplayUnits_IMPERIAL) {
-                if (d < (2 * MILES_TO_FEET))
-                    snprintf(distStr, sizeof(distStr), "%.0f ft", d * METERS_TO_FEET);
-                else
-                    snprintf(distStr, sizeof(distStr), "%.1f mi", d * METERS_TO_FEET / MILES_TO_FEET);
-            } else {
-                if (d < 2000)
-                    snprintf(distStr, sizeof(distStr), "%.0f m", d);
-                else
-                    snprintf(distStr, sizeof(distStr), "%.1f km", d / 1000);
-            }
-
-            float bearingToOther =
-                GeoCoord::bearing(DegD(op.latitude_i), DegD(op.longitude_i), DegD(p.latitude_i), DegD(p.longitude_i));
+            float bearingToOther = rec.bearingToOther;
             // If the top of the compass is a static north then bearingToOther can be drawn on the compass directly
             // If the top of the compass is not a static north we need adjust bearingToOther based on heading
             if (!config.display.compass_north_top)
@@ -1868,7 +1939,11 @@ int32_t Screen::runOnce()
 
     // this must be before the frameState == FIXED check, because we always
     // want to draw at least one FIXED frame before doing forceDisplay
+    uint32_t frameStart = micros();
     ui->update();
+    uint32_t frameTime = micros() - frameStart;
+    // Smoothed (1/8 weight) so the debug frame shows a readable number
+    frameTimeUs = frameTimeUs ? (frameTimeUs * 7 + frameTime) / 8 : frameTime;
 
     // Switch to a low framerate (to save CPU) when we are not in transition
     // but we should only call setTargetFPS when framestate changes, because
@@ -2406,6 +2481,13 @@ void DebugInfo::drawFrame(OLEDDisplay *display, OLEDDisplayUiState *state, int16
     display->setColor(WHITE);
     // Draw the channel name
     display->drawString(x, y + FONT_HEIGHT_SMALL, channelStr);
+
+    // Draw the frame render time, if there is room between the channel name and our ID
+    char frameTimeStr[12];
+    snprintf(frameTimeStr, sizeof(frameTimeStr), "%ums", (unsigned int)((screen->getFrameTimeUs() + 500) / 1000));
+    int16_t frameTimeX = x + display->getStringWidth(channelStr) + 4;
+    if (frameTimeX + display->getStringWidth(frameTimeStr) + 18 < x + SCREEN_WIDTH - display->getStringWidth(ourId))
+        display->drawString(frameTimeX, y + FONT_HEIGHT_SMALL, frameTimeStr);
     // Draw our hardware ID to assist with bluetooth pairing. Either prefix with Info or S&F Logo
     if (moduleConfig.store_forward.enabled) {
 #ifdef ARCH_ESP32
@@ -2650,6 +2732,12 @@ int Screen::handleStatusUpdate(const meshtastic::Status *arg)
     // LOG_DEBUG("Screen got status update %d", arg->getStatusType());
     switch (arg->getStatusType()) {
     case STATUS_TYPE_NODE:
+        if (nodeStatus->getLastNumTotal() > nodeStatus->getNumTotal()) {
+            nodeDisplayCache.clear(); // Nodes were removed, drop all cached display records
+        } else if (nodeDB->updateGUIforNode) {
+            invalidateNodeDisplayRecord(nodeDB->updateGUIforNode);
+            nodeDB->updateGUIforNode = 0;
+        }
         if (showingNormalScreen && nodeStatus->getLastNumTotal() != nodeStatus->getNumTotal()) {
             setFrames(FOCUS_PRESERVE); // Regen the list of screen frames (returning to same frame, if possible)
         }
@@ -444,6 +444,9 @@ class Screen : public concurrency::OSThread
     // Use this handle to set things like battery status, user count, GPS status, etc.
     DebugInfo *debug_info() { return &debugInfo; }
 
+    /// Smoothed time (in microseconds) the last frames took to render, shown on the debug frame
+    uint32_t getFrameTimeUs() const { return frameTimeUs; }
+
     // Handle observer events
     int handleStatusUpdate(const meshtastic::Status *arg);
     int handleTextMessage(const meshtastic_MeshPacket *arg);
@@ -593,6 +596,8 @@ class Screen : public concurrency::OSThread
 
     bool hasCompass = false;
     float compassHeading;
+    /// Smoothed render time of ui->update(), see getFrameTimeUs()
+    uint32_t frameTimeUs = 0;
     /// Holds state for debug information
     DebugInfo debugInfo;
 
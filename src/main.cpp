@@ -89,6 +89,7 @@ NRF52Bluetooth *nrf52Bluetooth = nullptr;
 #ifdef ARCH_PORTDUINO
 #include "linux/LinuxHardwareI2C.h"
 #include "mesh/raspihttp/PiWebServer.h"
+#include "platform/portduino/PacketCapture.h"
 #include "platform/portduino/PortduinoGlue.h"
 #include <fstream>
 #include <iostream>
@@ -433,34 +434,38 @@ void setup()
     LOG_INFO("Scan for i2c devices");
 #endif
 
+    ScanI2C::I2CPort i2cPorts[I2C_SCAN_MAX_PORTS];
+    size_t numI2CPorts = 0;
+
 #if defined(I2C_SDA1) && defined(ARCH_RP2040)
     Wire1.setSDA(I2C_SDA1);
     Wire1.setSCL(I2C_SCL1);
     Wire1.begin();
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE1);
+    i2cPorts[numI2CPorts++] = ScanI2C::I2CPort::WIRE1;
 #elif defined(I2C_SDA1) && !defined(ARCH_RP2040)
     Wire1.begin(I2C_SDA1, I2C_SCL1);
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE1);
+    i2cPorts[numI2CPorts++] = ScanI2C::I2CPort::WIRE1;
 #elif defined(NRF52840_XXAA) && (WIRE_INTERFACES_COUNT == 2)
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE1);
+    i2cPorts[numI2CPorts++] = ScanI2C::I2CPort::WIRE1;
 #endif
 
 #if defined(I2C_SDA) && defined(ARCH_RP2040)
     Wire.setSDA(I2C_SDA);
     Wire.setSCL(I2C_SCL);
     Wire.begin();
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE);
+    i2cPorts[numI2CPorts++] = ScanI2C::I2CPort::WIRE;
 #elif defined(I2C_SDA) && !defined(ARCH_RP2040)
     Wire.begin(I2C_SDA, I2C_SCL);
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE);
+    i2cPorts[numI2CPorts++] = ScanI2C::I2CPort::WIRE;
 #elif defined(ARCH_PORTDUINO)
     if (settingsStrings[i2cdev] != "") {
         LOG_INFO("Scan for i2c devices");
-        i2cScanner->scanPort(ScanI2C::I2CPort::WIRE);
+        i2cPorts[numI2CPorts++] = ScanI2C::I2CPort::WIRE;
     }
 #elif HAS_WIRE
-    i2cScanner->scanPort(ScanI2C::I2CPort::WIRE);
+    i2cPorts[numI2CPorts++] = ScanI2C::I2CPort::WIRE;
 #endif
+    i2cScanner->scanPorts(i2cPorts, numI2CPorts);
 
     auto i2cCount = i2cScanner->countDevices();
     if (i2cCount == 0) {
@@ -1100,7 +1105,7 @@ void setup()
     if ((config.lora.region == meshtastic_Config_LoRaConfig_RegionCode_LORA_24) && (!rIf->wideLora())) {
         LOG_WARN("LoRa chip does not support 2.4GHz. Revert to unset");
         config.lora.region = meshtastic_Config_LoRaConfig_RegionCode_UNSET;
-        nodeDB->saveToDisk(SEGMENT_CONFIG);
+        nodeDB->saveToDiskLater(SEGMENT_CONFIG);
         if (!rIf->reconfigure()) {
             LOG_WARN("Reconfigure failed, rebooting");
             screen->startAlert("Rebooting...");
@@ -1146,6 +1151,16 @@ void setup()
     }
 #endif
     initApiServer(TCPPort);
+
+    if (settingsStrings[captureFilename] != "") {
+        packetCapture = new PacketCapture();
+        if (!packetCapture->open(settingsStrings[captureFilename].c_str())) {
+            delete packetCapture;
+            packetCapture = NULL;
+        }
+    }
+    if (replayPath)
+        new PacketReplay(replayPath, replaySpeed);
 #endif
 
     // Start airtime logger thread.
@@ -1255,7 +1270,7 @@ void loop()
 
     service->loop();
 
-    long delayMsec = mainController.runOrDelay();
+    long delayMsec = mainScheduler.runOrDelay();
 
     // We want to sleep as long as possible here - because it saves power
     if (!runASAP && loopCanSleep()) {
@@ -0,0 +1,40 @@
+#include "AirtimeTable.h"
+#include <math.h>
+
+void AirtimeTable::build(float _bw, uint8_t _sf, uint8_t _cr, uint16_t _preambleLength)
+{
+    if (matches(_bw, _sf, _cr, _preambleLength))
+        return;
+
+    bw = _bw;
+    bw8 = lroundf(_bw * 8);
+    sf = _sf;
+    cr = _cr;
+    preambleLength = _preambleLength;
+
+    for (uint32_t pl = 0; pl <= AIRTIME_TABLE_MAX_LEN; pl++)
+        msec[pl] = compute(pl);
+}
+
+uint32_t AirtimeTable::compute(uint32_t pl) const
+{
+    if (!bw8 || sf > 12)
+        return 0; // not configured (yet)
+
+    const bool headDisable = false; // we currently always use the header
+
+    // Symbol time is 2^sf / bw msecs, low data rate optimization is needed if that is >16ms
+    bool lowDataOptEn = (1UL << sf) > 2 * bw8;
+
+    int32_t numer = (8 * (int32_t)pl - 4 * sf + 28 + 16 - 20 * headDisable) * cr;
+    int32_t denom = 4 * (sf - 2 * lowDataOptEn);
+    if (denom < 1)
+        denom = 1;
+    uint32_t payloadSym = numer > 0 ? (numer + denom - 1) / denom : 0; // ceil, but never negative
+
+    // preamble + 4.25 symbols + 8 + payloadSym, in quarter symbols
+    uint64_t quarterSyms = 4ULL * preambleLength + 17 + 4 * (8 + payloadSym);
+
+    // quarterSyms / 4 * 2^sf / (bw8 / 8)
+    return (uint32_t)(quarterSyms * (2ULL << sf) / bw8);
+}
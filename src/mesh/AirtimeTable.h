@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+
+// Same as MAX_LORA_PAYLOAD_LEN, anything longer is computed on the fly
+#define AIRTIME_TABLE_MAX_LEN 255
+
+/**
+ * LoRa airtime for every possible packet length, for one set of modem settings.
+ *
+ * Airtime per
+ * https://www.rs-online.com/designspark/rel-assets/ds-assets/uploads/knowledge-items/application-notes-for-the-internet-of-things/LoRa%20Design%20Guide.pdf
+ * section 4, but in integer math: the bandwidth of every preset (and every custom setting we accept) is a multiple of 1/8 kHz,
+ * so the packet time is an exact fraction and we can truncate it just like the float version did (except where float rounding
+ * made that one msec too long).
+ *
+ * The modem settings change rarely (only in applyModemConfig()), so we compute the whole table then and each lookup is just an
+ * index.  The table costs 1KB of RAM.
+ */
+class AirtimeTable
+{
+  public:
+    /// Rebuild the table for these modem settings (a no-op if they didn't change)
+    void build(float _bw, uint8_t _sf, uint8_t _cr, uint16_t _preambleLength);
+
+    /// @return num msecs for a packet of totalPacketLen bytes (including the PacketHeader)
+    uint32_t getMsec(uint32_t totalPacketLen) const
+    {
+        return totalPacketLen <= AIRTIME_TABLE_MAX_LEN ? msec[totalPacketLen] : compute(totalPacketLen);
+    }
+
+    /// Are we built for these settings?
+    bool matches(float _bw, uint8_t _sf, uint8_t _cr, uint16_t _preambleLength) const
+    {
+        return bw == _bw && sf == _sf && cr == _cr && preambleLength == _preambleLength;
+    }
+
+  private:
+    uint32_t msec[AIRTIME_TABLE_MAX_LEN + 1] = {};
+
+    float bw = 0;
+    uint32_t bw8 = 0; // bandwidth in 1/8 kHz
+    uint8_t sf = 0, cr = 0;
+    uint16_t preambleLength = 0;
+
+    uint32_t compute(uint32_t totalPacketLen) const;
+};
@@ -257,6 +257,8 @@ void Channels::initDefaults()
 
 void Channels::onConfigChanged()
 {
+    version++;
+
     // Make sure the phone hasn't mucked anything up
     for (int i = 0; i < channelFile.channels_count; i++) {
         const meshtastic_Channel &ch = fixupChannel(i);
@@ -301,8 +303,20 @@ meshtastic_Channel &Channels::getByName(const char *chName)
     return getByIndex(getPrimaryIndex());
 }
 
+uint8_t Channels::getMaskByName(const char *chName)
+{
+    uint8_t mask = 0;
+    for (ChannelIndex i = 0; i < getNumChannels() && i < MAX_NUM_CHANNELS; i++) {
+        if (strcasecmp(channelFile.channels[i].settings.name, chName) == 0)
+            mask |= 1 << i;
+    }
+    return mask;
+}
+
 void Channels::setChannel(const meshtastic_Channel &c)
 {
+    version++;
+
     meshtastic_Channel &old = getByIndex(c.index);
 
     // if this is the new primary, demote any existing roles
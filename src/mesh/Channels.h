@@ -28,6 +28,9 @@ class Channels
     /// the precomputed hashes for each of our channels, or -1 for invalid
     int16_t hashes[MAX_NUM_CHANNELS] = {};
 
+    /// Bumped whenever the channel settings might have changed
+    uint32_t version = 0;
+
   public:
     Channels() {}
 
@@ -42,6 +45,13 @@ class Channels
     /** Return the Channel for a specified name, return primary if not found. */
     meshtastic_Channel &getByName(const char *chName);
 
+    /** Return a bit for each channel index whose name is chName (ignoring case), 0 if there is none */
+    uint8_t getMaskByName(const char *chName);
+
+    /** Changes whenever the channel settings might have changed, so users can cache what they derive from them (like
+     * getMaskByName()) */
+    uint32_t getVersion() const { return version; }
+
     /** Using the index inside the channel, update the specified channel's settings and role.  If this channel is being promoted
      * to be primary, force all other channels to be secondary.
      */
@@ -0,0 +1,146 @@
+#include "MappedNodeStore.h"
+
+#if NODEDB_MAPPED_STORE
+
+#include "FSCommon.h"
+#include "NodeDB.h"
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define NODESTORE_MAGIC 0x4244444e // "NDDB"
+#define NODESTORE_LAYOUT ((uint32_t)sizeof(meshtastic_NodeInfoLite) | ((uint32_t)DEVICESTATE_CUR_VER << 24))
+#define NODESTORE_MIN_CAPACITY 64
+
+static std::string storePath()
+{
+    return std::string(portduinoVFS->mountpoint()) + "/prefs/nodes.db";
+}
+
+size_t MappedNodeStore::mapSize(uint32_t capacity)
+{
+    return sizeof(Header) + (size_t)capacity * sizeof(meshtastic_NodeInfoLite);
+}
+
+bool MappedNodeStore::openMap(bool create, uint32_t capacity)
+{
+    close();
+
+    std::string path = storePath();
+    fd = open(path.c_str(), O_RDWR | (create ? O_CREAT : 0), 0644);
+    if (fd < 0) {
+        if (create)
+            LOG_ERROR("Can't open %s", path.c_str());
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close();
+        return false;
+    }
+
+    bool fresh = (size_t)st.st_size < sizeof(Header);
+    if (capacity || fresh) {
+        capacity = max(capacity, (uint32_t)NODESTORE_MIN_CAPACITY);
+        if (ftruncate(fd, mapSize(capacity)) != 0) {
+            LOG_ERROR("Can't grow %s to %u nodes", path.c_str(), capacity);
+            close();
+            return false;
+        }
+        st.st_size = mapSize(capacity);
+    }
+
+    mapLen = st.st_size;
+    void *m = mmap(NULL, mapLen, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (m == MAP_FAILED) {
+        LOG_ERROR("Can't map %s", path.c_str());
+        map = NULL;
+        close();
+        return false;
+    }
+    map = (uint8_t *)m;
+
+    if (fresh) {
+        header()->magic = NODESTORE_MAGIC;
+        header()->layout = NODESTORE_LAYOUT;
+        header()->count = 0;
+    }
+    if (capacity)
+        header()->capacity = capacity;
+
+    if (header()->magic != NODESTORE_MAGIC || header()->layout != NODESTORE_LAYOUT ||
+        mapSize(header()->capacity) > mapLen || header()->count > header()->capacity) {
+        LOG_WARN("%s is from another build or damaged, ignore it", path.c_str());
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedNodeStore::close()
+{
+    if (map)
+        munmap(map, mapLen);
+    if (fd >= 0)
+        ::close(fd);
+    map = NULL;
+    mapLen = 0;
+    fd = -1;
+}
+
+bool MappedNodeStore::load(std::vector<meshtastic_NodeInfoLite> &nodes, pb_size_t &numNodes, size_t maxNodes)
+{
+    if (!openMap(false))
+        return false;
+
+    uint32_t start = millis();
+    size_t count = min((size_t)header()->count, maxNodes);
+    nodes.clear();
+    nodes.reserve(maxNodes);
+    nodes.assign(records(), records() + count);
+    numNodes = count;
+    LOG_INFO("Loaded %u nodes from %s in %u ms", (unsigned)count, storePath().c_str(), millis() - start);
+    return true;
+}
+
+bool MappedNodeStore::save(const std::vector<meshtastic_NodeInfoLite> &nodes, size_t numNodes)
+{
+    // Someone (factory reset) might have deleted the file from under our mapping
+    if (map && access(storePath().c_str(), F_OK) != 0)
+        close();
+
+    if (!map && !openMap(true)) {
+        // A damaged or foreign file gets replaced
+        unlink(storePath().c_str());
+        if (!openMap(true))
+            return false;
+    }
+
+    if (numNodes > header()->capacity) {
+        uint32_t capacity = header()->capacity;
+        while (capacity < numNodes)
+            capacity *= 2;
+        if (!openMap(true, capacity))
+            return false;
+    }
+
+    uint32_t changed = 0;
+    meshtastic_NodeInfoLite *r = records();
+    for (size_t i = 0; i < numNodes; i++) {
+        if (memcmp(&r[i], &nodes[i], sizeof(r[i])) != 0) {
+            r[i] = nodes[i];
+            changed++;
+        }
+    }
+    header()->count = numNodes;
+
+    // The kernel owns the pages now, they survive us crashing. Just start the writeback.
+    msync(map, mapLen, MS_ASYNC);
+    LOG_DEBUG("Stored %u nodes, %u changed", (unsigned)numNodes, changed);
+    return true;
+}
+
+#endif
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "configuration.h"
+#include "mesh-pb-constants.h"
+#include <vector>
+
+// Linux gateways keep their nodes in a memory mapped file instead of the DeviceState protobuf
+#ifndef NODEDB_MAPPED_STORE
+#ifdef ARCH_PORTDUINO
+#define NODEDB_MAPPED_STORE 1
+#else
+#define NODEDB_MAPPED_STORE 0
+#endif
+#endif
+
+#if NODEDB_MAPPED_STORE
+
+/**
+ * Node storage for portduino: /prefs/nodes.db holds a small header followed by one fixed size record per node, in the same
+ * layout as meshtastic_NodeInfoLite in RAM.
+ *
+ * Loading is a single copy out of the mapping (there is nothing to decode, so it takes milliseconds even for many thousands of
+ * nodes).  Saving only touches the records that differ from what is already mapped, and the kernel writes the dirty pages back
+ * for us.  The file grows (doubling) as the node count grows, so it doesn't need to be sized for maxnodes up front.
+ *
+ * The header records the struct size and DeviceState version, a file written by a build with a different NodeInfoLite layout
+ * is ignored (and the nodes come from the DeviceState protobuf, if it still has them).
+ */
+class MappedNodeStore
+{
+  public:
+    ~MappedNodeStore() { close(); }
+
+    /**
+     * Copy the stored nodes into nodes (at most maxNodes of them).
+     * @return false if there is no usable store, nodes is left untouched in that case
+     */
+    bool load(std::vector<meshtastic_NodeInfoLite> &nodes, pb_size_t &numNodes, size_t maxNodes);
+
+    /// Write the first numNodes nodes, returns false on failure
+    bool save(const std::vector<meshtastic_NodeInfoLite> &nodes, size_t numNodes);
+
+  private:
+    struct Header {
+        uint32_t magic;
+        uint32_t layout; // sizeof(meshtastic_NodeInfoLite) and DEVICESTATE_CUR_VER
+        uint32_t count;
+        uint32_t capacity;
+    };
+
+    int fd = -1;
+    uint8_t *map = NULL;
+    size_t mapLen = 0;
+
+    /// Open (or create) the file and map capacity records
+    bool openMap(bool create, uint32_t capacity = 0);
+    void close();
+
+    static size_t mapSize(uint32_t capacity);
+
+    Header *header() { return (Header *)map; }
+    meshtastic_NodeInfoLite *records() { return (meshtastic_NodeInfoLite *)(map + sizeof(Header)); }
+};
+
+#endif
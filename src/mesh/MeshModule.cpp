@@ -4,6 +4,7 @@
 #include "NodeDB.h"
 #include "configuration.h"
 #include "modules/RoutingModule.h"
+#include <algorithm>
 #include <assert.h>
 
 std::vector<MeshModule *> *MeshModule::modules;
@@ -16,6 +17,15 @@ const meshtastic_MeshPacket *MeshModule::currentRequest;
  */
 meshtastic_MeshPacket *MeshModule::currentReply;
 
+/// The payload decodePayload() decoded last, and what it decoded to
+static struct {
+    const pb_msgdesc_t *fields = NULL;
+    meshtastic_PortNum portnum;
+    pb_size_t size;
+    uint8_t bytes[member_size(meshtastic_Data, payload.bytes)];
+    std::vector<uint8_t> decoded; // grows to the biggest message decoded, then stays
+} payloadCache;
+
 MeshModule::MeshModule(const char *_name) : name(_name)
 {
     // Can't trust static initializer order, so we check each time
@@ -72,6 +82,40 @@ meshtastic_MeshPacket *MeshModule::allocErrorResponse(meshtastic_Routing_Error e
     return r;
 }
 
+bool MeshModule::decodePayload(const meshtastic_MeshPacket &mp, const pb_msgdesc_t *fields, void *dest, size_t size)
+{
+    const meshtastic_Data &p = mp.decoded;
+    if (payloadCache.fields == fields && payloadCache.portnum == p.portnum && payloadCache.size == p.payload.size &&
+        memcmp(payloadCache.bytes, p.payload.bytes, p.payload.size) == 0) {
+        memcpy(dest, payloadCache.decoded.data(), size);
+        return true;
+    }
+
+    memset(dest, 0, size);
+    if (!pb_decode_from_bytes(p.payload.bytes, p.payload.size, fields, dest)) {
+        memset(dest, 0, size);
+        return false;
+    }
+
+    payloadCache.fields = fields;
+    payloadCache.portnum = p.portnum;
+    payloadCache.size = p.payload.size;
+    memcpy(payloadCache.bytes, p.payload.bytes, p.payload.size);
+    payloadCache.decoded.resize(std::max(payloadCache.decoded.size(), size));
+    memcpy(payloadCache.decoded.data(), dest, size);
+    return true;
+}
+
+bool MeshModule::isBoundChannelOk(const meshtastic_MeshPacket &mp)
+{
+    if (resolvedBoundChannel != boundChannel || boundChannelVersion != channels.getVersion()) {
+        boundChannelMask = channels.getMaskByName(boundChannel);
+        resolvedBoundChannel = boundChannel;
+        boundChannelVersion = channels.getVersion();
+    }
+    return mp.channel < MAX_NUM_CHANNELS && (boundChannelMask & (1 << mp.channel));
+}
+
 void MeshModule::callModules(meshtastic_MeshPacket &mp, RxSource src)
 {
     // LOG_DEBUG("In call modules");
@@ -108,16 +152,13 @@ void MeshModule::callModules(meshtastic_MeshPacket &mp, RxSource src)
 
             moduleFound = true;
 
-            /// received channel (or NULL if not decoded)
-            meshtastic_Channel *ch = isDecoded ? &channels.getByIndex(mp.channel) : NULL;
-
             /// Is the channel this packet arrived on acceptable? (security check)
             /// Note: we can't know channel names for encrypted packets, so those are NEVER sent to boundChannel modules
 
             /// Also: if a packet comes in on the local PC interface, we don't check for bound channels, because it is TRUSTED and
             /// it needs to to be able to fetch the initial admin packets without yet knowing any channels.
 
-            bool rxChannelOk = !pi.boundChannel || (mp.from == 0) || (ch && strcasecmp(ch->settings.name, pi.boundChannel) == 0);
+            bool rxChannelOk = !pi.boundChannel || (mp.from == 0) || (isDecoded && pi.isBoundChannelOk(mp));
 
             if (!rxChannelOk) {
                 // no one should have already replied!
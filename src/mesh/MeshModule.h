@@ -130,6 +130,17 @@ class MeshModule
      */
     virtual void setup();
 
+    /**
+     * Decode the payload of mp (which must be decoded) as fields into dest, which is size bytes.
+     *
+     * The last payload decoded is kept, so when several modules look at the same packet (all the telemetry modules get every
+     * TELEMETRY_APP packet, RoutingModule and CannedMessageModule both read acks) only the first one runs the protobuf decoder.
+     * The others get a copy, each caller gets its own because some handlers change the struct they are given.
+     *
+     * @return false if the payload isn't a valid fields message, dest is zeroed in that case
+     */
+    static bool decodePayload(const meshtastic_MeshPacket &mp, const pb_msgdesc_t *fields, void *dest, size_t size);
+
     /**
      * @return true if you want to receive the specified portnum
      */
@@ -198,6 +209,14 @@ class MeshModule
 #endif
 
   private:
+    /// The channels named boundChannel (a bit per channel index), looked up again only when it or the channels change
+    uint8_t boundChannelMask = 0;
+    const char *resolvedBoundChannel = NULL;
+    uint32_t boundChannelVersion = 0;
+
+    /// Could mp (which arrived on a channel, not from the phone) be handed to us, given boundChannel?
+    bool isBoundChannelOk(const meshtastic_MeshPacket &mp);
+
     /**
      * If any of the current chain of modules has already sent a reply, it will be here.  This is useful to allow
      * the RoutingModule to avoid sending redundant acks
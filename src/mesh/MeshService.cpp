@@ -125,7 +125,7 @@ bool MeshService::reloadConfig(int saveWhat)
     bool didReset = nodeDB->resetRadioConfig(); // Don't let the phone send us fatally bad settings
 
     configChanged.notifyObservers(NULL); // This will cause radio hardware to change freqs etc
-    nodeDB->saveToDisk(saveWhat);
+    nodeDB->saveToDiskLater(saveWhat);
 
     return didReset;
 }
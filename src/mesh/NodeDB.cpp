@@ -14,6 +14,7 @@
 #include "RTC.h"
 #include "Router.h"
 #include "SafeFile.h"
+#include "SaveScheduler.h"
 #include "TypeConversions.h"
 #include "error.h"
 #include "main.h"
@@ -142,9 +143,12 @@ uint32_t get_st7789_id(uint8_t cs, uint8_t sck, uint8_t mosi, uint8_t dc, uint8_
 
 #endif
 
+/// Cleared while we save a DeviceState whose nodes are kept somewhere else (MappedNodeStore)
+static bool deviceStateIncludesNodes = true;
+
 bool meshtastic_DeviceState_callback(pb_istream_t *istream, pb_ostream_t *ostream, const pb_field_iter_t *field)
 {
-    if (ostream) {
+    if (ostream && deviceStateIncludesNodes) {
         std::vector<meshtastic_NodeInfoLite> const *vec = (std::vector<meshtastic_NodeInfoLite> *)field->pData;
         for (auto item : *vec) {
             if (!pb_encode_tag_for_field(ostream, field))
@@ -353,6 +357,8 @@ NodeDB::NodeDB()
     }
 #endif
     saveToDisk(saveWhat);
+
+    saveScheduler = new SaveScheduler(this);
 }
 
 /**
@@ -776,6 +782,9 @@ void NodeDB::resetNodes()
     std::fill(devicestate.node_db_lite.begin() + 1, devicestate.node_db_lite.end(), meshtastic_NodeInfoLite());
     devicestate.has_rx_text_message = false;
     devicestate.has_rx_waypoint = false;
+#if NODEDB_JOURNAL
+    journal.invalidate(); // cheaper to write the single remaining node than a removal record for everybody else
+#endif
     saveDeviceStateToDisk();
     if (neighborInfoModule && moduleConfig.neighbor_info.enabled)
         neighborInfoModule->resetNeighbors();
@@ -791,7 +800,7 @@ void NodeDB::removeNodeByNum(NodeNum nodeNum)
             removed++;
     }
     numMeshNodes -= removed;
-    std::fill(devicestate.node_db_lite.begin() + numMeshNodes, devicestate.node_db_lite.begin() + numMeshNodes + 1,
+    std::fill(devicestate.node_db_lite.begin() + numMeshNodes, devicestate.node_db_lite.begin() + numMeshNodes + removed,
               meshtastic_NodeInfoLite());
     LOG_DEBUG("NodeDB::removeNodeByNum purged %d entries. Save changes", removed);
     saveDeviceStateToDisk();
@@ -944,6 +953,7 @@ void NodeDB::loadFromDisk()
     // static DeviceState scratch; We no longer read into a tempbuf because this structure is 15KB of valuable RAM
     auto state = loadProto(prefFileName, sizeof(meshtastic_DeviceState) + MAX_NUM_NODES_FS * sizeof(meshtastic_NodeInfo),
                            sizeof(meshtastic_DeviceState), &meshtastic_DeviceState_msg, &devicestate);
+    bool snapshotValid = state == LoadFileResult::LOAD_SUCCESS && devicestate.version >= DEVICESTATE_MIN_VER;
 
     // See https://github.com/meshtastic/firmware/issues/4184#issuecomment-2269390786
     // It is very important to try and use the saved prefs even if we fail to read meshtastic_DeviceState.  Because most of our
@@ -961,11 +971,35 @@ void NodeDB::loadFromDisk()
         meshNodes = &devicestate.node_db_lite;
         numMeshNodes = devicestate.node_db_lite.size();
     }
+#if NODEDB_MAPPED_STORE
+    // If the DeviceState still has nodes we just upgraded from a build without the store, they get moved there at the next save
+    if (snapshotValid)
+        nodeStore.load(*meshNodes, numMeshNodes, MAX_NUM_NODES);
+#endif
     if (numMeshNodes > MAX_NUM_NODES) {
         LOG_WARN("Node count %d exceeds MAX_NUM_NODES %d, truncating", numMeshNodes, MAX_NUM_NODES);
         numMeshNodes = MAX_NUM_NODES;
     }
+#ifdef ARCH_PORTDUINO
+    // maxnodes can be huge here. Only reserve the address space, so nodes never move, but the pages only become real memory
+    // once nodes land on them
+    meshNodes->reserve(MAX_NUM_NODES);
+    meshNodes->resize(numMeshNodes);
+#else
     meshNodes->resize(MAX_NUM_NODES);
+#endif
+
+#if NODEDB_JOURNAL
+    // Bring the snapshot up to date with the changes journaled since it was written. If there is no usable snapshot the
+    // journal is meaningless too, the next save will write a new snapshot (and remove the journal)
+    uint32_t snapshotCrc = snapshotValid ? NodeJournal::fileCrc(prefFileName) : 0;
+    bool journalValid = snapshotValid && journal.replay(*meshNodes, numMeshNodes, snapshotCrc);
+    journal.rebase(*meshNodes, numMeshNodes, deviceStateHeaderCrc(), snapshotCrc);
+    if (!journalValid)
+        journal.invalidate();
+#else
+    (void)snapshotValid;
+#endif
 
     state = loadProto(configFileName, meshtastic_LocalConfig_size, sizeof(meshtastic_LocalConfig), &meshtastic_LocalConfig_msg,
                       &config);
@@ -1114,15 +1148,89 @@ bool NodeDB::saveChannelsToDisk()
     return saveProto(channelFileName, meshtastic_ChannelFile_size, &meshtastic_ChannelFile_msg, &channelFile);
 }
 
+#if NODEDB_JOURNAL
+static bool crcWriteCallback(pb_ostream_t *stream, const uint8_t *buf, size_t count)
+{
+    uint32_t *crc = (uint32_t *)stream->state;
+    *crc = crc32Update(buf, count, *crc);
+    return true;
+}
+
+uint32_t NodeDB::deviceStateHeaderCrc()
+{
+    // The crc of what we would encode (not of the struct, its padding isn't stable), without the nodes and without the last
+    // received text message and waypoint: those change with every message and would turn every save into a snapshot, they
+    // are saved with the next one instead
+    bool hasTextMessage = devicestate.has_rx_text_message, hasWaypoint = devicestate.has_rx_waypoint;
+    devicestate.has_rx_text_message = false;
+    devicestate.has_rx_waypoint = false;
+    deviceStateIncludesNodes = false;
+
+    uint32_t crc = CRC32_INITIAL;
+    pb_ostream_t stream = {&crcWriteCallback, &crc, SIZE_MAX};
+    pb_encode(&stream, &meshtastic_DeviceState_msg, &devicestate);
+
+    deviceStateIncludesNodes = true;
+    devicestate.has_rx_text_message = hasTextMessage;
+    devicestate.has_rx_waypoint = hasWaypoint;
+    return crc32Final(crc);
+}
+#endif
+
 bool NodeDB::saveDeviceStateToDisk()
 {
 #ifdef FSCom
     FSCom.mkdir("/prefs");
 #endif
+#if NODEDB_JOURNAL
+    // Usually only a few nodes changed, just append those to the journal
+    uint32_t headerCrc = deviceStateHeaderCrc();
+    {
+#ifdef ARCH_ESP32
+        concurrency::LockGuard g(spiLock);
+#endif
+        if (journal.canAppend(headerCrc) && journal.append(*meshNodes, numMeshNodes))
+            return true;
+    }
+
+    // The old snapshot and journal stay valid until the new snapshot has replaced the old one, and if we lose power before
+    // the journal is removed replay sees it belongs to the old snapshot
+    bool okay = saveDeviceStateSnapshot(true);
+    if (!okay) {
+        // Probably no room for two copies (nrf52 with a full NodeDB), replace it in place like we did before the journal
+        LOG_WARN("Can't replace %s atomically, rewrite it in place", prefFileName);
+        journal.remove();
+        okay = saveDeviceStateSnapshot(false);
+    }
+    if (okay) {
+#ifdef ARCH_ESP32
+        concurrency::LockGuard g(spiLock);
+#endif
+        journal.remove();
+        journal.rebase(*meshNodes, numMeshNodes, headerCrc, NodeJournal::fileCrc(prefFileName));
+    }
+    return okay;
+#else
+    return saveDeviceStateSnapshot(false);
+#endif
+}
+
+bool NodeDB::saveDeviceStateSnapshot(bool fullAtomic)
+{
+#if NODEDB_MAPPED_STORE
+    // The nodes go to their own file, the DeviceState left is small enough to replace atomically
+    (void)fullAtomic;
+    bool nodesSaved = nodeStore.save(*meshNodes, numMeshNodes);
+    deviceStateIncludesNodes = false;
+    bool okay = saveProto(prefFileName, sizeof(devicestate), &meshtastic_DeviceState_msg, &devicestate, true);
+    deviceStateIncludesNodes = true;
+    return nodesSaved && okay;
+#else
     // Note: if MAX_NUM_NODES=100 and meshtastic_NodeInfoLite_size=166, so will be approximately 17KB
-    // Because so huge we _must_ not use fullAtomic, because the filesystem is probably too small to hold two copies of this
+    // Because so huge the filesystem might be too small to hold two copies of this, so !fullAtomic is still needed as fallback
     return saveProto(prefFileName, sizeof(devicestate) + numMeshNodes * meshtastic_NodeInfoLite_size, &meshtastic_DeviceState_msg,
-                     &devicestate, false);
+                     &devicestate, fullAtomic);
+#endif
 }
 
 bool NodeDB::saveToDiskNoRetry(int saveWhat)
@@ -1176,6 +1284,9 @@ bool NodeDB::saveToDiskNoRetry(int saveWhat)
 
 bool NodeDB::saveToDisk(int saveWhat)
 {
+    if (saveScheduler)
+        saveScheduler->clear(saveWhat);
+
     bool success = saveToDiskNoRetry(saveWhat);
 
     if (!success) {
@@ -1193,6 +1304,19 @@ bool NodeDB::saveToDisk(int saveWhat)
     return success;
 }
 
+void NodeDB::saveToDiskLater(int saveWhat)
+{
+    if (saveScheduler)
+        saveScheduler->request(saveWhat);
+    else
+        saveToDisk(saveWhat);
+}
+
+bool NodeDB::flushPendingSaves()
+{
+    return saveScheduler ? saveScheduler->flush() : true;
+}
+
 const meshtastic_NodeInfoLite *NodeDB::readNextMeshNode(uint32_t &readIndex)
 {
     if (readIndex < numMeshNodes)
@@ -1284,7 +1408,7 @@ void NodeDB::updatePosition(uint32_t nodeId, const meshtastic_Position &p, RxSou
             info->position.time = tmp_time;
     }
     info->has_position = true;
-    updateGUIforNode = info;
+    updateGUIforNode = info->num;
     notifyObservers(true); // Force an update whether or not our node counts have changed
 }
 
@@ -1307,7 +1431,7 @@ void NodeDB::updateTelemetry(uint32_t nodeId, const meshtastic_Telemetry &t, RxS
     }
     info->device_metrics = t.variant.device_metrics;
     info->has_device_metrics = true;
-    updateGUIforNode = info;
+    updateGUIforNode = info->num;
     notifyObservers(true); // Force an update whether or not our node counts have changed
 }
 
@@ -1348,7 +1472,7 @@ bool NodeDB::updateUser(uint32_t nodeId, meshtastic_User &p, uint8_t channelInde
     info->has_user = true;
 
     if (changed) {
-        updateGUIforNode = info;
+        updateGUIforNode = info->num;
         powerFSM.trigger(EVENT_NODEDB_UPDATED);
         notifyObservers(true); // Force an update whether or not our node counts have changed
 
@@ -1460,6 +1584,8 @@ meshtastic_NodeInfoLite *NodeDB::getOrCreateMeshNode(NodeNum n)
             }
         }
         // add the node at the end
+        if (numMeshNodes >= meshNodes->size())
+            meshNodes->resize(numMeshNodes + 1); // within the reserved capacity, so existing nodes don't move
         lite = &meshNodes->at((numMeshNodes)++);
 
         // everything is missing except the nodenum
@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "MeshTypes.h"
+#include "NodeJournal.h"
 #include "NodeStatus.h"
 #include "configuration.h"
 #include "mesh-pb-constants.h"
@@ -25,6 +26,8 @@ DeviceState versions used to be defined in the .proto file but really only this
 #define DEVICESTATE_CUR_VER 23
 #define DEVICESTATE_MIN_VER 22
 
+class SaveScheduler;
+
 extern meshtastic_DeviceState devicestate;
 extern meshtastic_ChannelFile channelFile;
 extern meshtastic_MyNodeInfo &myNodeInfo;
@@ -64,7 +67,7 @@ class NodeDB
   public:
     std::vector<meshtastic_NodeInfoLite> *meshNodes;
     bool updateGUI = false; // we think the gui should definitely be redrawn, screen will clear this once handled
-    meshtastic_NodeInfoLite *updateGUIforNode = NULL; // if currently showing this node, we think you should update the GUI
+    NodeNum updateGUIforNode = 0; // if currently showing this node, we think you should update the GUI
     Observable<const meshtastic::NodeStatus *> newStatus;
     pb_size_t numMeshNodes;
 
@@ -76,6 +79,15 @@ class NodeDB
     /// @return true if the save was successful
     bool saveToDisk(int saveWhat = SEGMENT_CONFIG | SEGMENT_MODULECONFIG | SEGMENT_DEVICESTATE | SEGMENT_CHANNELS);
 
+    /// write to flash a little later, merged with any other saves requested in the meantime (see SaveScheduler)
+    void saveToDiskLater(int saveWhat = SEGMENT_CONFIG | SEGMENT_MODULECONFIG | SEGMENT_DEVICESTATE | SEGMENT_CHANNELS);
+
+    /// write any saves requested with saveToDiskLater() right now, call before rebooting or shutting down
+    /// @return true if the save was successful (or there was nothing to save)
+    bool flushPendingSaves();
+
+    SaveScheduler *getSaveScheduler() { return saveScheduler; }
+
     /** Reinit radio config if needed, because either:
      * a) sometimes a buggy android app might send us bogus settings or
      * b) the client set factory_reset
@@ -169,6 +181,18 @@ class NodeDB
 
   private:
     uint32_t lastNodeDbSave = 0; // when we last saved our db to flash
+    SaveScheduler *saveScheduler = NULL;
+#if NODEDB_MAPPED_STORE
+    /// Where the nodes live instead of the DeviceState protobuf
+    MappedNodeStore nodeStore;
+#endif
+#if NODEDB_JOURNAL
+    /// Changes to the node list since the last full DeviceState snapshot
+    NodeJournal journal;
+
+    /// crc32 of everything in the DeviceState except the node list and the last received text message/waypoint
+    uint32_t deviceStateHeaderCrc();
+#endif
     /// Find a node in our DB, create an empty NodeInfoLite if missing
     meshtastic_NodeInfoLite *getOrCreateMeshNode(NodeNum n);
 
@@ -196,6 +220,9 @@ class NodeDB
 
     bool saveChannelsToDisk();
     bool saveDeviceStateToDisk();
+
+    /// Rewrite the whole DeviceState (including every node), fullAtomic needs room for a second copy of it
+    bool saveDeviceStateSnapshot(bool fullAtomic);
 };
 
 extern NodeDB *nodeDB;
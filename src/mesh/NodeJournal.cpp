@@ -0,0 +1,249 @@
+#include "NodeJournal.h"
+
+#ifdef FSCom
+
+#include <ErriezCRC32.h>
+#include <algorithm>
+#include <pb_decode.h>
+#include <pb_encode.h>
+
+static const char *journalFileName = "/prefs/nodes.jnl";
+
+#define JOURNAL_MAGIC 0xA7
+#define JOURNAL_PUT 1  // payload is an encoded NodeInfoLite
+#define JOURNAL_DEL 2  // payload is the NodeNum, little endian
+#define JOURNAL_BASE 3 // payload is the crc32 of the snapshot file this journal applies to, little endian, always first
+
+#define JOURNAL_HEADER_LEN 8
+
+static bool crcWriteCallback(pb_ostream_t *stream, const uint8_t *buf, size_t count)
+{
+    uint32_t *crc = (uint32_t *)stream->state;
+    *crc = crc32Update(buf, count, *crc);
+    return true;
+}
+
+uint32_t NodeJournal::nodeCrc(const meshtastic_NodeInfoLite &node)
+{
+    // Of the encoded node, the struct's padding isn't stable and would make unchanged nodes look changed
+    uint32_t crc = CRC32_INITIAL;
+    pb_ostream_t stream = {&crcWriteCallback, &crc, SIZE_MAX};
+    pb_encode(&stream, &meshtastic_NodeInfoLite_msg, &node);
+    return crc32Final(crc);
+}
+
+uint32_t NodeJournal::fileCrc(const char *filename)
+{
+    auto f = FSCom.open(filename, FILE_O_READ);
+    if (!f)
+        return 0;
+
+    uint8_t buf[64];
+    int n;
+    uint32_t crc = CRC32_INITIAL;
+    while ((n = f.read(buf, sizeof(buf))) > 0)
+        crc = crc32Update(buf, n, crc);
+    f.close();
+    return crc32Final(crc);
+}
+
+std::vector<NodeJournal::PersistedNode>::iterator NodeJournal::findPersisted(NodeNum num)
+{
+    return std::lower_bound(persisted.begin(), persisted.end(), num,
+                            [](const PersistedNode &p, NodeNum n) { return p.num < n; });
+}
+
+static void putLe32(uint8_t *buf, uint32_t v)
+{
+    for (int b = 0; b < 4; b++)
+        buf[b] = (uint8_t)(v >> (8 * b));
+}
+
+static uint32_t getLe32(const uint8_t *buf)
+{
+    return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+static bool writeRecord(File &f, uint8_t type, const uint8_t *payload, uint16_t len)
+{
+    uint32_t crc = crc32Buffer(payload, len);
+    uint8_t header[JOURNAL_HEADER_LEN] = {JOURNAL_MAGIC, type, (uint8_t)(len & 0xff), (uint8_t)(len >> 8)};
+    putLe32(header + 4, crc);
+    return f.write(header, sizeof(header)) == sizeof(header) && f.write(payload, len) == len;
+}
+
+bool NodeJournal::append(const std::vector<meshtastic_NodeInfoLite> &nodes, size_t numNodes)
+{
+    // Usually only a handful of nodes changed, so we only keep track of those (and of which persisted nodes we still have)
+    std::vector<bool> seen(persisted.size(), false);
+    std::vector<size_t> changed;
+    std::vector<NodeNum> removed;
+
+    for (size_t i = 0; i < numNodes; i++) {
+        auto old = findPersisted(nodes[i].num);
+        if (old != persisted.end() && old->num == nodes[i].num) {
+            seen[old - persisted.begin()] = true;
+            if (old->crc == nodeCrc(nodes[i]))
+                continue;
+        }
+        changed.push_back(i);
+    }
+    for (size_t i = 0; i < persisted.size(); i++)
+        if (!seen[i])
+            removed.push_back(persisted[i].num);
+
+    if (changed.empty() && removed.empty())
+        return true;
+
+    auto f = FSCom.open(journalFileName, FILE_O_APPEND);
+    bool ok = (bool)f;
+    uint32_t written = 0;
+    uint8_t buf[meshtastic_NodeInfoLite_size];
+
+    if (ok && bytes == 0) {
+        // A new journal, say which snapshot it belongs to
+        putLe32(buf, baseSnapshotCrc);
+        ok = writeRecord(f, JOURNAL_BASE, buf, 4);
+        written += JOURNAL_HEADER_LEN + 4;
+    }
+    for (size_t i = 0; ok && i < changed.size(); i++) {
+        size_t len = pb_encode_to_bytes(buf, sizeof(buf), &meshtastic_NodeInfoLite_msg, &nodes[changed[i]]);
+        ok = len > 0 && writeRecord(f, JOURNAL_PUT, buf, len);
+        written += JOURNAL_HEADER_LEN + len;
+    }
+    for (size_t i = 0; ok && i < removed.size(); i++) {
+        putLe32(buf, removed[i]);
+        ok = writeRecord(f, JOURNAL_DEL, buf, 4);
+        written += JOURNAL_HEADER_LEN + 4;
+    }
+    if (f)
+        f.close();
+
+    if (!ok) {
+        LOG_ERROR("Can't append to %s, will write a full snapshot", journalFileName);
+        needsSnapshot = true;
+        return false;
+    }
+
+    for (size_t i : changed) {
+        uint32_t crc = nodeCrc(nodes[i]);
+        auto it = findPersisted(nodes[i].num);
+        if (it != persisted.end() && it->num == nodes[i].num)
+            it->crc = crc;
+        else
+            persisted.insert(it, {nodes[i].num, crc});
+    }
+    for (NodeNum num : removed)
+        persisted.erase(findPersisted(num));
+
+    bytes += written;
+    recordsWritten += changed.size() + removed.size();
+    LOG_INFO("Journaled %u changed and %u removed nodes (%u bytes, journal now %u bytes)", (unsigned)changed.size(),
+             (unsigned)removed.size(), written, bytes);
+    return true;
+}
+
+void NodeJournal::rebase(const std::vector<meshtastic_NodeInfoLite> &nodes, size_t numNodes, uint32_t headerCrc,
+                         uint32_t snapshotCrc)
+{
+    persisted.clear();
+    persisted.reserve(numNodes);
+    for (size_t i = 0; i < numNodes; i++)
+        persisted.push_back({nodes[i].num, nodeCrc(nodes[i])});
+    std::sort(persisted.begin(), persisted.end(), [](const PersistedNode &a, const PersistedNode &b) { return a.num < b.num; });
+
+    baseHeaderCrc = headerCrc;
+    baseSnapshotCrc = snapshotCrc;
+    needsSnapshot = false;
+}
+
+void NodeJournal::remove()
+{
+    if (FSCom.exists(journalFileName))
+        FSCom.remove(journalFileName);
+    bytes = 0;
+}
+
+bool NodeJournal::replay(std::vector<meshtastic_NodeInfoLite> &nodes, pb_size_t &numNodes, uint32_t snapshotCrc)
+{
+    bytes = 0;
+    if (!FSCom.exists(journalFileName))
+        return true;
+    auto f = FSCom.open(journalFileName, FILE_O_READ);
+    if (!f)
+        return false;
+
+    uint32_t applied = 0;
+    uint32_t offset = 0;
+    bool haveBase = false;
+    bool torn = false;
+    uint8_t header[JOURNAL_HEADER_LEN];
+    uint8_t buf[meshtastic_NodeInfoLite_size];
+
+    while (f.available()) {
+        if (f.read(header, sizeof(header)) != (int)sizeof(header) || header[0] != JOURNAL_MAGIC) {
+            torn = true;
+            break;
+        }
+        uint16_t len = header[2] | (header[3] << 8);
+        uint32_t crc = header[4] | (header[5] << 8) | (header[6] << 16) | ((uint32_t)header[7] << 24);
+        if (len > sizeof(buf) || f.read(buf, len) != (int)len || crc32Buffer(buf, len) != crc) {
+            torn = true;
+            break;
+        }
+        offset += sizeof(header) + len;
+
+        if (!haveBase) {
+            // The first record must say which snapshot we belong to
+            if (header[1] != JOURNAL_BASE || len != 4) {
+                torn = true;
+                break;
+            }
+            if (getLe32(buf) != snapshotCrc) {
+                // We lost power after the new snapshot was written but before this journal was removed, it is already in
+                // the snapshot
+                f.close();
+                LOG_INFO("%s belongs to an older snapshot, remove it", journalFileName);
+                remove();
+                return true;
+            }
+            haveBase = true;
+            continue;
+        }
+
+        if (header[1] == JOURNAL_PUT) {
+            meshtastic_NodeInfoLite node = meshtastic_NodeInfoLite_init_default;
+            if (!pb_decode_from_bytes(buf, len, &meshtastic_NodeInfoLite_msg, &node)) {
+                torn = true;
+                break;
+            }
+            pb_size_t i = 0;
+            while (i < numNodes && nodes[i].num != node.num)
+                i++;
+            if (i < numNodes)
+                nodes[i] = node;
+            else if (numNodes < nodes.size())
+                nodes[numNodes++] = node;
+            else
+                LOG_WARN("NodeDB full, can't replay node 0x%x", node.num);
+        } else if (header[1] == JOURNAL_DEL && len == 4) {
+            NodeNum n = getLe32(buf);
+            pb_size_t newPos = 0;
+            for (pb_size_t i = 0; i < numNodes; i++)
+                if (nodes[i].num != n)
+                    nodes[newPos++] = nodes[i];
+            std::fill(nodes.begin() + newPos, nodes.begin() + numNodes, meshtastic_NodeInfoLite());
+            numNodes = newPos;
+        }
+        applied++;
+    }
+    f.close();
+
+    bytes = offset;
+    LOG_INFO("Replayed %u node journal records", applied);
+    if (torn)
+        LOG_WARN("%s is damaged after %u bytes, ignore the rest", journalFileName, offset);
+    return !torn;
+}
+
+#endif
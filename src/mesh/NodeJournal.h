@@ -0,0 +1,101 @@
+#pragma once
+
+#include "FSCommon.h"
+#include "MappedNodeStore.h"
+#include "MeshTypes.h"
+#include "configuration.h"
+#include "mesh-pb-constants.h"
+#include <vector>
+
+#ifndef NODEDB_JOURNAL
+#if defined(FSCom) && !NODEDB_MAPPED_STORE // the mapped store only writes changed nodes already
+#define NODEDB_JOURNAL 1
+#else
+#define NODEDB_JOURNAL 0
+#endif
+#endif
+
+// Once the journal gets this big we rewrite the whole DeviceState and start a new one
+#ifndef NODEDB_JOURNAL_MAX_BYTES
+#define NODEDB_JOURNAL_MAX_BYTES (8 * 1024)
+#endif
+
+// NodeDB only uses it if NODEDB_JOURNAL, but it is built wherever there is a filesystem so it can be tested on its own
+#ifdef FSCom
+
+/**
+ * Append-only journal of NodeDB changes, kept next to the DeviceState snapshot (/prefs/db.proto).
+ *
+ * Saving the DeviceState used to rewrite every node, now we only append a record for each node that changed (or was removed)
+ * since the last save.  Once the journal grows past NODEDB_JOURNAL_MAX_BYTES, or anything outside of the node list changed, the
+ * caller writes a new snapshot and calls rebase().  At boot the journal is replayed over the snapshot.
+ *
+ * Each record is a small header (magic, type, length, crc32 of the payload) followed by an encoded NodeInfoLite (or just the
+ * node number for removals).  A record that was only partially written when we lost power fails its crc, replay stops there
+ * and we ask for a new snapshot.  The first record names the snapshot (by the crc32 of its file) the journal applies to, so
+ * if we lose power between writing a new snapshot and removing the old journal, the old journal is recognised as stale.
+ *
+ * Changes are found by comparing a crc32 of each node with the one it had when last persisted, so code that changes a node
+ * directly (admin favorites, ignores...) doesn't need to remember to mark anything.
+ */
+class NodeJournal
+{
+  public:
+    /**
+     * Could we save with append() instead of a full snapshot?
+     * @param headerCrc crc of everything in the DeviceState except the node list, see NodeDB::deviceStateHeaderCrc()
+     */
+    bool canAppend(uint32_t headerCrc) const
+    {
+        return !needsSnapshot && headerCrc == baseHeaderCrc && bytes < NODEDB_JOURNAL_MAX_BYTES;
+    }
+
+    /// Append records for every node that changed since the last save. Returns false if that failed and we need a snapshot.
+    bool append(const std::vector<meshtastic_NodeInfoLite> &nodes, size_t numNodes);
+
+    /**
+     * Remember what is on disk now (snapshot + journal), after we wrote a snapshot or replayed the journal at boot
+     * @param snapshotCrc fileCrc() of the snapshot, later appends are only valid on top of that one
+     */
+    void rebase(const std::vector<meshtastic_NodeInfoLite> &nodes, size_t numNodes, uint32_t headerCrc, uint32_t snapshotCrc);
+
+    /// Drop the journal file once a new snapshot has been written, it is already part of that snapshot
+    void remove();
+
+    /**
+     * Apply the journal to the nodes just loaded from the snapshot.  A journal written on top of another snapshot is removed.
+     * @return false if the journal was damaged (e.g. we lost power while appending), anything appended after the damage would
+     * never be replayed, so the caller must invalidate() to get a new snapshot
+     */
+    bool replay(std::vector<meshtastic_NodeInfoLite> &nodes, pb_size_t &numNodes, uint32_t snapshotCrc);
+
+    /// Force the next save to be a full snapshot (e.g. after resetNodes())
+    void invalidate() { needsSnapshot = true; }
+
+    /// crc32 of a whole file, 0 if it doesn't exist
+    static uint32_t fileCrc(const char *filename);
+
+    /// Stats for the log
+    uint32_t getBytes() const { return bytes; }
+    uint32_t getRecordsWritten() const { return recordsWritten; }
+
+  private:
+    /// crc32 of each node as it is on disk (snapshot + journal), sorted by node number
+    struct PersistedNode {
+        NodeNum num;
+        uint32_t crc;
+    };
+    std::vector<PersistedNode> persisted;
+
+    uint32_t baseHeaderCrc = 0;
+    uint32_t baseSnapshotCrc = 0;
+    uint32_t bytes = 0;
+    uint32_t recordsWritten = 0;
+    bool needsSnapshot = true; // until we know what is on disk
+
+    std::vector<PersistedNode>::iterator findPersisted(NodeNum num);
+
+    static uint32_t nodeCrc(const meshtastic_NodeInfoLite &node);
+};
+
+#endif
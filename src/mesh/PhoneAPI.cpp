@@ -509,6 +509,19 @@ void PhoneAPI::releaseClientNotification()
     }
 }
 
+size_t PhoneAPI::getFromRadioFramed(uint8_t *buf)
+{
+    size_t len = getFromRadio(buf + STREAM_HEADER_LEN);
+    if (len == 0)
+        return 0;
+
+    buf[0] = STREAM_START1;
+    buf[1] = STREAM_START2;
+    buf[2] = (len >> 8) & 0xff;
+    buf[3] = len & 0xff;
+    return len + STREAM_HEADER_LEN;
+}
+
 /**
  * Return true if we have data available to send to the phone
  */
@@ -11,6 +11,12 @@
 // Make sure that we never let our packets grow too large for one BLE packet
 #define MAX_TO_FROM_RADIO_SIZE 512
 
+// What the serial and TCP APIs (and the framed HTTP API) put in front of each ToRadio/FromRadio: two magic bytes, then the length
+// (big endian)
+#define STREAM_START1 0x94
+#define STREAM_START2 0xc3
+#define STREAM_HEADER_LEN 4
+
 #if meshtastic_FromRadio_size > MAX_TO_FROM_RADIO_SIZE
 #error "meshtastic_FromRadio_size is too large for our BLE packets"
 #endif
@@ -118,6 +124,13 @@ class PhoneAPI
      */
     size_t getFromRadio(uint8_t *buf);
 
+    /**
+     * Like getFromRadio(), but with the stream API header in front, so a client can take several from one HTTP response.
+     * We assume buf is at least STREAM_HEADER_LEN + FromRadio_size bytes long.
+     * Returns the number of bytes including the header (or 0 if no packet available)
+     */
+    size_t getFromRadioFramed(uint8_t *buf);
+
     void sendConfigComplete();
 
     /**
@@ -87,8 +87,7 @@ template <class T> class ProtobufModule : protected SinglePortModule
         T scratch;
         T *decoded = NULL;
         if (mp.which_payload_variant == meshtastic_MeshPacket_decoded_tag && mp.decoded.portnum == ourPortNum) {
-            memset(&scratch, 0, sizeof(scratch));
-            if (pb_decode_from_bytes(p.payload.bytes, p.payload.size, fields, &scratch)) {
+            if (decodePayload(mp, fields, &scratch, sizeof(scratch))) {
                 decoded = &scratch;
             } else {
                 LOG_ERROR("Error decoding proto module!");
@@ -107,9 +106,7 @@ template <class T> class ProtobufModule : protected SinglePortModule
         T scratch;
         T *decoded = NULL;
         if (mp.which_payload_variant == meshtastic_MeshPacket_decoded_tag && mp.decoded.portnum == ourPortNum) {
-            memset(&scratch, 0, sizeof(scratch));
-            const meshtastic_Data &p = mp.decoded;
-            if (pb_decode_from_bytes(p.payload.bytes, p.payload.size, fields, &scratch)) {
+            if (decodePayload(mp, fields, &scratch, sizeof(scratch))) {
                 decoded = &scratch;
             } else {
                 LOG_ERROR("Error decoding proto module!");
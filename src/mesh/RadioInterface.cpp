@@ -162,8 +162,6 @@ const RegionInfo regions[] = {
 const RegionInfo *myRegion;
 bool RadioInterface::uses_default_frequency_slot = true;
 
-static uint8_t bytes[MAX_LORA_PAYLOAD_LEN + 1];
-
 void initRegion()
 {
     const RegionInfo *r = regions;
@@ -190,30 +188,13 @@ The band is from 902 to 928 MHz. It mentions channel number and its respective c
 separated by 2.16 MHz with respect to the adjacent channels. Channel zero starts at 903.08 MHz center frequency.
 */
 
-/**
- * Calculate airtime per
- * https://www.rs-online.com/designspark/rel-assets/ds-assets/uploads/knowledge-items/application-notes-for-the-internet-of-things/LoRa%20Design%20Guide.pdf
- * section 4
- *
- * @return num msecs for the packet
- */
 uint32_t RadioInterface::getPacketTime(uint32_t pl)
 {
-    float bandwidthHz = bw * 1000.0f;
-    bool headDisable = false; // we currently always use the header
-    float tSym = (1 << sf) / bandwidthHz;
-
-    bool lowDataOptEn = tSym > 16e-3 ? true : false; // Needed if symbol time is >16ms
+    // Some chips change the preamble length after applyModemConfig()
+    if (!airtimeTable.matches(bw, sf, cr, preambleLength))
+        airtimeTable.build(bw, sf, cr, preambleLength);
 
-    float tPreamble = (preambleLength + 4.25f) * tSym;
-    float numPayloadSym =
-        8 + max(ceilf(((8.0f * pl - 4 * sf + 28 + 16 - 20 * headDisable) / (4 * (sf - 2 * lowDataOptEn))) * cr), 0.0f);
-    float tPayload = numPayloadSym * tSym;
-    float tPacket = tPreamble + tPayload;
-
-    uint32_t msecs = tPacket * 1000;
-
-    return msecs;
+    return airtimeTable.getMsec(pl);
 }
 
 uint32_t RadioInterface::getPacketTime(const meshtastic_MeshPacket *p)
@@ -222,7 +203,8 @@ uint32_t RadioInterface::getPacketTime(const meshtastic_MeshPacket *p)
     if (p->which_payload_variant == meshtastic_MeshPacket_encrypted_tag) {
         pl = p->encrypted.size + sizeof(PacketHeader);
     } else {
-        size_t numbytes = pb_encode_to_bytes(bytes, sizeof(bytes), &meshtastic_Data_msg, &p->decoded);
+        size_t numbytes = 0;
+        pb_get_encoded_size(&numbytes, &meshtastic_Data_msg, &p->decoded);
         pl = numbytes + sizeof(PacketHeader);
     }
     return getPacketTime(pl);
@@ -231,52 +213,72 @@ uint32_t RadioInterface::getPacketTime(const meshtastic_MeshPacket *p)
 /** The delay to use for retransmitting dropped packets */
 uint32_t RadioInterface::getRetransmissionMsec(const meshtastic_MeshPacket *p)
 {
-    size_t numbytes = pb_encode_to_bytes(bytes, sizeof(bytes), &meshtastic_Data_msg, &p->decoded);
-    uint32_t packetAirtime = getPacketTime(numbytes + sizeof(PacketHeader));
+    return getRetransmissionMsec(getPacketTime(p));
+}
+
+uint32_t RadioInterface::getRetransmissionMsec(uint32_t packetAirtime)
+{
     // Make sure enough time has elapsed for this packet to be sent and an ACK is received.
     // LOG_DEBUG("Waiting for flooding message with airtime %d and slotTime is %d", packetAirtime, slotTimeMsec);
-    float channelUtil = airTime->channelUtilizationPercent();
-    uint8_t CWsize = map(channelUtil, 0, 100, CWmin, CWmax);
+    uint8_t CWsize = getCWsize();
     // Assuming we pick max. of CWsize and there will be a client with SNR at half the range
     return 2 * packetAirtime + (pow(2, CWsize) + 2 * CWmax + pow(2, int((CWmax + CWmin) / 2))) * slotTimeMsec +
            PROCESSING_TIME_MSEC;
 }
 
+static long arduinoRandom(long lo, long hi)
+{
+    return random(lo, hi);
+}
+
 /** The delay to use when we want to send something */
 uint32_t RadioInterface::getTxDelayMsec()
 {
     /** We wait a random multiple of 'slotTimes' (see definition in header file) in order to avoid collisions.
     The pool to take a random multiple from is the contention window (CW), which size depends on the
     current channel utilization. */
-    float channelUtil = airTime->channelUtilizationPercent();
-    uint8_t CWsize = map(channelUtil, 0, 100, CWmin, CWmax);
-    // LOG_DEBUG("Current channel utilization is %f so setting CWsize to %d", channelUtil, CWsize);
-    return random(0, pow(2, CWsize)) * slotTimeMsec;
+    uint8_t CWsize = getCWsize();
+    // LOG_DEBUG("Set CWsize to %d", CWsize);
+    return computeTxDelayMsec(CWsize, slotTimeMsec, arduinoRandom);
 }
 
-/** The delay to use when we want to flood a message */
-uint32_t RadioInterface::getTxDelayMsecWeighted(float snr)
+/** The contention window size for how busy the channel is right now */
+uint8_t RadioInterface::getCWsize()
 {
-    // The minimum value for a LoRa SNR
-    const uint32_t SNR_MIN = -20;
+    // The last minute alone smooths over bursts, so a burst in the last few seconds also widens the window
+    return computeCWsize(max(airTime->busyPercent(AIRTIME_WINDOW_MEDIUM_MSEC), airTime->channelUtilizationPercent()));
+}
+
+uint8_t RadioInterface::computeCWsize(float channelUtil)
+{
+    return map(channelUtil, 0, 100, CWmin, CWmax);
+}
+
+uint8_t RadioInterface::computeCWsizeWeighted(float snr)
+{
+    // The minimum value for a LoRa SNR (signed, so map() works where long is 64 bit)
+    const int32_t SNR_MIN = -20;
 
     // The maximum value for a LoRa SNR
-    const uint32_t SNR_MAX = 15;
+    const int32_t SNR_MAX = 15;
 
     //  high SNR = large CW size (Long Delay)
     //  low SNR = small CW size (Short Delay)
-    uint32_t delay = 0;
-    uint8_t CWsize = map(snr, SNR_MIN, SNR_MAX, CWmin, CWmax);
+    return map(snr, SNR_MIN, SNR_MAX, CWmin, CWmax);
+}
+
+/** The delay to use when we want to flood a message */
+uint32_t RadioInterface::getTxDelayMsecWeighted(float snr)
+{
+    uint8_t CWsize = computeCWsizeWeighted(snr);
     // LOG_DEBUG("rx_snr of %f so setting CWsize to:%d", snr, CWsize);
-    if (config.device.role == meshtastic_Config_DeviceConfig_Role_ROUTER ||
-        config.device.role == meshtastic_Config_DeviceConfig_Role_REPEATER) {
-        delay = random(0, 2 * CWsize) * slotTimeMsec;
+    bool isRouter = config.device.role == meshtastic_Config_DeviceConfig_Role_ROUTER ||
+                    config.device.role == meshtastic_Config_DeviceConfig_Role_REPEATER;
+    uint32_t delay = computeTxDelayMsecWeighted(CWsize, isRouter, slotTimeMsec, arduinoRandom);
+    if (isRouter)
         LOG_DEBUG("rx_snr found in packet. Router: setting tx delay:%d", delay);
-    } else {
-        // offset the maximum delay for routers: (2 * CWmax * slotTimeMsec)
-        delay = (2 * CWmax * slotTimeMsec) + random(0, pow(2, CWsize)) * slotTimeMsec;
+    else
         LOG_DEBUG("rx_snr found in packet. Setting tx delay:%d", delay);
-    }
 
     return delay;
 }
@@ -415,6 +417,61 @@ uint32_t RadioInterface::getChannelNum()
     return savedChannelNum;
 }
 
+/**
+ * The bandwidth, spreading factor and coding rate of a modem preset
+ */
+void RadioInterface::getPresetParams(meshtastic_Config_LoRaConfig_ModemPreset preset, bool wideLora, float &bw, uint8_t &sf,
+                                     uint8_t &cr)
+{
+    switch (preset) {
+    case meshtastic_Config_LoRaConfig_ModemPreset_SHORT_TURBO:
+        bw = wideLora ? 1625.0 : 500;
+        cr = 5;
+        sf = 7;
+        break;
+    case meshtastic_Config_LoRaConfig_ModemPreset_SHORT_FAST:
+        bw = wideLora ? 812.5 : 250;
+        cr = 5;
+        sf = 7;
+        break;
+    case meshtastic_Config_LoRaConfig_ModemPreset_SHORT_SLOW:
+        bw = wideLora ? 812.5 : 250;
+        cr = 5;
+        sf = 8;
+        break;
+    case meshtastic_Config_LoRaConfig_ModemPreset_MEDIUM_FAST:
+        bw = wideLora ? 812.5 : 250;
+        cr = 5;
+        sf = 9;
+        break;
+    case meshtastic_Config_LoRaConfig_ModemPreset_MEDIUM_SLOW:
+        bw = wideLora ? 812.5 : 250;
+        cr = 5;
+        sf = 10;
+        break;
+    default: // Config_LoRaConfig_ModemPreset_LONG_FAST is default. Gracefully use this is preset is something illegal.
+        bw = wideLora ? 812.5 : 250;
+        cr = 5;
+        sf = 11;
+        break;
+    case meshtastic_Config_LoRaConfig_ModemPreset_LONG_MODERATE:
+        bw = wideLora ? 406.25 : 125;
+        cr = 8;
+        sf = 11;
+        break;
+    case meshtastic_Config_LoRaConfig_ModemPreset_LONG_SLOW:
+        bw = wideLora ? 406.25 : 125;
+        cr = 8;
+        sf = 12;
+        break;
+    case meshtastic_Config_LoRaConfig_ModemPreset_VERY_LONG_SLOW:
+        bw = wideLora ? 203.125 : 62.5;
+        cr = 8;
+        sf = 12;
+        break;
+    }
+}
+
 /**
  * Pull our channel settings etc... from protobufs to the dumb interface settings
  */
@@ -426,54 +483,7 @@ void RadioInterface::applyModemConfig()
     bool validConfig = false; // We need to check for a valid configuration
     while (!validConfig) {
         if (loraConfig.use_preset) {
-
-            switch (loraConfig.modem_preset) {
-            case meshtastic_Config_LoRaConfig_ModemPreset_SHORT_TURBO:
-                bw = (myRegion->wideLora) ? 1625.0 : 500;
-                cr = 5;
-                sf = 7;
-                break;
-            case meshtastic_Config_LoRaConfig_ModemPreset_SHORT_FAST:
-                bw = (myRegion->wideLora) ? 812.5 : 250;
-                cr = 5;
-                sf = 7;
-                break;
-            case meshtastic_Config_LoRaConfig_ModemPreset_SHORT_SLOW:
-                bw = (myRegion->wideLora) ? 812.5 : 250;
-                cr = 5;
-                sf = 8;
-                break;
-            case meshtastic_Config_LoRaConfig_ModemPreset_MEDIUM_FAST:
-                bw = (myRegion->wideLora) ? 812.5 : 250;
-                cr = 5;
-                sf = 9;
-                break;
-            case meshtastic_Config_LoRaConfig_ModemPreset_MEDIUM_SLOW:
-                bw = (myRegion->wideLora) ? 812.5 : 250;
-                cr = 5;
-                sf = 10;
-                break;
-            default: // Config_LoRaConfig_ModemPreset_LONG_FAST is default. Gracefully use this is preset is something illegal.
-                bw = (myRegion->wideLora) ? 812.5 : 250;
-                cr = 5;
-                sf = 11;
-                break;
-            case meshtastic_Config_LoRaConfig_ModemPreset_LONG_MODERATE:
-                bw = (myRegion->wideLora) ? 406.25 : 125;
-                cr = 8;
-                sf = 11;
-                break;
-            case meshtastic_Config_LoRaConfig_ModemPreset_LONG_SLOW:
-                bw = (myRegion->wideLora) ? 406.25 : 125;
-                cr = 8;
-                sf = 12;
-                break;
-            case meshtastic_Config_LoRaConfig_ModemPreset_VERY_LONG_SLOW:
-                bw = (myRegion->wideLora) ? 203.125 : 62.5;
-                cr = 8;
-                sf = 12;
-                break;
-            }
+            getPresetParams(loraConfig.modem_preset, myRegion->wideLora, bw, sf, cr);
         } else {
             sf = loraConfig.spread_factor;
             cr = loraConfig.coding_rate;
@@ -552,6 +562,7 @@ void RadioInterface::applyModemConfig()
     saveFreq(freq + loraConfig.frequency_offset);
 
     slotTimeMsec = computeSlotTimeMsec(bw, sf);
+    airtimeTable.build(bw, sf, cr, preambleLength);
     preambleTimeMsec = getPacketTime((uint32_t)0);
     maxPacketTimeMsec = getPacketTime(meshtastic_Constants_DATA_PAYLOAD_LEN + sizeof(PacketHeader));
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "AirtimeTable.h"
 #include "MemoryPool.h"
 #include "MeshTypes.h"
 #include "Observer.h"
@@ -94,14 +95,14 @@ class RadioInterface
     uint32_t maxPacketTimeMsec = 3246; // calculated on startup, this is the default for LongFast
     const uint32_t PROCESSING_TIME_MSEC =
         4500;                // time to construct, process and construct a packet again (empirically determined)
-    const uint8_t CWmin = 2; // minimum CWsize
-    const uint8_t CWmax = 7; // maximum CWsize
+    static const uint8_t CWmin = 2; // minimum CWsize
+    static const uint8_t CWmax = 7; // maximum CWsize
+
+    AirtimeTable airtimeTable; // getPacketTime() for every packet length, rebuilt when the modem settings change
 
     meshtastic_MeshPacket *sendingPacket = NULL; // The packet we are currently sending
     uint32_t lastTxStart = 0L;
 
-    uint32_t computeSlotTimeMsec(float bw, float sf) { return 8.5 * pow(2, sf) / bw + 0.2 + 0.4 + 7; }
-
     /**
      * A temporary buffer used for sending/receiving packets, sized to hold the biggest buffer we might need
      * */
@@ -169,23 +170,58 @@ class RadioInterface
 
     /** The delay to use for retransmitting dropped packets */
     uint32_t getRetransmissionMsec(const meshtastic_MeshPacket *p);
+    uint32_t getRetransmissionMsec(uint32_t packetAirtime);
 
     /** The delay to use when we want to send something */
     uint32_t getTxDelayMsec();
 
+    /** The contention window size (as a power of 2 slots) for the current channel utilization */
+    uint8_t getCWsize();
+
     /** The delay to use when we want to flood a message. Use a weighted scale based on SNR */
     uint32_t getTxDelayMsecWeighted(float snr);
 
     /**
-     * Calculate airtime per
-     * https://www.rs-online.com/designspark/rel-assets/ds-assets/uploads/knowledge-items/application-notes-for-the-internet-of-things/LoRa%20Design%20Guide.pdf
-     * section 4
+     * Airtime of a packet with our current modem settings, see AirtimeTable
      *
      * @return num msecs for the packet
      */
     uint32_t getPacketTime(const meshtastic_MeshPacket *p);
     uint32_t getPacketTime(uint32_t totalPacketLen);
 
+    /** The slot time for these modem settings, see slotTimeMsec */
+    static uint32_t computeSlotTimeMsec(float bw, float sf) { return 8.5 * pow(2, sf) / bw + 0.2 + 0.4 + 7; }
+
+    /**
+     * The bandwidth, spreading factor and coding rate of a modem preset (wideLora for 2.4GHz radios)
+     */
+    static void getPresetParams(meshtastic_Config_LoRaConfig_ModemPreset preset, bool wideLora, float &bw, uint8_t &sf,
+                                uint8_t &cr);
+
+    /** The contention window size (as a power of 2 slots) for this channel utilization, see getCWsize() */
+    static uint8_t computeCWsize(float channelUtil);
+
+    /** The contention window size for flooding a packet received with this SNR, see getTxDelayMsecWeighted() */
+    static uint8_t computeCWsizeWeighted(float snr);
+
+    /**
+     * The delays of getTxDelayMsec() and getTxDelayMsecWeighted(). pickSlot(lo, hi) is Arduino random() in the firmware,
+     * the simulator passes its own repeatable generator.
+     */
+    template <typename PickSlot> static uint32_t computeTxDelayMsec(uint8_t CWsize, uint32_t slotTimeMsec, PickSlot pickSlot)
+    {
+        return pickSlot(0, 1L << CWsize) * slotTimeMsec;
+    }
+
+    template <typename PickSlot>
+    static uint32_t computeTxDelayMsecWeighted(uint8_t CWsize, bool isRouter, uint32_t slotTimeMsec, PickSlot pickSlot)
+    {
+        if (isRouter)
+            return pickSlot(0, 2 * CWsize) * slotTimeMsec;
+        // offset the maximum delay for routers: (2 * CWmax * slotTimeMsec)
+        return (2 * CWmax * slotTimeMsec) + pickSlot(0, 1L << CWsize) * slotTimeMsec;
+    }
+
     /**
      * Get the channel we saved.
      */
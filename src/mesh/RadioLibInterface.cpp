@@ -12,6 +12,7 @@
 #include <pb_encode.h>
 
 #if ARCH_PORTDUINO
+#include "PacketCapture.h"
 #include "PortduinoGlue.h"
 #include "meshUtils.h"
 #endif
@@ -394,6 +395,9 @@ void RadioLibInterface::handleReceiveInterrupt()
     if (settingsMap[logoutputlevel] == level_trace) {
         printBytes("Raw incoming packet: ", (uint8_t *)&radioBuffer, length);
     }
+    // Before any of the checks below, so a capture has everything the radio gave us
+    if (packetCapture && state == RADIOLIB_ERR_NONE)
+        packetCapture->write((uint8_t *)&radioBuffer, length, iface->getSNR(), iface->getRSSI(), bw, sf, cr);
 #endif
     if (state != RADIOLIB_ERR_NONE) {
         LOG_ERROR("Ignore received packet due to error=%d", state);
@@ -456,6 +460,43 @@ void RadioLibInterface::startReceive()
     powerMon->setState(meshtastic_PowerMon_State_Lora_RXOn);
 }
 
+void RadioLibInterface::setLowPowerReceive(bool allowed)
+{
+    if (allowed == lowPowerReceive)
+        return;
+    lowPowerReceive = allowed;
+
+    // Otherwise the next startReceive() (once the packet is sent or received) picks it up
+    if (isReceiving && !sendingPacket && !isActivelyReceiving())
+        startReceive();
+}
+
+uint16_t RadioLibInterface::getRxSniffSymbols()
+{
+    // We can't sleep for any of the preamble if we have to listen to half of it, the worst case being that it starts just as we
+    // stop listening and we only hear it in the next window
+    uint16_t continuous = (preambleLength + 1) / 2;
+    uint16_t symbols = continuous;
+
+    bool lowPowerRole = config.device.role == meshtastic_Config_DeviceConfig_Role_CLIENT_MUTE ||
+                        config.device.role == meshtastic_Config_DeviceConfig_Role_SENSOR;
+    if (lowPowerReceive && lowPowerRole && continuous > RX_SNIFF_MIN_SYMBOLS) {
+        // Sleep as long as the preamble allows when the channel is quiet, less the busier it gets
+        float util = airTime ? airTime->channelUtilizationPercent() : 0;
+        if (util < RX_SNIFF_BUSY_UTIL_PERCENT)
+            symbols = RX_SNIFF_MIN_SYMBOLS + (uint16_t)((continuous - RX_SNIFF_MIN_SYMBOLS) * util / RX_SNIFF_BUSY_UTIL_PERCENT);
+    }
+
+    if (symbols != lastRxSniffSymbols) {
+        if (symbols < continuous)
+            LOG_DEBUG("Low power receive, listen for %u of %u preamble symbols", symbols, preambleLength);
+        else
+            LOG_DEBUG("Continuous receive");
+        lastRxSniffSymbols = symbols;
+    }
+    return symbols;
+}
+
 void RadioLibInterface::configHardwareForSend()
 {
     powerMon->setState(meshtastic_PowerMon_State_Lora_TXOn);
@@ -16,6 +16,20 @@
 
 #define RADIOLIB_PIN_TYPE uint32_t
 
+/*
+ * Low power receive for CLIENT_MUTE and SENSOR nodes on battery: the receiver sleeps between preamble checks, listening for
+ * just long enough out of every preamble that it can't miss one.  This is how many preamble symbols it must hear to detect
+ * it, so the less of the (16 symbol) preamble it needs the longer it can sleep.  Semtech's minimum is less, but we haven't
+ * measured how many packets we would miss on real links with fewer, so a variant should only lower it after doing so.
+ */
+#ifndef RX_SNIFF_MIN_SYMBOLS
+#define RX_SNIFF_MIN_SYMBOLS 6
+#endif
+// At this channel utilization most wakes would find a packet anyway, so we listen continuously instead
+#ifndef RX_SNIFF_BUSY_UTIL_PERCENT
+#define RX_SNIFF_BUSY_UTIL_PERCENT 25
+#endif
+
 /**
  * We need to override the RadioLib ArduinoHal class to add mutex protection for SPI bus access
  */
@@ -90,6 +104,9 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
     /// are _trying_ to receive a packet currently (note - we might just be waiting for one)
     bool isReceiving = false;
 
+    bool lowPowerReceive = true;
+    uint16_t lastRxSniffSymbols = 0; // only for logging changes
+
   public:
     /** Our ISR code currently needs this to find our active instance
      */
@@ -134,6 +151,10 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
     /** can we detect a LoRa preamble on the current channel? */
     virtual bool isChannelActive() = 0;
 
+    /** Allow the receiver to sleep between preamble checks (see RX_SNIFF_MIN_SYMBOLS), PowerFSM turns this off while we are
+     * externally powered.  Restarts receiving to take effect, unless we are in the middle of a packet. */
+    void setLowPowerReceive(bool allowed);
+
     /** are we actively receiving a packet (only called during receiving state)
      *  This method is only public to facilitate debugging.  Do not call.
      */
@@ -199,5 +220,11 @@ class RadioLibInterface : public RadioInterface, protected concurrency::Notified
      */
     virtual void setStandby();
 
+    /**
+     * How many symbols of each preamble the receiver listens for before sleeping again, for startReceiveDutyCycleAuto().
+     * Half the preamble length or more means it never sleeps.  The quieter the channel the less it listens for.
+     */
+    uint16_t getRxSniffSymbols();
+
     const char *radioLibErr = "RadioLib err=";
 };
\ No newline at end of file
@@ -29,9 +29,12 @@ ErrorCode ReliableRouter::send(meshtastic_MeshPacket *p)
     /* If we have pending retransmissions, add the airtime of this packet to it, because during that time we cannot receive an
        (implicit) ACK. Otherwise, we might retransmit too early.
      */
-    for (auto i = pending.begin(); i != pending.end(); i++) {
-        if (i->first.id != p->id) {
-            i->second.nextTxMsec += iface->getPacketTime(p);
+    if (!pending.empty()) {
+        uint32_t packetTime = iface->getPacketTime(p);
+        for (auto i = pending.begin(); i != pending.end(); i++) {
+            if (i->first.id != p->id) {
+                i->second.nextTxMsec += packetTime;
+            }
         }
     }
 
@@ -69,8 +72,11 @@ bool ReliableRouter::shouldFilterReceived(const meshtastic_MeshPacket *p)
        because while receiving this packet, we could not have received an (implicit) ACK for it.
        If we don't add this, we will likely retransmit too early.
     */
-    for (auto i = pending.begin(); i != pending.end(); i++) {
-        i->second.nextTxMsec += iface->getPacketTime(p);
+    if (!pending.empty()) {
+        uint32_t packetTime = iface->getPacketTime(p);
+        for (auto i = pending.begin(); i != pending.end(); i++) {
+            i->second.nextTxMsec += packetTime;
+        }
     }
 
     return FloodingRouter::shouldFilterReceived(p);
@@ -255,7 +261,9 @@ int32_t ReliableRouter::doRetransmissions()
 void ReliableRouter::setNextTx(PendingPacket *pending)
 {
     assert(iface);
-    auto d = iface->getRetransmissionMsec(pending->packet);
+    if (!pending->packetTimeMsec)
+        pending->packetTimeMsec = iface->getPacketTime(pending->packet); // the packet doesn't change between retransmissions
+    auto d = iface->getRetransmissionMsec(pending->packetTimeMsec);
     pending->nextTxMsec = millis() + d;
     LOG_DEBUG("Set next retransmission in %u msecs: ", d);
     printPacket("", pending->packet);
@@ -35,6 +35,9 @@ struct PendingPacket {
     /** The next time we should try to retransmit this packet */
     uint32_t nextTxMsec = 0;
 
+    /** Airtime of packet, computed on first use (encoding a decoded packet just to learn its length isn't free) */
+    uint32_t packetTimeMsec = 0;
+
     /** Starts at NUM_RETRANSMISSIONS -1(normally 3) and counts down.  Once zero it will be removed from the list */
     uint8_t numRetransmissions = 0;
 
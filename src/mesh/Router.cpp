@@ -22,8 +22,10 @@
 #include "serialization/MeshPacketSerializer.h"
 #endif
 
+#ifndef MAX_RX_FROMRADIO
 #define MAX_RX_FROMRADIO                                                                                                         \
-    4 // max number of packets destined to our queue, we dispatch packets quickly so it doesn't need to be big
+    8 // max number of packets destined to our queue, we dispatch packets quickly but bursts can arrive back to back
+#endif
 
 // I think this is right, one packet for each of the three fifos + one packet being currently assembled for TX or RX
 // And every TX packet might have a retransmission packet or an ack alive at any moment
@@ -66,7 +68,7 @@ Router::Router() : concurrency::OSThread("Router"), fromRadioQueue(MAX_RX_FROMRA
 int32_t Router::runOnce()
 {
     meshtastic_MeshPacket *mp;
-    while ((mp = fromRadioQueue.dequeuePtr(0)) != NULL) {
+    while (fromRadioQueue.dequeue(&mp)) {
         // printPacket("handle fromRadioQ", mp);
         perhapsHandleReceived(mp);
     }
@@ -81,17 +83,12 @@ int32_t Router::runOnce()
  */
 void Router::enqueueReceivedMessage(meshtastic_MeshPacket *p)
 {
-    // Try enqueue until successful
-    while (!fromRadioQueue.enqueue(p, 0)) {
-        meshtastic_MeshPacket *old_p;
-        old_p = fromRadioQueue.dequeuePtr(0); // Dequeue and discard the oldest packet
-        if (old_p) {
-            printPacket("fromRadioQ full, drop oldest!", old_p);
-            packetPool.release(old_p);
-        }
+    // The queue wakes us up itself. If it is full we drop the new packet, only the reader may remove old ones.
+    concurrency::LockGuard g(&enqueueLock);
+    if (!fromRadioQueue.enqueue(p)) {
+        printPacket("fromRadioQ full, drop!", p);
+        packetPool.release(p);
     }
-    // Nasty hack because our threading is primitive.  interfaces shouldn't need to know about routers FIXME
-    setReceivedMessage();
 }
 
 /// Generate a unique packet id
@@ -6,7 +6,9 @@
 #include "Observer.h"
 #include "PointerQueue.h"
 #include "RadioInterface.h"
+#include "concurrency/Lock.h"
 #include "concurrency/OSThread.h"
+#include "concurrency/SPSCQueue.h"
 
 /**
  * A mesh aware router that supports multiple interfaces.
@@ -16,7 +18,10 @@ class Router : protected concurrency::OSThread
   private:
     /// Packets which have just arrived from the radio, ready to be processed by this service and possibly
     /// forwarded to the phone.
-    PointerQueue<meshtastic_MeshPacket> fromRadioQueue;
+    /// We are the only consumer. There are several producers (radio and MQTT on the main loop, local sends also from the
+    /// BLE host task), they take enqueueLock so the queue only ever sees one at a time.
+    concurrency::SPSCQueue<meshtastic_MeshPacket *> fromRadioQueue;
+    concurrency::Lock enqueueLock;
 
   protected:
     RadioInterface *iface = NULL;
@@ -86,6 +91,9 @@ class Router : protected concurrency::OSThread
         before us */
     uint32_t rxDupe = 0, txRelayCanceled = 0;
 
+    /// Number of received packets dropped because fromRadioQueue was full
+    uint32_t getRxDropped() const { return fromRadioQueue.getDropped(); }
+
   protected:
     friend class RoutingModule;
 
@@ -0,0 +1,74 @@
+#include "SaveScheduler.h"
+#include "NodeDB.h"
+#include "configuration.h"
+
+SaveScheduler::SaveScheduler(NodeDB *_db) : concurrency::OSThread("SaveScheduler"), db(_db)
+{
+    disable(); // Nothing to save yet
+}
+
+void SaveScheduler::request(int saveWhat)
+{
+    uint32_t now = millis();
+    stats.requests++;
+    if (pending)
+        stats.avoided++;
+    else
+        firstRequestMsec = now;
+
+    pending |= saveWhat;
+    lastRequestMsec = now;
+
+    setIntervalFromNow(msecUntilDue());
+    enabled = true;
+}
+
+int32_t SaveScheduler::msecUntilDue() const
+{
+    uint32_t now = millis();
+    uint32_t quietFor = now - lastRequestMsec, waitedFor = now - firstRequestMsec;
+
+    int32_t delay = 0;
+    if (quietFor < SAVE_DEBOUNCE_MSEC && waitedFor < SAVE_MAX_DELAY_MSEC)
+        delay = min(SAVE_DEBOUNCE_MSEC - quietFor, SAVE_MAX_DELAY_MSEC - waitedFor);
+
+    if (haveSaved && now - lastSaveMsec < SAVE_MIN_INTERVAL_MSEC)
+        delay = max(delay, (int32_t)(SAVE_MIN_INTERVAL_MSEC - (now - lastSaveMsec)));
+
+    return delay;
+}
+
+bool SaveScheduler::flush()
+{
+    if (!pending)
+        return true;
+
+    int saveWhat = pending;
+    pending = 0;
+    uint32_t start = millis();
+    bool okay = db->saveToDisk(saveWhat);
+    uint32_t duration = millis() - start;
+
+    lastSaveMsec = millis();
+    haveSaved = true;
+    stats.saves++;
+    stats.lastDurationMs = duration;
+    stats.maxDurationMs = max(stats.maxDurationMs, duration);
+    stats.totalDurationMs += duration;
+    LOG_INFO("Saved segments 0x%x in %u ms (%u saves, %u requests merged so far)", saveWhat, duration, stats.saves,
+             stats.avoided);
+    return okay;
+}
+
+int32_t SaveScheduler::runOnce()
+{
+    if (!pending)
+        return disable();
+
+    int32_t delay = msecUntilDue();
+    if (delay > 0)
+        return delay;
+
+    flush();
+    return pending ? msecUntilDue() : disable();
+}
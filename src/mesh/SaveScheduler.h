@@ -0,0 +1,70 @@
+#pragma once
+
+#include "concurrency/OSThread.h"
+#include <stdint.h>
+
+// Wait this long after the last request before writing, so a burst of changes becomes a single write
+#ifndef SAVE_DEBOUNCE_MSEC
+#define SAVE_DEBOUNCE_MSEC (2 * 1000)
+#endif
+
+// But never hold on to a requested save for longer than this
+#ifndef SAVE_MAX_DELAY_MSEC
+#define SAVE_MAX_DELAY_MSEC (15 * 1000)
+#endif
+
+// And don't wear out the flash by writing more often than this
+#ifndef SAVE_MIN_INTERVAL_MSEC
+#define SAVE_MIN_INTERVAL_MSEC (5 * 1000)
+#endif
+
+class NodeDB;
+
+/**
+ * Background writer for NodeDB::saveToDisk().
+ *
+ * Callers that don't need the data on flash right away use NodeDB::saveToDiskLater(), which only merges the requested
+ * SEGMENT_* bits here.  We write them all at once when things have been quiet for SAVE_DEBOUNCE_MSEC.  Shutdown and reboot
+ * paths call flush() so nothing requested is lost.
+ */
+class SaveScheduler : private concurrency::OSThread
+{
+  public:
+    struct Stats {
+        uint32_t requests;        // calls to request()
+        uint32_t saves;           // actual writes
+        uint32_t avoided;         // requests merged into an already pending write
+        uint32_t lastDurationMs;  // how long the last write blocked the main loop
+        uint32_t maxDurationMs;   // longest write so far
+        uint32_t totalDurationMs; // time spent writing since boot
+    };
+
+    explicit SaveScheduler(NodeDB *db);
+
+    /// Merge saveWhat into the pending segments and (re)start the debounce timer
+    void request(int saveWhat);
+
+    /// Write any pending segments right now, returns false if the write failed
+    bool flush();
+
+    /// The segments in saveWhat were just written by a synchronous save, no need to write them again
+    void clear(int saveWhat) { pending &= ~saveWhat; }
+
+    /// Segments waiting to be written
+    int getPending() const { return pending; }
+
+    const Stats &getStats() const { return stats; }
+
+  protected:
+    int32_t runOnce() override;
+
+  private:
+    NodeDB *db;
+    int pending = 0;
+    uint32_t firstRequestMsec = 0, lastRequestMsec = 0, lastSaveMsec = 0;
+    bool haveSaved = false;
+    Stats stats = {};
+
+    /// How many msecs until we should write the pending segments
+    int32_t msecUntilDue() const;
+};
@@ -4,10 +4,6 @@
 #include "Throttle.h"
 #include "configuration.h"
 
-#define START1 0x94
-#define START2 0xc3
-#define HEADER_LEN 4
-
 int32_t StreamAPI::runOncePart()
 {
     auto result = readStream();
@@ -42,30 +38,30 @@ int32_t StreamAPI::readStream()
 
             // console->printf("rxPtr %d ptr=%d c=0x%x\n", rxPtr, ptr, c);
 
-            if (ptr == 0) { // looking for START1
-                if (c != START1)
+            if (ptr == 0) { // looking for STREAM_START1
+                if (c != STREAM_START1)
                     rxPtr = 0;     // failed to find framing
-            } else if (ptr == 1) { // looking for START2
-                if (c != START2)
+            } else if (ptr == 1) { // looking for STREAM_START2
+                if (c != STREAM_START2)
                     rxPtr = 0;                             // failed to find framing
-            } else if (ptr >= HEADER_LEN - 1) {            // we have at least read our 4 byte framing
+            } else if (ptr >= STREAM_HEADER_LEN - 1) {     // we have at least read our 4 byte framing
                 uint32_t len = (rxBuf[2] << 8) + rxBuf[3]; // big endian 16 bit length follows framing
 
                 // console->printf("len %d\n", len);
 
-                if (ptr == HEADER_LEN - 1) {
+                if (ptr == STREAM_HEADER_LEN - 1) {
                     // we _just_ finished our 4 byte header, validate length now (note: a length of zero is a valid
                     // protobuf also)
                     if (len > MAX_TO_FROM_RADIO_SIZE)
                         rxPtr = 0; // length is bogus, restart search for framing
                 }
 
-                if (rxPtr != 0)                        // Is packet still considered 'good'?
-                    if (ptr + 1 >= len + HEADER_LEN) { // have we received all of the payload?
-                        rxPtr = 0;                     // start over again on the next packet
+                if (rxPtr != 0)                               // Is packet still considered 'good'?
+                    if (ptr + 1 >= len + STREAM_HEADER_LEN) { // have we received all of the payload?
+                        rxPtr = 0;                            // start over again on the next packet
 
                         // If we didn't just fail the packet and we now have the right # of bytes, parse it
-                        handleToRadio(rxBuf + HEADER_LEN, len);
+                        handleToRadio(rxBuf + STREAM_HEADER_LEN, len);
                     }
             }
         }
@@ -85,7 +81,7 @@ void StreamAPI::writeStream()
         uint32_t len;
         do {
             // Send every packet we can
-            len = getFromRadio(txBuf + HEADER_LEN);
+            len = getFromRadio(txBuf + STREAM_HEADER_LEN);
             emitTxBuffer(len);
         } while (len);
     }
@@ -97,12 +93,12 @@ void StreamAPI::writeStream()
 void StreamAPI::emitTxBuffer(size_t len)
 {
     if (len != 0) {
-        txBuf[0] = START1;
-        txBuf[1] = START2;
+        txBuf[0] = STREAM_START1;
+        txBuf[1] = STREAM_START2;
         txBuf[2] = (len >> 8) & 0xff;
         txBuf[3] = len & 0xff;
 
-        auto totalLen = len + HEADER_LEN;
+        auto totalLen = len + STREAM_HEADER_LEN;
         stream->write(txBuf, totalLen);
         stream->flush();
     }
@@ -116,7 +112,8 @@ void StreamAPI::emitRebooted()
     fromRadioScratch.rebooted = true;
 
     // LOG_DEBUG("Emitting reboot packet for serial shell");
-    emitTxBuffer(pb_encode_to_bytes(txBuf + HEADER_LEN, meshtastic_FromRadio_size, &meshtastic_FromRadio_msg, &fromRadioScratch));
+    emitTxBuffer(
+        pb_encode_to_bytes(txBuf + STREAM_HEADER_LEN, meshtastic_FromRadio_size, &meshtastic_FromRadio_msg, &fromRadioScratch));
 }
 
 void StreamAPI::emitLogRecord(meshtastic_LogRecord_Level level, const char *src, const char *format, va_list arg)
@@ -135,7 +132,8 @@ void StreamAPI::emitLogRecord(meshtastic_LogRecord_Level level, const char *src,
     if (num_printed > 0 && fromRadioScratch.log_record.message[num_printed - 1] ==
                                '\n') // Strip any ending newline, because we have records for framing instead.
         fromRadioScratch.log_record.message[num_printed - 1] = '\0';
-    emitTxBuffer(pb_encode_to_bytes(txBuf + HEADER_LEN, meshtastic_FromRadio_size, &meshtastic_FromRadio_msg, &fromRadioScratch));
+    emitTxBuffer(
+        pb_encode_to_bytes(txBuf + STREAM_HEADER_LEN, meshtastic_FromRadio_size, &meshtastic_FromRadio_msg, &fromRadioScratch));
 }
 
 /// Hookable to find out when connection changes
@@ -1,6 +1,7 @@
 #if !MESHTASTIC_EXCLUDE_WEBSERVER
 #include "NodeDB.h"
 #include "PowerFSM.h"
+#include "PowerMon.h"
 #include "RadioLibInterface.h"
 #include "airtime.h"
 #include "main.h"
@@ -17,8 +18,11 @@
 #include <HTTPMultipartBodyParser.hpp>
 #include <HTTPURLEncodedBodyParser.hpp>
 
+#include <map>
+
 #ifdef ARCH_ESP32
 #include "esp_task_wdt.h"
+#include <esp_rom_crc.h>
 #endif
 
 /*
@@ -52,6 +56,9 @@ HTTPClient httpClient;
 
 #define DEST_FS_USES_LITTLEFS
 
+// /api/v1/fromradio?framed=true stops after this much, the client asks again for the rest
+#define FROMRADIO_FRAMED_MAX_BYTES (8 * 1024)
+
 // We need to specify some content-type mapping, so the resources get delivered with the
 // right content type and are displayed correctly in the browser
 char contentTypes[][2][32] = {{".txt", "text/plain"},     {".html", "text/html"},
@@ -61,6 +68,29 @@ char contentTypes[][2][32] = {{".txt", "text/plain"},     {".html", "text/html"}
                               {".css", "text/css"},       {".ico", "image/vnd.microsoft.icon"},
                               {".svg", "image/svg+xml"},  {"", ""}};
 
+// /static files are read and written this much at a time
+#define STATIC_FILE_CHUNK 4096
+// How many resolved /static paths we remember
+#define STATIC_FILE_CACHE_SIZE 48
+// Browsers may reuse everything but html pages this long without asking (and then revalidate with the ETag)
+#define STATIC_FILE_CACHE_CONTROL "public, max-age=86400"
+
+// Handlers all run on the web server thread, one at a time, so they can share this (and spare the stack)
+static uint8_t staticFileBuffer[STATIC_FILE_CHUNK] __attribute__((aligned(4)));
+
+/// What a /static path resolved to, so we don't probe the filesystem for name and name.gz on every request
+struct StaticFile {
+    std::string path; // empty if there is nothing to serve, not even the index.html.gz fallback
+    bool gzip;
+    bool fallback; // path didn't exist, this is the web client's index.html.gz instead
+    size_t size;
+    time_t lastWrite; // 0 if the filesystem doesn't keep times
+    std::string etag;
+};
+
+/// Resolved /static paths, emptied whenever files are uploaded or deleted and checked against the file's size and time on a hit
+static std::map<std::string, StaticFile> staticFiles;
+
 // const char *certificate = NULL; // change this as needed, leave as is for no TLS check (yolo security)
 
 // Our API to handle messages to and from the radio.
@@ -176,6 +206,20 @@ void handleAPIv1FromRadio(HTTPRequest *req, HTTPResponse *res)
 
     uint8_t txBuf[MAX_STREAM_BUF_SIZE];
     uint32_t len = 1;
+    std::string valueFramed;
+
+    if (params->getQueryParameter("framed", valueFramed) && valueFramed == "true") {
+        // Whatever is available right now in one response, each FromRadio behind the same 4 byte header as the serial API, so
+        // a client downloading the config needs a few requests instead of one per message.  We run on the main loop here, so
+        // unlike on Linux we can't hold the request open waiting for more, and we stop after FROMRADIO_FRAMED_MAX_BYTES.
+        uint32_t total = 0;
+        while (total < FROMRADIO_FRAMED_MAX_BYTES && (len = webAPI.getFromRadioFramed(txBuf)) != 0) {
+            res->write(txBuf, len);
+            total += len;
+        }
+        LOG_DEBUG("webAPI handleAPIv1FromRadio, framed %d bytes", total);
+        return;
+    }
 
     if (params->getQueryParameter("all", valueAll)) {
 
@@ -353,6 +397,7 @@ void handleFsDeleteStatic(HTTPRequest *req, HTTPResponse *res)
         std::string pathDelete = "/" + paramValDelete;
         if (FSCom.remove(pathDelete.c_str())) {
             LOG_INFO("%s", pathDelete.c_str());
+            staticFiles.clear();
             JSONObject jsonObjOuter;
             jsonObjOuter["status"] = new JSONValue("ok");
             JSONValue *value = new JSONValue(jsonObjOuter);
@@ -371,6 +416,70 @@ void handleFsDeleteStatic(HTTPRequest *req, HTTPResponse *res)
     }
 }
 
+/// Make an ETag for f from its size and modification time, or its crc32 if the filesystem doesn't keep times
+static std::string staticFileETag(File &f)
+{
+    char etag[32];
+    time_t lastWrite = f.getLastWrite();
+    if (lastWrite) {
+        snprintf(etag, sizeof(etag), "\"%x-%lx\"", (unsigned)f.size(), (unsigned long)lastWrite);
+    } else {
+        uint32_t crc = 0;
+        size_t length;
+        while ((length = f.read(staticFileBuffer, sizeof(staticFileBuffer))) > 0)
+            crc = esp_rom_crc32_le(crc, staticFileBuffer, length);
+        f.seek(0);
+        snprintf(etag, sizeof(etag), "\"%x-c%08x\"", (unsigned)f.size(), crc);
+    }
+    return etag;
+}
+
+static const StaticFile &resolveStaticFile(const std::string &filename)
+{
+    auto found = staticFiles.find(filename);
+    if (found != staticFiles.end()) {
+        const StaticFile &cached = found->second;
+        if (cached.path.empty())
+            return cached;
+        // Files can be replaced behind our back (remounts, other writers), so the ETag has to still match what is on disk
+        File file = FSCom.open(cached.path.c_str());
+        bool unchanged = file && file.size() == cached.size && file.getLastWrite() == cached.lastWrite;
+        if (file)
+            file.close();
+        if (unchanged)
+            return cached;
+        staticFiles.erase(found);
+    }
+
+    if (staticFiles.size() >= STATIC_FILE_CACHE_SIZE)
+        staticFiles.clear(); // a client probing lots of missing paths shouldn't eat our RAM
+
+    StaticFile sf = {"", false, false, 0, 0, ""};
+    std::string filenameGzip = filename + ".gz";
+    if (FSCom.exists(filename.c_str())) {
+        sf.path = filename;
+    } else if (FSCom.exists(filenameGzip.c_str())) {
+        sf.path = filenameGzip;
+        sf.gzip = true;
+    } else if (FSCom.exists("/static/index.html.gz")) {
+        sf.path = "/static/index.html.gz";
+        sf.gzip = sf.fallback = true;
+    }
+
+    if (!sf.path.empty()) {
+        File file = FSCom.open(sf.path.c_str());
+        if (file) {
+            sf.size = file.size();
+            sf.lastWrite = file.getLastWrite();
+            sf.etag = staticFileETag(file);
+            file.close();
+        } else {
+            sf.path.clear();
+        }
+    }
+    return staticFiles[filename] = sf;
+}
+
 void handleStatic(HTTPRequest *req, HTTPResponse *res)
 {
     // Get access to the parameters
@@ -381,72 +490,57 @@ void handleStatic(HTTPRequest *req, HTTPResponse *res)
     if (params->getPathParameter(0, parameter1)) {
 
         std::string filename = "/static/" + parameter1;
-        std::string filenameGzip = "/static/" + parameter1 + ".gz";
-
-        // Try to open the file
-        File file;
-
-        bool has_set_content_type = false;
-
-        if (filename == "/static/") {
+        if (filename == "/static/")
             filename = "/static/index.html";
-            filenameGzip = "/static/index.html.gz";
-        }
 
-        if (FSCom.exists(filename.c_str())) {
-            file = FSCom.open(filename.c_str());
-            if (!file.available()) {
-                LOG_WARN("File not available - %s", filename.c_str());
-            }
-        } else if (FSCom.exists(filenameGzip.c_str())) {
-            file = FSCom.open(filenameGzip.c_str());
-            res->setHeader("Content-Encoding", "gzip");
-            if (!file.available()) {
-                LOG_WARN("File not available - %s", filenameGzip.c_str());
-            }
-        } else {
-            has_set_content_type = true;
-            filenameGzip = "/static/index.html.gz";
-            file = FSCom.open(filenameGzip.c_str());
+        const StaticFile &sf = resolveStaticFile(filename);
+        if (sf.path.empty()) {
+            LOG_WARN("File not available - %s", filename.c_str());
             res->setHeader("Content-Type", "text/html");
-            if (!file.available()) {
-                LOG_WARN("File not available - %s", filenameGzip.c_str());
-                res->println("Web server is running.<br><br>The content you are looking for can't be found. Please see: <a "
-                             "href=https://meshtastic.org/docs/software/web-client/>FAQ</a>.<br><br><a "
-                             "href=/admin>admin</a>");
-
-                return;
-            } else {
-                res->setHeader("Content-Encoding", "gzip");
-            }
+            res->println("Web server is running.<br><br>The content you are looking for can't be found. Please see: <a "
+                         "href=https://meshtastic.org/docs/software/web-client/>FAQ</a>.<br><br><a "
+                         "href=/admin>admin</a>");
+            return;
         }
 
-        res->setHeader("Content-Length", httpsserver::intToString(file.size()));
-
         // Content-Type is guessed using the definition of the contentTypes-table defined above
-        int cTypeIdx = 0;
-        do {
-            if (filename.rfind(contentTypes[cTypeIdx][0]) != std::string::npos) {
-                res->setHeader("Content-Type", contentTypes[cTypeIdx][1]);
-                has_set_content_type = true;
-                break;
+        const char *contentType = "text/html"; // what we serve in place of missing files
+        if (!sf.fallback) {
+            contentType = "application/octet-stream";
+            for (int cTypeIdx = 0; strlen(contentTypes[cTypeIdx][0]) > 0; cTypeIdx++) {
+                if (filename.rfind(contentTypes[cTypeIdx][0]) != std::string::npos) {
+                    contentType = contentTypes[cTypeIdx][1];
+                    break;
+                }
             }
-            cTypeIdx += 1;
-        } while (strlen(contentTypes[cTypeIdx][0]) > 0);
+        }
+        res->setHeader("Content-Type", contentType);
+        if (sf.gzip)
+            res->setHeader("Content-Encoding", "gzip");
 
-        if (!has_set_content_type) {
-            // Set a default content type
-            res->setHeader("Content-Type", "application/octet-stream");
+        // The web client's assets have a hash in their names, but index.html doesn't, so browsers must check that every time
+        res->setHeader("ETag", sf.etag);
+        res->setHeader("Cache-Control", strcmp(contentType, "text/html") == 0 ? "no-cache" : STATIC_FILE_CACHE_CONTROL);
+        if (req->getHeader("If-None-Match") == sf.etag) {
+            res->setStatusCode(304);
+            res->setStatusText("Not Modified");
+            return;
         }
 
+        File file = FSCom.open(sf.path.c_str());
+        if (!file) {
+            // Deleted behind our back (uploads and deletes from the web UI empty the cache, but not other writers)
+            staticFiles.erase(filename);
+            res->setStatusCode(404);
+            res->setStatusText("Not Found");
+            return;
+        }
+        res->setHeader("Content-Length", std::to_string(file.size()));
+
         // Read the file and write it to the HTTP response body
-        size_t length = 0;
-        do {
-            char buffer[256];
-            length = file.read((uint8_t *)buffer, 256);
-            std::string bufferString(buffer, length);
-            res->write((uint8_t *)bufferString.c_str(), bufferString.size());
-        } while (length > 0);
+        size_t length;
+        while ((length = file.read(staticFileBuffer, sizeof(staticFileBuffer))) > 0)
+            res->write(staticFileBuffer, length);
 
         file.close();
 
@@ -571,6 +665,7 @@ void handleFormUpload(HTTPRequest *req, HTTPResponse *res)
 
         file.flush();
         file.close();
+        staticFiles.clear();
         res->printf("<p>Saved %d bytes to %s</p>", (int)fileLength, pathname.c_str());
     }
     if (!didwrite) {
@@ -654,6 +749,12 @@ void handleReport(HTTPRequest *req, HTTPResponse *res)
     jsonObjPower["has_usb"] = new JSONValue(BoolToString(powerStatus->getHasUSB()));
     jsonObjPower["is_charging"] = new JSONValue(BoolToString(powerStatus->getIsCharging()));
 
+    // data->power->energy, estimated mAh used by each subsystem since boot
+    JSONObject jsonObjEnergy;
+    for (int c = 0; c < PowerMon::NUM_CONSUMERS; c++)
+        jsonObjEnergy[PowerMon::getName((PowerMon::Consumer)c)] = new JSONValue(powerMon->getMah((PowerMon::Consumer)c));
+    jsonObjPower["energy_mah"] = new JSONValue(jsonObjEnergy);
+
     // data->device
     JSONObject jsonObjDevice;
     jsonObjDevice["reboot_counter"] = new JSONValue((int)myNodeInfo.reboot_count);
@@ -37,6 +37,7 @@ mail:   marchammermann@googlemail.com
 #ifdef PORTDUINO_LINUX_HARDWARE
 #if __has_include(<ulfius.h>)
 #include "PiWebServer.h"
+#include "WebSessions.h"
 #include "NodeDB.h"
 #include "PhoneAPI.h"
 #include "PowerFSM.h"
@@ -45,6 +46,7 @@ mail:   marchammermann@googlemail.com
 #include "graphics/Screen.h"
 #include "main.h"
 #include "mesh/wifi/WiFiAPClient.h"
+#include "serialization/JSON.h"
 #include "sleep.h"
 #include <openssl/bn.h>
 #include <openssl/evp.h>
@@ -56,10 +58,12 @@ mail:   marchammermann@googlemail.com
 #include <ulfius.h>
 #include <yder.h>
 
+#include <algorithm>
 #include <cstring>
+#include <mutex>
 #include <string>
+#include <vector>
 
-#include "PortduinoFS.h"
 #include "platform/portduino/PortduinoGlue.h"
 
 #define DEFAULT_REALM "default_realm"
@@ -82,8 +86,6 @@ char contentTypes[][2][32] = {{".txt", "text/plain"},      {".html", "text/html"
 volatile bool isWebServerReady;
 volatile bool isCertReady;
 
-HttpAPI webAPI;
-
 PiWebServerThread *piwebServerThread;
 
 /**
@@ -217,6 +219,46 @@ int callback_static_file(const struct _u_request *request, struct _u_response *r
 
 static void handleWebResponse() {}
 
+/**
+ * Whether req comes from a page of another origin.  Browsers send Origin with those (and with same-origin PUTs), but our
+ * CORS headers don't allow credentials, so such clients never send the session cookie back.
+ */
+static bool isCrossOrigin(const struct _u_request *req)
+{
+    const char *origin = u_map_get_case(req->map_header, "Origin");
+    if (!origin)
+        return false;
+    const char *host = u_map_get_case(req->map_header, "Host");
+    const char *originHost = strstr(origin, "://");
+    return !host || !originHost || strcmp(originHost + 3, host) != 0;
+}
+
+/**
+ * The session of the client making req, from its cookie (or ?session= / X-Meshtastic-Session for clients without cookies).
+ * Starts a new session, and tells the client about it, if it has none, except that cross-origin clients without a token
+ * share one session.  Returns NULL (and answers 503) if all are busy.
+ */
+static WebSession *getSession(const struct _u_request *req, struct _u_response *res)
+{
+    const char *token = u_map_get(req->map_cookie, WEB_SESSION_COOKIE);
+    if (!token)
+        token = u_map_get(req->map_url, "session");
+    if (!token)
+        token = u_map_get_case(req->map_header, "X-Meshtastic-Session");
+
+    WebSession *s = webSessions->acquire(token, isCrossOrigin(req));
+    if (!s) {
+        ulfius_set_string_body_response(res, 503, "Too many web API clients");
+        return NULL;
+    }
+    if (s->shared)
+        return s;
+    if (!token || strcmp(token, s->token) != 0)
+        ulfius_add_cookie_to_response(res, WEB_SESSION_COOKIE, s->token, NULL, 0, NULL, "/", 0, 1);
+    ulfius_add_header_to_response(res, "X-Meshtastic-Session", s->token);
+    return s;
+}
+
 /*
  * Adapt the radioapi to the Webservice handleAPIv1ToRadio
  * Trigger : WebGui(SAVE)->WebServcice->phoneApi
@@ -226,9 +268,10 @@ int handleAPIv1ToRadio(const struct _u_request *req, struct _u_response *res, vo
     LOG_DEBUG("handleAPIv1ToRadio web -> radio  ");
 
     ulfius_add_header_to_response(res, "Content-Type", "application/x-protobuf");
-    ulfius_add_header_to_response(res, "Access-Control-Allow-Headers", "Content-Type");
+    ulfius_add_header_to_response(res, "Access-Control-Allow-Headers", "Content-Type, X-Meshtastic-Session");
     ulfius_add_header_to_response(res, "Access-Control-Allow-Origin", "*");
     ulfius_add_header_to_response(res, "Access-Control-Allow-Methods", "PUT, OPTIONS");
+    ulfius_add_header_to_response(res, "Access-Control-Expose-Headers", "X-Meshtastic-Session");
     ulfius_add_header_to_response(res, "X-Protobuf-Schema",
                                   "https://raw.githubusercontent.com/meshtastic/protobufs/master/meshtastic/mesh.proto");
 
@@ -237,21 +280,95 @@ int handleAPIv1ToRadio(const struct _u_request *req, struct _u_response *res, vo
         return U_CALLBACK_COMPLETE;
     }
 
-    byte buffer[MAX_TO_FROM_RADIO_SIZE];
-    size_t s = req->binary_body_length;
-
-    memcpy(buffer, req->binary_body, MAX_TO_FROM_RADIO_SIZE);
+    if (req->binary_body_length > MAX_TO_FROM_RADIO_SIZE) {
+        ulfius_set_string_body_response(res, 413, "ToRadio too large");
+        return U_CALLBACK_COMPLETE;
+    }
 
-    // FIXME* Problem with portdunio loosing mountpoint maybe because of running in a real sep. thread
+    WebSession *session = getSession(req, res);
+    if (!session)
+        return U_CALLBACK_COMPLETE;
 
-    portduinoVFS->mountpoint(configWeb.rootPath);
+    // Handled on the main loop by WebSessions, PhoneAPI isn't thread safe
+    WebFrame f;
+    f.len = req->binary_body_length;
+    memcpy(f.bytes, req->binary_body, f.len);
+    LOG_DEBUG("Received %d bytes from PUT request", f.len);
+    bool queued;
+    {
+        std::lock_guard<std::mutex> guard(session->httpLock);
+        queued = session->toRadio.enqueue(f);
+    }
+    if (!queued)
+        ulfius_set_string_body_response(res, 503, "Too many ToRadios waiting");
 
-    LOG_DEBUG("Received %d bytes from PUT request", s);
-    webAPI.handleToRadio(buffer, s);
+    webSessions->release(session);
     LOG_DEBUG("end web->radio  ");
     return U_CALLBACK_COMPLETE;
 }
 
+/// Take the next FromRadio prepared for session, from any request thread
+static bool nextFromRadio(WebSession *session, WebFrame *f)
+{
+    std::lock_guard<std::mutex> guard(session->httpLock);
+    return session->fromRadio.dequeue(f);
+}
+
+/// State of one /api/v1/fromradio?stream=true response
+struct FromRadioStream {
+    WebSession *session;
+    WebFrame f; // a frame that didn't fit in what microhttpd asked for
+    size_t sent = 0;
+
+    explicit FromRadioStream(WebSession *session) : session(session) { f.len = 0; }
+};
+
+/**
+ * microhttpd calls this (on the thread of the connection) whenever it can send more of a streamed response.  We wait for
+ * FromRadios the way polling clients did, but without a round trip for each, and end the response after
+ * FROMRADIO_STREAM_IDLE_MSEC without any (so proxies don't time it out, the client just asks again).
+ */
+static ssize_t fromRadioStreamRead(void *cls, uint64_t pos, char *out, size_t max)
+{
+    FromRadioStream *s = (FromRadioStream *)cls;
+    uint32_t start = millis();
+    while (true) {
+        if (s->sent < s->f.len) {
+            size_t n = std::min(max, s->f.len - s->sent);
+            memcpy(out, s->f.bytes + s->sent, n);
+            s->sent += n;
+            return n;
+        }
+
+        // As many whole frames as are ready and fit, the first one that doesn't is sent next time
+        size_t n = 0;
+        s->sent = s->f.len = 0;
+        while (nextFromRadio(s->session, &s->f)) {
+            if (max - n < s->f.len)
+                break;
+            memcpy(out + n, s->f.bytes, s->f.len);
+            n += s->f.len;
+            s->f.len = 0;
+        }
+        if (n)
+            return n;
+        if (s->f.len)
+            continue;
+
+        s->session->lastSeenMsec = millis(); // the client is still there
+        if (millis() - start >= FROMRADIO_STREAM_IDLE_MSEC)
+            return U_STREAM_END;
+        delay(FROMRADIO_STREAM_POLL_MSEC);
+    }
+}
+
+static void fromRadioStreamFree(void *cls)
+{
+    FromRadioStream *s = (FromRadioStream *)cls;
+    webSessions->release(s->session);
+    delete s;
+}
+
 /*
  * Adapt the radioapi to the Webservice handleAPIv1FromRadio
  * Trigger : WebGui(POLL)->handleAPIv1FromRadio->phoneapi->Meshtastic(Radio) events
@@ -260,12 +377,16 @@ int handleAPIv1FromRadio(const struct _u_request *req, struct _u_response *res,
 {
 
     // LOG_DEBUG("handleAPIv1FromRadio radio -> web");
-    std::string valueAll;
+    const char *valueAll = u_map_get(req->map_url, "all");
+    const char *valueFramed = u_map_get(req->map_url, "framed");
+    const char *valueStream = u_map_get(req->map_url, "stream");
 
     // Status code is 200 OK by default.
     ulfius_add_header_to_response(res, "Content-Type", "application/x-protobuf");
     ulfius_add_header_to_response(res, "Access-Control-Allow-Origin", "*");
     ulfius_add_header_to_response(res, "Access-Control-Allow-Methods", "GET");
+    ulfius_add_header_to_response(res, "Access-Control-Allow-Headers", "X-Meshtastic-Session");
+    ulfius_add_header_to_response(res, "Access-Control-Expose-Headers", "X-Meshtastic-Session");
     ulfius_add_header_to_response(res, "X-Protobuf-Schema",
                                   "https://raw.githubusercontent.com/meshtastic/protobufs/master/meshtastic/mesh.proto");
 
@@ -274,33 +395,114 @@ int handleAPIv1FromRadio(const struct _u_request *req, struct _u_response *res,
         return U_CALLBACK_COMPLETE;
     }
 
-    uint8_t txBuf[MAX_STREAM_BUF_SIZE];
-    uint32_t len = 1;
-
-    if (valueAll == "true") {
-        while (len) {
-            len = webAPI.getFromRadio(txBuf);
-            ulfius_set_response_properties(res, U_OPT_STATUS, 200, U_OPT_BINARY_BODY, txBuf, len);
-            const char *tmpa = (const char *)txBuf;
-            ulfius_set_string_body_response(res, 200, tmpa);
-            // LOG_DEBUG("\n----webAPI response all:----");
-            // LOG_DEBUG(tmpa);
-            // LOG_DEBUG("");
-        }
+    WebSession *session = getSession(req, res);
+    if (!session)
+        return U_CALLBACK_COMPLETE;
+
+    WebFrame f;
+    if (valueStream && strcmp(valueStream, "true") == 0) {
+        // Hold the request open and send each FromRadio (with the serial API header) as soon as we have it
+        ulfius_set_stream_response(res, 200, fromRadioStreamRead, fromRadioStreamFree, U_STREAM_SIZE_UNKNOWN,
+                                   FROMRADIO_STREAM_BLOCK_SIZE, new FromRadioStream(session));
+        return U_CALLBACK_COMPLETE; // the session is released when the stream ends
+    } else if (valueFramed && strcmp(valueFramed, "true") == 0) {
+        // Everything available right now, each FromRadio with the serial API header in front so the client can split them
+        std::string body;
+        while (nextFromRadio(session, &f))
+            body.append((const char *)f.bytes, f.len);
+        ulfius_set_binary_body_response(res, 200, body.data(), body.size());
+    } else if (valueAll && strcmp(valueAll, "true") == 0) {
+        // If all is true, return all the buffers we have available to us at this point in time (back to back, like the ESP32)
+        std::string body;
+        while (nextFromRadio(session, &f))
+            body.append((const char *)f.bytes + STREAM_HEADER_LEN, f.len - STREAM_HEADER_LEN);
+        ulfius_set_binary_body_response(res, 200, body.data(), body.size());
         // Otherwise, just return one protobuf
+    } else if (nextFromRadio(session, &f)) {
+        ulfius_set_binary_body_response(res, 200, (const char *)f.bytes + STREAM_HEADER_LEN, f.len - STREAM_HEADER_LEN);
     } else {
-        len = webAPI.getFromRadio(txBuf);
-        const char *tmpa = (const char *)txBuf;
-        ulfius_set_binary_body_response(res, 200, tmpa, len);
-        // LOG_DEBUG("\n----webAPI response:");
-        // LOG_DEBUG(tmpa);
-        // LOG_DEBUG("");
+        ulfius_set_binary_body_response(res, 200, "", 0);
     }
 
+    webSessions->release(session);
     // LOG_DEBUG("end radio->web", len);
     return U_CALLBACK_COMPLETE;
 }
 
+/*
+ * mainScheduler may only be walked on the main loop (threads come and go at runtime), so it copies the thread stats here
+ * for /json/threads every THREAD_STATS_SNAPSHOT_MSEC
+ */
+#define THREAD_STATS_SNAPSHOT_MSEC 2000
+
+struct ThreadStatsEntry {
+    std::string name;
+    bool enabled;
+    concurrency::OSThread::Stats stats;
+};
+static std::mutex threadStatsLock;
+static std::vector<ThreadStatsEntry> threadStats;
+
+class ThreadStatsSnapshot : private concurrency::OSThread
+{
+  public:
+    ThreadStatsSnapshot() : OSThread("ThreadStats") {}
+
+  protected:
+    virtual int32_t runOnce() override
+    {
+        std::vector<ThreadStatsEntry> snapshot;
+        snapshot.reserve(concurrency::mainScheduler.size());
+        for (size_t i = 0; i < concurrency::mainScheduler.size(); i++) {
+            const concurrency::OSThread *thread = concurrency::mainScheduler.get(i);
+            snapshot.push_back({thread->ThreadName.c_str(), thread->enabled, thread->getStats()});
+        }
+
+        std::lock_guard<std::mutex> guard(threadStatsLock);
+        threadStats.swap(snapshot);
+        return THREAD_STATS_SNAPSHOT_MSEC;
+    }
+};
+
+/*
+ * Per-thread CPU and scheduling statistics, as of the last snapshot
+ */
+int handleJsonThreadStats(const struct _u_request *req, struct _u_response *res, void *user_data)
+{
+    ulfius_add_header_to_response(res, "Access-Control-Allow-Origin", "*");
+    ulfius_add_header_to_response(res, "Access-Control-Allow-Methods", "GET");
+
+    JSONArray threadList;
+    {
+        std::lock_guard<std::mutex> guard(threadStatsLock);
+        for (const ThreadStatsEntry &entry : threadStats) {
+            JSONObject t;
+            t["name"] = new JSONValue(entry.name.c_str());
+            t["enabled"] = new JSONValue(entry.enabled);
+            t["run_count"] = new JSONValue((unsigned int)entry.stats.runCount);
+            t["run_time_ms"] = new JSONValue((unsigned int)(entry.stats.runTimeUs / 1000));
+            t["max_run_time_us"] = new JSONValue((unsigned int)entry.stats.maxRunTimeUs);
+            t["max_latency_ms"] = new JSONValue((unsigned int)entry.stats.maxLatencyMsec);
+            t["total_latency_ms"] = new JSONValue((unsigned int)entry.stats.totalLatencyMsec);
+            threadList.push_back(new JSONValue(t));
+        }
+    }
+
+    JSONObject jsonObjInner;
+    jsonObjInner["threads"] = new JSONValue(threadList);
+    jsonObjInner["uptime_ms"] = new JSONValue((unsigned int)millis());
+
+    JSONObject jsonObjOuter;
+    jsonObjOuter["data"] = new JSONValue(jsonObjInner);
+    jsonObjOuter["status"] = new JSONValue("ok");
+
+    JSONValue *value = new JSONValue(jsonObjOuter);
+    ulfius_set_string_body_response(res, 200, value->Stringify().c_str());
+    ulfius_add_header_to_response(res, "Content-Type", "application/json");
+    delete value;
+    return U_CALLBACK_COMPLETE;
+}
+
 /*
 OpenSSL RSA Key Gen
 */
@@ -489,18 +691,20 @@ PiWebServerThread::PiWebServerThread()
         u_map_put(&configWeb.mime_types, ".svg", "image/svg+xml");
 
         webrootpath = settingsStrings[webserverrootpath];
+        webSessions = new WebSessions();
 
         configWeb.files_path = (char *)webrootpath.c_str();
         configWeb.url_prefix = "";
-        configWeb.rootPath = strdup(portduinoVFS->mountpoint());
 
         u_map_put(instanceWeb.default_headers, "Access-Control-Allow-Origin", "*");
         // Maximum body size sent by the client is 1 Kb
         instanceWeb.max_post_body_size = 1024;
         ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/api/v1/fromradio/*", 1, &handleAPIv1FromRadio, NULL);
         ulfius_add_endpoint_by_val(&instanceWeb, "OPTIONS", PREFIX, "/api/v1/fromradio/*", 1, &handleAPIv1FromRadio, NULL);
-        ulfius_add_endpoint_by_val(&instanceWeb, "PUT", PREFIX, "/api/v1/toradio/*", 1, &handleAPIv1ToRadio, configWeb.rootPath);
+        ulfius_add_endpoint_by_val(&instanceWeb, "PUT", PREFIX, "/api/v1/toradio/*", 1, &handleAPIv1ToRadio, NULL);
         ulfius_add_endpoint_by_val(&instanceWeb, "OPTIONS", PREFIX, "/api/v1/toradio/*", 1, &handleAPIv1ToRadio, NULL);
+        ulfius_add_endpoint_by_val(&instanceWeb, "GET", PREFIX, "/json/threads", 1, &handleJsonThreadStats, NULL);
+        new ThreadStatsSnapshot(); // we are constructed on the main loop
 
         // Add callback function to all endpoints for the Web Server
         ulfius_add_endpoint_by_val(&instanceWeb, "GET", NULL, "/*", 2, &callback_static_file, &configWeb);
@@ -526,7 +730,6 @@ PiWebServerThread::~PiWebServerThread()
 
     ulfius_stop_framework(&instanceWeb);
     ulfius_stop_framework(&instanceWeb);
-    free(configWeb.rootPath);
     ulfius_clean_instance(&instanceService);
     ulfius_clean_instance(&instanceService);
     free(cert_pem);
@@ -9,6 +9,11 @@
 
 #define STATIC_FILE_CHUNK 256
 
+// /api/v1/fromradio?stream=true checks for new FromRadios this often, and ends the response after this long without any
+#define FROMRADIO_STREAM_POLL_MSEC 20
+#define FROMRADIO_STREAM_IDLE_MSEC 25000
+#define FROMRADIO_STREAM_BLOCK_SIZE (4 * MAX_STREAM_BUF_SIZE)
+
 void initWebServer();
 void createSSLCert();
 int callback_static_file(const struct _u_request *request, struct _u_response *response, void *user_data);
@@ -20,7 +25,6 @@ struct _file_config {
     struct _u_map mime_types;
     struct _u_map map_header;
     char *redirect_on_404;
-    char *rootPath;
 };
 
 class PiWebServerThread
@@ -41,20 +45,6 @@ class PiWebServerThread
     struct _u_instance instanceService;
 };
 
-class HttpAPI : public PhoneAPI
-{
-
-  public:
-    // Nothing here yet
-
-  private:
-    // Nothing here yet
-
-  protected:
-    /// Check the current underlying physical link to see if the client is currently connected
-    virtual bool checkIsConnected() override { return true; } // FIXME, be smarter about this
-};
-
 extern PiWebServerThread *piwebServerThread;
 
 #endif
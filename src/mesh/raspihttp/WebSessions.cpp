@@ -0,0 +1,172 @@
+#ifdef PORTDUINO_LINUX_HARDWARE
+#include "WebSessions.h"
+#include "configuration.h"
+#include <random>
+#include <string.h>
+
+WebSessions *webSessions;
+
+void HttpAPI::onNowHasData(uint32_t fromRadioNum)
+{
+    webSessions->wake();
+}
+
+WebSessions::WebSessions() : concurrency::OSThread("WebSessions")
+{
+    for (auto &s : sessions)
+        s.toRadio.setReader(this);
+}
+
+WebSession *WebSessions::acquire(const char *token, bool crossOrigin)
+{
+    bool shared = !token && crossOrigin;
+    uint32_t start = millis();
+    while (true) {
+        {
+            std::lock_guard<std::mutex> guard(sessionsLock);
+            WebSession *s = find(token, shared);
+            if (!s)
+                s = claim(shared);
+            if (s) {
+                s->users++;
+                s->lastSeenMsec = millis();
+                return s;
+            }
+            if (!evictLeastRecentlyUsed())
+                break; // every session has a request going
+        }
+        if (millis() - start >= WEB_SESSION_EVICT_WAIT_MSEC)
+            break;
+        delay(WEB_SESSION_POLL_MSEC); // for the main loop to close it
+    }
+
+    LOG_WARN("All %d web API sessions are in use", WEB_SESSION_MAX);
+    return NULL;
+}
+
+/// The session with this token (or the shared one), with sessionsLock held
+WebSession *WebSessions::find(const char *token, bool shared)
+{
+    if (!shared && (!token || strlen(token) != WEB_SESSION_TOKEN_LEN))
+        return NULL;
+    for (auto &s : sessions) {
+        uint8_t state = s.state.load(std::memory_order_acquire);
+        if ((state == WebSession::NEW || state == WebSession::ACTIVE) &&
+            (shared ? s.shared : !s.shared && strcmp(s.token, token) == 0))
+            return &s;
+    }
+    return NULL;
+}
+
+/// Start a new session in a free slot, with sessionsLock held
+WebSession *WebSessions::claim(bool shared)
+{
+    for (auto &s : sessions) {
+        if (s.state.load(std::memory_order_acquire) == WebSession::FREE) {
+            static std::random_device random; // /dev/urandom
+            static const char hex[] = "0123456789abcdef";
+            for (int i = 0; i < WEB_SESSION_TOKEN_LEN; i++)
+                s.token[i] = hex[random() & 0xf];
+            s.token[WEB_SESSION_TOKEN_LEN] = '\0';
+            s.users = 0;
+            s.shared = shared;
+            s.state.store(WebSession::NEW, std::memory_order_release);
+            // the main loop notices when it next runs, and we can already queue ToRadios (which wakes it anyway)
+            LOG_INFO("Web API session %.8s started%s", s.token, shared ? " (shared)" : "");
+            return &s;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * With all slots taken, have the main loop close the session that was idle the longest (its client comes back to a new one),
+ * with sessionsLock held.  Returns false if there is none we can close.
+ */
+bool WebSessions::evictLeastRecentlyUsed()
+{
+    uint32_t now = millis();
+    WebSession *oldest = NULL;
+    for (auto &s : sessions) {
+        uint8_t state = s.state.load(std::memory_order_acquire);
+        if (state == WebSession::CLOSING)
+            return true; // already on its way out
+        if (state == WebSession::ACTIVE && s.users == 0 && (!oldest || now - s.lastSeenMsec > now - oldest->lastSeenMsec))
+            oldest = &s;
+    }
+    if (!oldest)
+        return false;
+
+    LOG_INFO("Web API session %.8s was idle the longest, closing it for a new client", oldest->token);
+    oldest->state.store(WebSession::CLOSING, std::memory_order_release);
+    wake();
+    return true;
+}
+
+void WebSessions::release(WebSession *s)
+{
+    s->lastSeenMsec = millis();
+    s->users--;
+}
+
+/// Close sessions nobody used for WEB_SESSION_TIMEOUT_MSEC
+void WebSessions::expire(uint32_t now)
+{
+    // Don't wait for the webserver threads, we'll just try again next time
+    std::unique_lock<std::mutex> guard(sessionsLock, std::try_to_lock);
+    if (!guard.owns_lock())
+        return;
+
+    for (auto &s : sessions) {
+        if (s.state.load(std::memory_order_acquire) == WebSession::ACTIVE && s.users == 0 &&
+            now - s.lastSeenMsec > WEB_SESSION_TIMEOUT_MSEC) {
+            // Lookups skip CLOSING sessions, so after this no request can get hold of it
+            s.state.store(WebSession::CLOSING, std::memory_order_release);
+        }
+    }
+}
+
+int32_t WebSessions::runOnce()
+{
+    uint32_t now = millis();
+    expire(now);
+
+    bool behind = false;
+    WebFrame f;
+    for (auto &s : sessions) {
+        switch (s.state.load(std::memory_order_acquire)) {
+        case WebSession::NEW:
+            s.api = new HttpAPI();
+            s.state.store(WebSession::ACTIVE, std::memory_order_release);
+            break;
+        case WebSession::ACTIVE:
+            break;
+        case WebSession::CLOSING:
+            LOG_INFO("Web API session %.8s closed", s.token);
+            delete s.api; // closes it
+            s.api = NULL;
+            while (s.toRadio.dequeue(&f))
+                ;
+            while (s.fromRadio.dequeue(&f))
+                ;
+            s.state.store(WebSession::FREE, std::memory_order_release);
+            continue;
+        default:
+            continue;
+        }
+
+        while (s.toRadio.dequeue(&f))
+            s.api->handleToRadio(f.bytes, f.len);
+
+        // Only take a FromRadio from PhoneAPI once there is room for it, it can't be put back
+        while (s.fromRadio.numFree() > 0 && (f.len = s.api->getFromRadioFramed(f.bytes)) != 0)
+            s.fromRadio.enqueue(f);
+        if (s.fromRadio.numFree() == 0)
+            behind = true;
+    }
+
+    // New FromRadios wake us (HttpAPI::onNowHasData), and so do ToRadios, but not the client catching up
+    return behind ? WEB_SESSION_POLL_MSEC : 1000;
+}
+
+#endif
@@ -0,0 +1,99 @@
+#pragma once
+#ifdef PORTDUINO_LINUX_HARDWARE
+#include "PhoneAPI.h"
+#include "concurrency/OSThread.h"
+#include "concurrency/SPSCQueue.h"
+#include <atomic>
+#include <mutex>
+
+// How many web clients can be connected at once, and how many ToRadios/FromRadios can wait for each in either direction
+#define WEB_SESSION_MAX 8
+#define WEB_SESSION_QUEUE_LEN 16
+// A session nobody asked anything for this long is closed (the stream response ends and is reopened every 25s)
+#define WEB_SESSION_TIMEOUT_MSEC (2 * 60 * 1000)
+// How often we move FromRadios while a client isn't keeping up with them (e.g. while it downloads the config)
+#define WEB_SESSION_POLL_MSEC 10
+// How long a new client waits for the main loop to close the least recently used session, if all are taken
+#define WEB_SESSION_EVICT_WAIT_MSEC 500
+#define WEB_SESSION_TOKEN_LEN 32
+#define WEB_SESSION_COOKIE "meshtastic_session"
+
+/// One ToRadio, or one FromRadio with the serial API header in front
+struct WebFrame {
+    uint16_t len;
+    uint8_t bytes[STREAM_HEADER_LEN + MAX_TO_FROM_RADIO_SIZE];
+};
+
+class HttpAPI : public PhoneAPI
+{
+  protected:
+    /// WebSessions closes us once the client stops asking
+    virtual bool checkIsConnected() override { return true; }
+
+    /// Have WebSessions move the new FromRadio to the web client
+    virtual void onNowHasData(uint32_t fromRadioNum) override;
+};
+
+/**
+ * One web client, known by the token in its cookie.
+ *
+ * ulfius runs each request on a thread of its own, but PhoneAPI (and everything it calls) must only be used from the main
+ * loop, so requests just hand ToRadios to WebSessions and take the FromRadios it prepared, over a pair of lock-free queues.
+ */
+struct WebSession {
+    enum State : uint8_t {
+        FREE,    // slot unused
+        NEW,     // claimed by a request, WebSessions hasn't created the HttpAPI yet (but the queues can be used already)
+        ACTIVE,  // in use
+        CLOSING, // expired, WebSessions is tearing it down
+    };
+    std::atomic<uint8_t> state{FREE};
+    char token[WEB_SESSION_TOKEN_LEN + 1] = {0};
+    std::atomic<uint32_t> lastSeenMsec{0};
+    std::atomic<uint16_t> users{0}; // requests using the session right now, it can't expire while there are any
+    bool shared = false;            // the session of all cross-origin clients without a token
+
+    /// A client can have several requests going at once, they take turns being the single producer/consumer of the queues
+    std::mutex httpLock;
+    concurrency::SPSCQueue<WebFrame> toRadio{WEB_SESSION_QUEUE_LEN};   // written by requests, read by the main loop
+    concurrency::SPSCQueue<WebFrame> fromRadio{WEB_SESSION_QUEUE_LEN}; // written by the main loop, read by requests
+
+    HttpAPI *api = NULL; // main loop only
+};
+
+/**
+ * The web API sessions (Linux native webserver), and the main loop side of them.
+ */
+class WebSessions : private concurrency::OSThread
+{
+  public:
+    WebSessions();
+
+    /**
+     * From a request: find the session with this token, or start a new one if there is none or it expired.  Cross-origin
+     * requests without a token all get the one shared session, those clients never send the cookie and would otherwise use
+     * up a session per request.  If all WEB_SESSION_MAX sessions are taken, the least recently used idle one is closed to
+     * make room, returns NULL only if all of them have requests going.  Every session acquired must be released.
+     */
+    WebSession *acquire(const char *token, bool crossOrigin);
+    void release(WebSession *s);
+
+    /// Move FromRadios as soon as we get to run, main loop only
+    void wake() { setInterval(0); }
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    WebSession sessions[WEB_SESSION_MAX];
+    std::mutex sessionsLock; // claiming and looking up slots, the main loop only ever tries it
+
+    void expire(uint32_t now);
+    WebSession *find(const char *token, bool shared);
+    WebSession *claim(bool shared);
+    bool evictLeastRecentlyUsed();
+};
+
+extern WebSessions *webSessions;
+
+#endif
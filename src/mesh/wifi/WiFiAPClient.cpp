@@ -1,6 +1,7 @@
 #include "configuration.h"
 #if HAS_WIFI
 #include "NodeDB.h"
+#include "PowerMon.h"
 #include "RTC.h"
 #include "concurrency/Periodic.h"
 #include "mesh/wifi/WiFiAPClient.h"
@@ -201,6 +202,7 @@ void deinitWifi()
         WiFi.disconnect(true);
 #endif
         WiFi.mode(WIFI_OFF);
+        powerMon->clearState(meshtastic_PowerMon_State_Wifi_On);
         LOG_INFO("WiFi Turned Off");
         // WiFi.printDiag(Serial);
     }
@@ -229,6 +231,7 @@ bool initWifi()
             snprintf(ourHost, sizeof(ourHost), "Meshtastic-%02x%02x", dmac[4], dmac[5]);
 
             WiFi.mode(WIFI_STA);
+            powerMon->setState(meshtastic_PowerMon_State_Wifi_On);
             WiFi.setHostname(ourHost);
 
             if (config.network.address_mode == meshtastic_Config_NetworkConfig_AddressMode_STATIC &&
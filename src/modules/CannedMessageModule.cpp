@@ -273,13 +273,13 @@ int CannedMessageModule::handleInputEvent(const InputEvent *event)
             if (config.bluetooth.enabled == true) {
                 config.bluetooth.enabled = false;
                 LOG_INFO("User toggled Bluetooth");
-                nodeDB->saveToDisk();
+                nodeDB->saveToDiskLater();
                 disableBluetooth();
                 showTemporaryMessage("Bluetooth OFF");
             } else if (config.bluetooth.enabled == false) {
                 config.bluetooth.enabled = true;
                 LOG_INFO("User toggled Bluetooth");
-                nodeDB->saveToDisk();
+                nodeDB->saveToDiskLater();
                 rebootAtMsec = millis() + 2000;
                 showTemporaryMessage("Bluetooth ON\nReboot");
             }
@@ -1151,8 +1151,8 @@ ProcessMessage CannedMessageModule::handleReceived(const meshtastic_MeshPacket &
             requestFocus(); // Tell Screen::setFrames that our module's frame should be shown, even if not "first" in the frameset
             this->runState = CANNED_MESSAGE_RUN_STATE_ACK_NACK_RECEIVED;
             this->incoming = service->getNodenumFromRequestId(mp.decoded.request_id);
-            meshtastic_Routing decoded = meshtastic_Routing_init_default;
-            pb_decode_from_bytes(mp.decoded.payload.bytes, mp.decoded.payload.size, meshtastic_Routing_fields, &decoded);
+            meshtastic_Routing decoded;
+            decodePayload(mp, meshtastic_Routing_fields, &decoded, sizeof(decoded));
             this->ack = decoded.error_reason == meshtastic_Routing_Error_NONE;
             waitingForAck = false; // No longer want routing packets
             this->notifyObservers(&e);
@@ -402,11 +402,10 @@ ProcessMessage StoreForwardModule::handleReceived(const meshtastic_MeshPacket &m
                 LOG_INFO("S&F stored. Message history contains %u records now", this->packetHistoryTotalCount);
             }
         } else if (!isFromUs(&mp) && mp.decoded.portnum == meshtastic_PortNum_STORE_FORWARD_APP) {
-            auto &p = mp.decoded;
             meshtastic_StoreAndForward scratch;
             meshtastic_StoreAndForward *decoded = NULL;
             if (mp.which_payload_variant == meshtastic_MeshPacket_decoded_tag) {
-                if (pb_decode_from_bytes(p.payload.bytes, p.payload.size, &meshtastic_StoreAndForward_msg, &scratch)) {
+                if (decodePayload(mp, &meshtastic_StoreAndForward_msg, &scratch, sizeof(scratch))) {
                     decoded = &scratch;
                 } else {
                     LOG_ERROR("Error decoding proto module!");
@@ -4,6 +4,7 @@
 #include "MeshService.h"
 #include "NodeDB.h"
 #include "PowerFSM.h"
+#include "PowerMon.h"
 #include "RTC.h"
 #include "RadioLibInterface.h"
 #include "Router.h"
@@ -141,6 +142,8 @@ meshtastic_Telemetry DeviceTelemetryModule::getLocalStatsTelemetry()
     if (router) {
         telemetry.variant.local_stats.num_rx_dupe = router->rxDupe;
         telemetry.variant.local_stats.num_tx_relay_canceled = router->txRelayCanceled;
+        if (router->getRxDropped())
+            LOG_WARN("Dropped %u received packets because fromRadioQ was full", router->getRxDropped());
     }
 
     LOG_INFO("Sending local stats: uptime=%i, channel_utilization=%f, air_util_tx=%f, num_online_nodes=%i, num_total_nodes=%i",
@@ -171,6 +174,9 @@ bool DeviceTelemetryModule::sendTelemetry(NodeNum dest, bool phoneOnly)
              telemetry.variant.device_metrics.air_util_tx, telemetry.variant.device_metrics.channel_utilization,
              telemetry.variant.device_metrics.battery_level, telemetry.variant.device_metrics.voltage,
              telemetry.variant.device_metrics.uptime_seconds);
+    // DeviceMetrics has no room for it, so at least keep a record of where the battery went (at the mesh interval)
+    if (!phoneOnly)
+        powerMon->logEnergyBudget();
 
     meshtastic_MeshPacket *p = allocDataProtobuf(telemetry);
     p->to = dest;
@@ -36,35 +36,69 @@
 #include "Sensor/SHT31Sensor.h"
 #include "Sensor/SHT4XSensor.h"
 #include "Sensor/SHTC3Sensor.h"
+#include "Sensor/SensorScheduler.h"
 #include "Sensor/T1000xSensor.h"
 #include "Sensor/TSL2591Sensor.h"
 #include "Sensor/VEML7700Sensor.h"
 
-BMP085Sensor bmp085Sensor;
-BMP280Sensor bmp280Sensor;
-BME280Sensor bme280Sensor;
-BME680Sensor bme680Sensor;
-MCP9808Sensor mcp9808Sensor;
-SHTC3Sensor shtc3Sensor;
-LPS22HBSensor lps22hbSensor;
-SHT31Sensor sht31Sensor;
-VEML7700Sensor veml7700Sensor;
-TSL2591Sensor tsl2591Sensor;
-OPT3001Sensor opt3001Sensor;
-SHT4XSensor sht4xSensor;
-RCWL9620Sensor rcwl9620Sensor;
-AHT10Sensor aht10Sensor;
-MLX90632Sensor mlx90632Sensor;
-DFRobotLarkSensor dfRobotLarkSensor;
-NAU7802Sensor nau7802Sensor;
-BMP3XXSensor bmp3xxSensor;
+namespace
+{
+/// Sensors only get constructed once the I2C scan found them, the ones PowerTelemetry also reads are shared with it
+template <class T> TelemetrySensor *newSensor()
+{
+    return new T();
+}
+template <class T, T *sensor> TelemetrySensor *sharedSensor()
+{
+    return sensor;
+}
+
+struct EnvironmentSensorDescriptor {
+    meshtastic_TelemetrySensorType type; // SENSOR_UNSET for on-board sensors the I2C scan doesn't look for
+    TelemetrySensor *(*create)();
+};
+
+/// Supported sensors, in the order their metrics are merged (the first to set a field wins). Adding one takes one line.
+const EnvironmentSensorDescriptor environmentSensors[] = {
 #ifdef T1000X_SENSOR_EN
-T1000xSensor t1000xSensor;
+    {meshtastic_TelemetrySensorType_SENSOR_UNSET, newSensor<T1000xSensor>},
+#else
+    {meshtastic_TelemetrySensorType_DFROBOT_LARK, newSensor<DFRobotLarkSensor>},
+    {meshtastic_TelemetrySensorType_SHT31, newSensor<SHT31Sensor>},
+    {meshtastic_TelemetrySensorType_SHT4X, newSensor<SHT4XSensor>},
+    {meshtastic_TelemetrySensorType_LPS22, newSensor<LPS22HBSensor>},
+    {meshtastic_TelemetrySensorType_SHTC3, newSensor<SHTC3Sensor>},
+    {meshtastic_TelemetrySensorType_BMP085, newSensor<BMP085Sensor>},
+    {meshtastic_TelemetrySensorType_BMP280, newSensor<BMP280Sensor>},
+    {meshtastic_TelemetrySensorType_BME280, newSensor<BME280Sensor>},
+    {meshtastic_TelemetrySensorType_BMP3XX, newSensor<BMP3XXSensor>},
+    {meshtastic_TelemetrySensorType_BME680, newSensor<BME680Sensor>},
+    {meshtastic_TelemetrySensorType_MCP9808, newSensor<MCP9808Sensor>},
+    {meshtastic_TelemetrySensorType_INA219, sharedSensor<INA219Sensor, &ina219Sensor>},
+    {meshtastic_TelemetrySensorType_INA260, sharedSensor<INA260Sensor, &ina260Sensor>},
+    {meshtastic_TelemetrySensorType_INA3221, sharedSensor<INA3221Sensor, &ina3221Sensor>},
+    {meshtastic_TelemetrySensorType_VEML7700, newSensor<VEML7700Sensor>},
+    {meshtastic_TelemetrySensorType_TSL25911FN, newSensor<TSL2591Sensor>},
+    {meshtastic_TelemetrySensorType_OPT3001, newSensor<OPT3001Sensor>},
+    {meshtastic_TelemetrySensorType_MLX90632, newSensor<MLX90632Sensor>},
+    {meshtastic_TelemetrySensorType_RCWL9620, newSensor<RCWL9620Sensor>},
+    {meshtastic_TelemetrySensorType_NAU7802, newSensor<NAU7802Sensor>},
+    {meshtastic_TelemetrySensorType_AHT10, newSensor<AHT10Sensor>},
+    {meshtastic_TelemetrySensorType_MAX17048, sharedSensor<MAX17048Sensor, &max17048Sensor>},
+    {meshtastic_TelemetrySensorType_RADSENS, newSensor<CGRadSensSensor>},
 #endif
-CGRadSensSensor cgRadSens;
+};
+
+bool isDetected(meshtastic_TelemetrySensorType type)
+{
+    return type == meshtastic_TelemetrySensorType_SENSOR_UNSET || nodeTelemetrySensorsMap[type].first > 0;
+}
+} // namespace
 
 #define FAILED_STATE_SENSOR_READ_MULTIPLIER 10
 #define DISPLAY_RECEIVEID_MEASUREMENTS_ON_SCREEN true
+// How often we check whether SensorScheduler is done sampling for a send
+#define SENSOR_SAMPLE_POLL_MSEC 50
 
 #include "graphics/ScreenFonts.h"
 #include <Throttle.h>
@@ -102,77 +136,53 @@ int32_t EnvironmentTelemetryModule::runOnce()
             LOG_INFO("Environment Telemetry: init");
             // it's possible to have this module enabled, only for displaying values on the screen.
             // therefore, we should only enable the sensor loop if measurement is also enabled
-#ifdef T1000X_SENSOR_EN
-            result = t1000xSensor.runOnce();
-#else
-            if (dfRobotLarkSensor.hasSensor())
-                result = dfRobotLarkSensor.runOnce();
-            if (bmp085Sensor.hasSensor())
-                result = bmp085Sensor.runOnce();
-            if (bmp280Sensor.hasSensor())
-                result = bmp280Sensor.runOnce();
-            if (bme280Sensor.hasSensor())
-                result = bme280Sensor.runOnce();
-            if (bmp3xxSensor.hasSensor())
-                result = bmp3xxSensor.runOnce();
-            if (bme680Sensor.hasSensor())
-                result = bme680Sensor.runOnce();
-            if (mcp9808Sensor.hasSensor())
-                result = mcp9808Sensor.runOnce();
-            if (shtc3Sensor.hasSensor())
-                result = shtc3Sensor.runOnce();
-            if (lps22hbSensor.hasSensor())
-                result = lps22hbSensor.runOnce();
-            if (sht31Sensor.hasSensor())
-                result = sht31Sensor.runOnce();
-            if (sht4xSensor.hasSensor())
-                result = sht4xSensor.runOnce();
-            if (ina219Sensor.hasSensor())
-                result = ina219Sensor.runOnce();
-            if (ina260Sensor.hasSensor())
-                result = ina260Sensor.runOnce();
-            if (ina3221Sensor.hasSensor())
-                result = ina3221Sensor.runOnce();
-            if (veml7700Sensor.hasSensor())
-                result = veml7700Sensor.runOnce();
-            if (tsl2591Sensor.hasSensor())
-                result = tsl2591Sensor.runOnce();
-            if (opt3001Sensor.hasSensor())
-                result = opt3001Sensor.runOnce();
-            if (rcwl9620Sensor.hasSensor())
-                result = rcwl9620Sensor.runOnce();
-            if (aht10Sensor.hasSensor())
-                result = aht10Sensor.runOnce();
-            if (mlx90632Sensor.hasSensor())
-                result = mlx90632Sensor.runOnce();
-            if (nau7802Sensor.hasSensor())
-                result = nau7802Sensor.runOnce();
-            if (max17048Sensor.hasSensor())
-                result = max17048Sensor.runOnce();
-            if (cgRadSens.hasSensor())
-                result = cgRadSens.runOnce();
-#endif
+            for (const EnvironmentSensorDescriptor &descriptor : environmentSensors) {
+                if (!isDetected(descriptor.type))
+                    continue;
+                TelemetrySensor *sensor = descriptor.create();
+                result = sensor->runOnce();
+                sensors.push_back(sensor);
+            }
+
+            // From now on the sensors are read in the background, and getEnvironmentTelemetry() uses what they last read
+            if (!sensorScheduler)
+                sensorScheduler = new SensorScheduler();
+            for (TelemetrySensor *sensor : sensors) {
+                // A sensor that didn't answer removed itself from nodeTelemetrySensorsMap
+                if (isDetected(sensor->getType()))
+                    sensorScheduler->add(sensor);
+            }
         }
         return result;
     } else {
         // if we somehow got to a second run of this module with measurement disabled, then just wait forever
         if (!moduleConfig.telemetry.environment_measurement_enabled) {
             return disable();
-        } else {
-            if (bme680Sensor.hasSensor())
-                result = bme680Sensor.runTrigger();
         }
 
-        if (((lastSentToMesh == 0) ||
+        bool meshDue =
+            ((lastSentToMesh == 0) ||
              !Throttle::isWithinTimespanMs(lastSentToMesh, Default::getConfiguredOrDefaultMsScaled(
                                                                moduleConfig.telemetry.environment_update_interval,
                                                                default_telemetry_broadcast_interval_secs, numOnlineNodes))) &&
             airTime->isTxAllowedChannelUtil(config.device.role != meshtastic_Config_DeviceConfig_Role_SENSOR) &&
-            airTime->isTxAllowedAirUtil()) {
+            airTime->isTxAllowedAirUtil();
+        bool phoneDue = ((lastSentToPhone == 0) || !Throttle::isWithinTimespanMs(lastSentToPhone, sendToPhoneIntervalMs)) &&
+                        (service->isToPhoneQueueEmpty());
+
+        // The sensors are only sampled for a send, have the scheduler do it and come back once it's done
+        if ((meshDue || phoneDue) && sensorScheduler && !sampleRequested) {
+            sensorScheduler->requestSample();
+            sampleRequested = true;
+        }
+        if (sampleRequested && sensorScheduler->isSampling())
+            return SENSOR_SAMPLE_POLL_MSEC;
+        sampleRequested = false;
+
+        if (meshDue) {
             sendTelemetry();
             lastSentToMesh = millis();
-        } else if (((lastSentToPhone == 0) || !Throttle::isWithinTimespanMs(lastSentToPhone, sendToPhoneIntervalMs)) &&
-                   (service->isToPhoneQueueEmpty())) {
+        } else if (phoneDue) {
             // Just send to phone when it's not our time to send to mesh yet
             // Only send while queue is empty (phone assumed connected)
             sendTelemetry(NODENUM_BROADCAST, true);
@@ -295,120 +305,23 @@ bool EnvironmentTelemetryModule::getEnvironmentTelemetry(meshtastic_Telemetry *m
     m->which_variant = meshtastic_Telemetry_environment_metrics_tag;
     m->variant.environment_metrics = meshtastic_EnvironmentMetrics_init_zero;
 
-#ifdef T1000X_SENSOR_EN // add by WayenWeng
-    valid = valid && t1000xSensor.getMetrics(m);
-    hasSensor = true;
-#else
-    if (dfRobotLarkSensor.hasSensor()) {
-        valid = valid && dfRobotLarkSensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (sht31Sensor.hasSensor()) {
-        valid = valid && sht31Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (sht4xSensor.hasSensor()) {
-        valid = valid && sht4xSensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (lps22hbSensor.hasSensor()) {
-        valid = valid && lps22hbSensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (shtc3Sensor.hasSensor()) {
-        valid = valid && shtc3Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (bmp085Sensor.hasSensor()) {
-        valid = valid && bmp085Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (bmp280Sensor.hasSensor()) {
-        valid = valid && bmp280Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (bme280Sensor.hasSensor()) {
-        valid = valid && bme280Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (bmp3xxSensor.hasSensor()) {
-        valid = valid && bmp3xxSensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (bme680Sensor.hasSensor()) {
-        valid = valid && bme680Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (mcp9808Sensor.hasSensor()) {
-        valid = valid && mcp9808Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (ina219Sensor.hasSensor()) {
-        valid = valid && ina219Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (ina260Sensor.hasSensor()) {
-        valid = valid && ina260Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (ina3221Sensor.hasSensor()) {
-        valid = valid && ina3221Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (veml7700Sensor.hasSensor()) {
-        valid = valid && veml7700Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (tsl2591Sensor.hasSensor()) {
-        valid = valid && tsl2591Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (opt3001Sensor.hasSensor()) {
-        valid = valid && opt3001Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (mlx90632Sensor.hasSensor()) {
-        valid = valid && mlx90632Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (rcwl9620Sensor.hasSensor()) {
-        valid = valid && rcwl9620Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (nau7802Sensor.hasSensor()) {
-        valid = valid && nau7802Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (aht10Sensor.hasSensor()) {
-        if (!bmp280Sensor.hasSensor() && !bmp3xxSensor.hasSensor()) {
-            valid = valid && aht10Sensor.getMetrics(m);
-            hasSensor = true;
-        } else if (bmp280Sensor.hasSensor()) {
-            // prefer bmp280 temp if both sensors are present, fetch only humidity
-            meshtastic_Telemetry m_ahtx = meshtastic_Telemetry_init_zero;
-            LOG_INFO("AHTX0+BMP280 module detected: using temp from BMP280 and humy from AHTX0");
-            aht10Sensor.getMetrics(&m_ahtx);
-            m->variant.environment_metrics.relative_humidity = m_ahtx.variant.environment_metrics.relative_humidity;
-            m->variant.environment_metrics.has_relative_humidity = m_ahtx.variant.environment_metrics.has_relative_humidity;
-        } else {
-            // prefer bmp3xx temp if both sensors are present, fetch only humidity
+    for (TelemetrySensor *sensor : sensors) {
+        if (!isDetected(sensor->getType()))
+            continue;
+        if (sensor->getType() == meshtastic_TelemetrySensorType_AHT10 && (isDetected(meshtastic_TelemetrySensorType_BMP280) ||
+                                                                           isDetected(meshtastic_TelemetrySensorType_BMP3XX))) {
+            // prefer the bmp280/bmp3xx temp if both sensors are present, fetch only humidity
             meshtastic_Telemetry m_ahtx = meshtastic_Telemetry_init_zero;
-            LOG_INFO("AHTX0+BMP3XX module detected: using temp from BMP3XX and humy from AHTX0");
-            aht10Sensor.getMetrics(&m_ahtx);
+            const char *other = isDetected(meshtastic_TelemetrySensorType_BMP280) ? "BMP280" : "BMP3XX";
+            LOG_INFO("AHTX0+%s module detected: using temp from %s and humy from AHTX0", other, other);
+            sensor->getLatestMetrics(&m_ahtx);
             m->variant.environment_metrics.relative_humidity = m_ahtx.variant.environment_metrics.relative_humidity;
             m->variant.environment_metrics.has_relative_humidity = m_ahtx.variant.environment_metrics.has_relative_humidity;
+            continue;
         }
-    }
-    if (max17048Sensor.hasSensor()) {
-        valid = valid && max17048Sensor.getMetrics(m);
-        hasSensor = true;
-    }
-    if (cgRadSens.hasSensor()) {
-        valid = valid && cgRadSens.getMetrics(m);
+        valid = valid && sensor->getLatestMetrics(m);
         hasSensor = true;
     }
-
-#endif
     return valid && hasSensor;
 }
 
@@ -445,11 +358,7 @@ bool EnvironmentTelemetryModule::sendTelemetry(NodeNum dest, bool phoneOnly)
     meshtastic_Telemetry m = meshtastic_Telemetry_init_zero;
     m.which_variant = meshtastic_Telemetry_environment_metrics_tag;
     m.time = getTime();
-#ifdef T1000X_SENSOR_EN
-    if (t1000xSensor.getMetrics(&m)) {
-#else
     if (getEnvironmentTelemetry(&m)) {
-#endif
         LOG_INFO("Send: barometric_pressure=%f, current=%f, gas_resistance=%f, relative_humidity=%f, temperature=%f",
                  m.variant.environment_metrics.barometric_pressure, m.variant.environment_metrics.current,
                  m.variant.environment_metrics.gas_resistance, m.variant.environment_metrics.relative_humidity,
@@ -499,113 +408,10 @@ AdminMessageHandleResult EnvironmentTelemetryModule::handleAdminMessageForModule
                                                                                  meshtastic_AdminMessage *response)
 {
     AdminMessageHandleResult result = AdminMessageHandleResult::NOT_HANDLED;
-    if (dfRobotLarkSensor.hasSensor()) {
-        result = dfRobotLarkSensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (sht31Sensor.hasSensor()) {
-        result = sht31Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (lps22hbSensor.hasSensor()) {
-        result = lps22hbSensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (shtc3Sensor.hasSensor()) {
-        result = shtc3Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (bmp085Sensor.hasSensor()) {
-        result = bmp085Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (bmp280Sensor.hasSensor()) {
-        result = bmp280Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (bme280Sensor.hasSensor()) {
-        result = bme280Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (bmp3xxSensor.hasSensor()) {
-        result = bmp3xxSensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (bme680Sensor.hasSensor()) {
-        result = bme680Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (mcp9808Sensor.hasSensor()) {
-        result = mcp9808Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (ina219Sensor.hasSensor()) {
-        result = ina219Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (ina260Sensor.hasSensor()) {
-        result = ina260Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (ina3221Sensor.hasSensor()) {
-        result = ina3221Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (veml7700Sensor.hasSensor()) {
-        result = veml7700Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (tsl2591Sensor.hasSensor()) {
-        result = tsl2591Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (opt3001Sensor.hasSensor()) {
-        result = opt3001Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (mlx90632Sensor.hasSensor()) {
-        result = mlx90632Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (rcwl9620Sensor.hasSensor()) {
-        result = rcwl9620Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (nau7802Sensor.hasSensor()) {
-        result = nau7802Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (aht10Sensor.hasSensor()) {
-        result = aht10Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (max17048Sensor.hasSensor()) {
-        result = max17048Sensor.handleAdminMessage(mp, request, response);
-        if (result != AdminMessageHandleResult::NOT_HANDLED)
-            return result;
-    }
-    if (cgRadSens.hasSensor()) {
-        result = cgRadSens.handleAdminMessage(mp, request, response);
+    for (TelemetrySensor *sensor : sensors) {
+        if (!isDetected(sensor->getType()))
+            continue;
+        result = sensor->handleAdminMessage(mp, request, response);
         if (result != AdminMessageHandleResult::NOT_HANDLED)
             return result;
     }
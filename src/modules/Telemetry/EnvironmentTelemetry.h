@@ -8,6 +8,9 @@
 #include "ProtobufModule.h"
 #include <OLEDDisplay.h>
 #include <OLEDDisplayUi.h>
+#include <vector>
+
+class TelemetrySensor;
 
 class EnvironmentTelemetryModule : private concurrency::OSThread, public ProtobufModule<meshtastic_Telemetry>
 {
@@ -57,7 +60,9 @@ class EnvironmentTelemetryModule : private concurrency::OSThread, public Protobu
     uint32_t sendToPhoneIntervalMs = SECONDS_IN_MINUTE * 1000; // Send to phone every minute
     uint32_t lastSentToMesh = 0;
     uint32_t lastSentToPhone = 0;
+    bool sampleRequested = false; // SensorScheduler is sampling for the send that is due
     uint32_t sensor_read_error_count = 0;
+    std::vector<TelemetrySensor *> sensors; // the ones we found, in the order of environmentSensors
 };
 
 #endif
\ No newline at end of file
@@ -25,10 +25,37 @@ int32_t AHT10Sensor::runOnce()
 
 void AHT10Sensor::setup() {}
 
+uint32_t AHT10Sensor::startConversion()
+{
+    const uint8_t trigger[] = {0xac, 0x33, 0x00};
+    conversionStarted = i2cWrite(trigger, sizeof(trigger));
+    return 80; // per the datasheet, the library waits for the busy bit the same way
+}
+
+bool AHT10Sensor::isConversionReady()
+{
+    uint8_t status;
+    return !i2cRead(&status, 1) || !(status & 0x80); // busy bit
+}
+
 bool AHT10Sensor::getMetrics(meshtastic_Telemetry *measurement)
 {
     LOG_DEBUG("AHT10 getMetrics");
 
+    if (conversionStarted) {
+        conversionStarted = false;
+        uint8_t data[6];
+        if (!i2cRead(data, sizeof(data)) || (data[0] & 0x80))
+            return false;
+        uint32_t rawHumidity = ((uint32_t)data[1] << 12) | ((uint32_t)data[2] << 4) | (data[3] >> 4);
+        uint32_t rawTemperature = (((uint32_t)data[3] & 0x0f) << 16) | ((uint32_t)data[4] << 8) | data[5];
+        measurement->variant.environment_metrics.has_temperature = true;
+        measurement->variant.environment_metrics.has_relative_humidity = true;
+        measurement->variant.environment_metrics.temperature = rawTemperature * 200.0f / 0x100000 - 50;
+        measurement->variant.environment_metrics.relative_humidity = rawHumidity * 100.0f / 0x100000;
+        return true;
+    }
+
     sensors_event_t humidity, temp;
     aht10.getEvent(&humidity, &temp);
 
@@ -10,6 +10,7 @@ class AHT10Sensor : public TelemetrySensor
 {
   private:
     Adafruit_AHTX0 aht10;
+    bool conversionStarted = false; // by startConversion(), getMetrics() only has to read the result
 
   protected:
     virtual void setup() override;
@@ -18,6 +19,8 @@ class AHT10Sensor : public TelemetrySensor
     AHT10Sensor();
     virtual int32_t runOnce() override;
     virtual bool getMetrics(meshtastic_Telemetry *measurement) override;
+    virtual uint32_t startConversion() override;
+    virtual bool isConversionReady() override;
 };
 
 #endif
\ No newline at end of file
@@ -29,6 +29,21 @@ int32_t BME280Sensor::runOnce()
 
 void BME280Sensor::setup() {}
 
+// The library only has a blocking forced measurement, so start it and check the status ourselves (its reads don't start one)
+uint32_t BME280Sensor::startConversion()
+{
+    const uint8_t ctrlMeas[] = {0xf4, 0x25}; // forced mode, temperature and pressure oversampling x1 (as set up in runOnce)
+    conversionStarted = i2cWrite(ctrlMeas, sizeof(ctrlMeas));
+    return 10; // at most 9.3ms with x1 oversampling
+}
+
+bool BME280Sensor::isConversionReady()
+{
+    const uint8_t status = 0xf3;
+    uint8_t value;
+    return !(i2cWrite(&status, 1) && i2cRead(&value, 1)) || !(value & 0x08); // measuring bit
+}
+
 bool BME280Sensor::getMetrics(meshtastic_Telemetry *measurement)
 {
     measurement->variant.environment_metrics.has_temperature = true;
@@ -36,7 +51,9 @@ bool BME280Sensor::getMetrics(meshtastic_Telemetry *measurement)
     measurement->variant.environment_metrics.has_barometric_pressure = true;
 
     LOG_DEBUG("BME280 getMetrics");
-    bme280.takeForcedMeasurement();
+    if (!conversionStarted)
+        bme280.takeForcedMeasurement();
+    conversionStarted = false;
     measurement->variant.environment_metrics.temperature = bme280.readTemperature();
     measurement->variant.environment_metrics.relative_humidity = bme280.readHumidity();
     measurement->variant.environment_metrics.barometric_pressure = bme280.readPressure() / 100.0F;
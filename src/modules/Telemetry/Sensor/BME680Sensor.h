@@ -38,7 +38,7 @@ class BME680Sensor : public TelemetrySensor
 
   public:
     BME680Sensor();
-    int32_t runTrigger();
+    virtual int32_t runTrigger() override;
     virtual int32_t runOnce() override;
     virtual bool getMetrics(meshtastic_Telemetry *measurement) override;
 };
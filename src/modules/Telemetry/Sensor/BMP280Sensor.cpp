@@ -29,13 +29,30 @@ int32_t BMP280Sensor::runOnce()
 
 void BMP280Sensor::setup() {}
 
+// Same registers as the BME280: takeForcedMeasurement() waits for the result, readTemperature() and readPressure() don't
+uint32_t BMP280Sensor::startConversion()
+{
+    const uint8_t ctrlMeas[] = {0xf4, 0x25}; // osrs_t x1, osrs_p x1, forced
+    conversionStarted = i2cWrite(ctrlMeas, sizeof(ctrlMeas));
+    return 7; // 6.4ms max
+}
+
+bool BMP280Sensor::isConversionReady()
+{
+    const uint8_t status = 0xf3;
+    uint8_t value;
+    return !(i2cWrite(&status, 1) && i2cRead(&value, 1)) || !(value & 0x08); // measuring bit
+}
+
 bool BMP280Sensor::getMetrics(meshtastic_Telemetry *measurement)
 {
     measurement->variant.environment_metrics.has_temperature = true;
     measurement->variant.environment_metrics.has_barometric_pressure = true;
 
     LOG_DEBUG("BMP280 getMetrics");
-    bmp280.takeForcedMeasurement();
+    if (!conversionStarted)
+        bmp280.takeForcedMeasurement();
+    conversionStarted = false;
     measurement->variant.environment_metrics.temperature = bmp280.readTemperature();
     measurement->variant.environment_metrics.barometric_pressure = bmp280.readPressure() / 100.0F;
 
@@ -37,8 +37,33 @@ void SHT4XSensor::setup()
     // Set up oversampling and filter initialization
 }
 
+uint32_t SHT4XSensor::startConversion()
+{
+    const uint8_t measureHighPrecision = 0xfd; // what the library uses by default
+    conversionStarted = i2cWrite(&measureHighPrecision, 1);
+    return 9; // at most 8.3ms
+}
+
+bool SHT4XSensor::isConversionReady()
+{
+    return true; // the SHT4x just NAKs reads until it is done, startConversion() returns how long that takes
+}
+
 bool SHT4XSensor::getMetrics(meshtastic_Telemetry *measurement)
 {
+    if (conversionStarted) {
+        conversionStarted = false;
+        uint8_t data[6];
+        if (!i2cRead(data, sizeof(data)) || crc8(data, 2) != data[2] || crc8(data + 3, 2) != data[5])
+            return false;
+        measurement->variant.environment_metrics.has_temperature = true;
+        measurement->variant.environment_metrics.has_relative_humidity = true;
+        measurement->variant.environment_metrics.temperature = -45 + 175 * ((data[0] << 8) | data[1]) / 65535.0f;
+        measurement->variant.environment_metrics.relative_humidity =
+            constrain(-6 + 125 * ((data[3] << 8) | data[4]) / 65535.0f, 0.0f, 100.0f);
+        return true;
+    }
+
     measurement->variant.environment_metrics.has_temperature = true;
     measurement->variant.environment_metrics.has_relative_humidity = true;
 
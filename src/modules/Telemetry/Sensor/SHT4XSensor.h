@@ -10,6 +10,7 @@ class SHT4XSensor : public TelemetrySensor
 {
   private:
     Adafruit_SHT4x sht4x = Adafruit_SHT4x();
+    bool conversionStarted = false; // by startConversion(), getMetrics() only has to read the result
 
   protected:
     virtual void setup() override;
@@ -18,6 +19,8 @@ class SHT4XSensor : public TelemetrySensor
     SHT4XSensor();
     virtual int32_t runOnce() override;
     virtual bool getMetrics(meshtastic_Telemetry *measurement) override;
+    virtual uint32_t startConversion() override;
+    virtual bool isConversionReady() override;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "configuration.h"
+
+#if !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR
+
+#include "SensorScheduler.h"
+
+SensorScheduler *sensorScheduler;
+
+SensorScheduler::SensorScheduler() : concurrency::OSThread("SensorScheduler") {}
+
+void SensorScheduler::add(TelemetrySensor *sensor)
+{
+    slots.push_back({sensor, false, false, 0, 0, millis()});
+    setIntervalFromNow(0);
+}
+
+void SensorScheduler::requestSample()
+{
+    for (auto &slot : slots)
+        slot.wanted = true;
+    setIntervalFromNow(0);
+}
+
+bool SensorScheduler::isSampling() const
+{
+    for (auto &slot : slots) {
+        if (slot.wanted || slot.converting)
+            return true;
+    }
+    return false;
+}
+
+int32_t SensorScheduler::runOnce()
+{
+    uint32_t now = millis();
+    int32_t next = SENSOR_TRIGGER_IDLE_MSEC;
+
+    // Start everything that was asked for first, so the conversions run at the same time
+    for (auto &slot : slots) {
+        if ((int32_t)(now - slot.triggerMsec) >= 0) {
+            int32_t wait = slot.sensor->runTrigger();
+            slot.triggerMsec = now + (wait == INT32_MAX ? SENSOR_TRIGGER_IDLE_MSEC : wait);
+        }
+        next = min(next, (int32_t)(slot.triggerMsec - now));
+
+        if (slot.wanted && !slot.converting) {
+            slot.wanted = false;
+            slot.converting = true;
+            slot.startedMsec = now;
+            slot.readyMsec = now + slot.sensor->startConversion();
+        }
+    }
+
+    for (auto &slot : slots) {
+        if (!slot.converting)
+            continue;
+        if ((int32_t)(millis() - slot.readyMsec) < 0) {
+            next = min(next, (int32_t)(slot.readyMsec - millis()));
+            continue;
+        }
+        if (!slot.sensor->isConversionReady() && millis() - slot.startedMsec < SENSOR_CONVERSION_TIMEOUT_MSEC) {
+            next = min(next, (int32_t)SENSOR_READY_POLL_MSEC);
+            continue;
+        }
+
+        meshtastic_Telemetry m = meshtastic_Telemetry_init_zero;
+        m.which_variant = meshtastic_Telemetry_environment_metrics_tag;
+        bool valid = slot.sensor->getMetrics(&m);
+        slot.sensor->setLatestSample(m.variant.environment_metrics, valid);
+        slot.converting = false;
+    }
+
+    return max(next, (int32_t)0);
+}
+
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+#include "configuration.h"
+
+#if !MESHTASTIC_EXCLUDE_ENVIRONMENTAL_SENSOR
+
+#include "TelemetrySensor.h"
+#include "concurrency/OSThread.h"
+#include <vector>
+
+// A sensor still busy this long after it said it would be done is read anyway
+#define SENSOR_CONVERSION_TIMEOUT_MSEC 1000
+// How often we ask a sensor that is late whether it is done yet
+#define SENSOR_READY_POLL_MSEC 5
+// Sensors whose library doesn't need runTrigger() are still asked this often
+#define SENSOR_TRIGGER_IDLE_MSEC (5 * 60 * 1000)
+
+/**
+ * Samples the environment sensors in the background and keeps the latest sample of each (TelemetrySensor::getLatestMetrics),
+ * so sending telemetry or answering a request never waits for the I2C bus.
+ *
+ * A round is only taken when asked for (requestSample), EnvironmentTelemetryModule does so when a send is due.  It first
+ * starts a conversion on every sensor (on all buses), then reads each one as it becomes ready, so the conversions overlap
+ * instead of the main loop waiting for them one after the other.
+ */
+class SensorScheduler : private concurrency::OSThread
+{
+  public:
+    SensorScheduler();
+
+    void add(TelemetrySensor *sensor);
+
+    /// Sample every sensor as soon as we get to run
+    void requestSample();
+
+    /// Whether the round asked for is still going
+    bool isSampling() const;
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    struct Slot {
+        TelemetrySensor *sensor;
+        bool wanted, converting;
+        uint32_t startedMsec, readyMsec; // while converting
+        uint32_t triggerMsec;            // when the sensor wants its runTrigger() called
+    };
+    std::vector<Slot> slots;
+};
+
+extern SensorScheduler *sensorScheduler;
+
+#endif
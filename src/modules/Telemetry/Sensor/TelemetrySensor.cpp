@@ -6,5 +6,80 @@
 #include "NodeDB.h"
 #include "TelemetrySensor.h"
 #include "main.h"
+#include <Wire.h>
 
-#endif
\ No newline at end of file
+bool TelemetrySensor::i2cWrite(const uint8_t *bytes, size_t len)
+{
+    TwoWire *wire = nodeTelemetrySensorsMap[sensorType].second;
+    wire->beginTransmission(nodeTelemetrySensorsMap[sensorType].first);
+    wire->write(bytes, len);
+    return wire->endTransmission() == 0;
+}
+
+bool TelemetrySensor::i2cRead(uint8_t *bytes, size_t len)
+{
+    TwoWire *wire = nodeTelemetrySensorsMap[sensorType].second;
+    if (wire->requestFrom(nodeTelemetrySensorsMap[sensorType].first, (uint8_t)len) != len)
+        return false;
+    for (size_t i = 0; i < len; i++)
+        bytes[i] = wire->read();
+    return true;
+}
+
+uint8_t TelemetrySensor::crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = 0xff;
+    while (len--) {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++)
+            crc = crc & 0x80 ? (crc << 1) ^ 0x31 : crc << 1;
+    }
+    return crc;
+}
+
+void TelemetrySensor::setLatestSample(const meshtastic_EnvironmentMetrics &metrics, bool valid)
+{
+    latestSample = metrics;
+    latestSampleValid = valid;
+    latestSampleMsec = millis();
+    hasLatestSample = true;
+}
+
+bool TelemetrySensor::getLatestMetrics(meshtastic_Telemetry *measurement)
+{
+    if (!hasLatestSample || millis() - latestSampleMsec > SENSOR_SAMPLE_MAX_AGE_MSEC)
+        return getMetrics(measurement);
+    if (!latestSampleValid)
+        return false;
+
+    // Only the values this sensor measured, the others come from other sensors
+    meshtastic_EnvironmentMetrics &to = measurement->variant.environment_metrics;
+    const meshtastic_EnvironmentMetrics &from = latestSample;
+#define MERGE(field)                                                                                                             \
+    if (from.has_##field) {                                                                                                      \
+        to.has_##field = true;                                                                                                   \
+        to.field = from.field;                                                                                                   \
+    }
+    MERGE(temperature)
+    MERGE(relative_humidity)
+    MERGE(barometric_pressure)
+    MERGE(gas_resistance)
+    MERGE(voltage)
+    MERGE(current)
+    MERGE(iaq)
+    MERGE(distance)
+    MERGE(lux)
+    MERGE(white_lux)
+    MERGE(ir_lux)
+    MERGE(uv_lux)
+    MERGE(wind_direction)
+    MERGE(wind_speed)
+    MERGE(weight)
+    MERGE(wind_gust)
+    MERGE(wind_lull)
+    MERGE(radiation)
+#undef MERGE
+    return true;
+}
+
+#endif
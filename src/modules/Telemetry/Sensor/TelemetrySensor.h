@@ -11,6 +11,8 @@
 class TwoWire;
 
 #define DEFAULT_SENSOR_MINIMUM_WAIT_TIME_BETWEEN_READS 1000
+// A sample older than this isn't used, the sensor is read again instead (e.g. if SensorScheduler isn't running)
+#define SENSOR_SAMPLE_MAX_AGE_MSEC (5 * 60 * 1000)
 extern std::pair<uint8_t, TwoWire *> nodeTelemetrySensorsMap[_meshtastic_TelemetrySensorType_MAX + 1];
 
 class TelemetrySensor
@@ -42,6 +44,12 @@ class TelemetrySensor
     }
     virtual void setup();
 
+    /// Raw transfers with the sensor at its detected address and bus, for the phases the sensor library can't do separately
+    bool i2cWrite(const uint8_t *bytes, size_t len);
+    bool i2cRead(uint8_t *bytes, size_t len);
+    /// CRC of Sensirion and Aosong sensors (polynomial 0x31, initial value 0xff)
+    static uint8_t crc8(const uint8_t *data, size_t len);
+
   public:
     virtual AdminMessageHandleResult handleAdminMessage(const meshtastic_MeshPacket &mp, meshtastic_AdminMessage *request,
                                                         meshtastic_AdminMessage *response)
@@ -50,12 +58,34 @@ class TelemetrySensor
     }
 
     bool hasSensor() { return nodeTelemetrySensorsMap[sensorType].first > 0; }
+    meshtastic_TelemetrySensorType getType() const { return sensorType; }
 
     virtual int32_t runOnce() = 0;
     virtual bool isInitialized() { return initialized; }
     virtual bool isRunning() { return status > 0; }
 
     virtual bool getMetrics(meshtastic_Telemetry *measurement) = 0;
+
+    /**
+     * Sampling in phases, so SensorScheduler can have all sensors converting at once instead of waiting for each in turn.
+     * startConversion() starts a measurement and returns about how many ms it takes, then isConversionReady() is polled until
+     * getMetrics() can read the result without waiting.  Sensors that don't override these are just read with getMetrics().
+     */
+    virtual uint32_t startConversion() { return 0; }
+    virtual bool isConversionReady() { return true; }
+
+    /// For sensor libraries that must be run regularly (BSEC), returns ms until they want to run again
+    virtual int32_t runTrigger() { return INT32_MAX; }
+
+    /// Add the last sample SensorScheduler took to measurement, or read the sensor now if there is no recent one
+    bool getLatestMetrics(meshtastic_Telemetry *measurement);
+
+    void setLatestSample(const meshtastic_EnvironmentMetrics &metrics, bool valid);
+
+  private:
+    meshtastic_EnvironmentMetrics latestSample = meshtastic_EnvironmentMetrics_init_zero;
+    bool hasLatestSample = false, latestSampleValid = false;
+    uint32_t latestSampleMsec = 0;
 };
 
 #endif
\ No newline at end of file
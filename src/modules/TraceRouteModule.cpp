@@ -152,11 +152,9 @@ meshtastic_MeshPacket *TraceRouteModule::allocReply()
 
     // Copy the payload of the current request
     auto req = *currentRequest;
-    const auto &p = req.decoded;
     meshtastic_RouteDiscovery scratch;
     meshtastic_RouteDiscovery *updated = NULL;
-    memset(&scratch, 0, sizeof(scratch));
-    pb_decode_from_bytes(p.payload.bytes, p.payload.size, &meshtastic_RouteDiscovery_msg, &scratch);
+    decodePayload(req, &meshtastic_RouteDiscovery_msg, &scratch, sizeof(scratch));
     updated = &scratch;
 
     // Create a MeshPacket with this payload and set it as the reply
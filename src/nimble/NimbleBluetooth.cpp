@@ -3,20 +3,84 @@
 #include "BluetoothCommon.h"
 #include "NimbleBluetooth.h"
 #include "PowerFSM.h"
+#include "PowerMon.h"
 
+#include "concurrency/LockGuard.h"
+#include "concurrency/OSThread.h"
 #include "main.h"
 #include "mesh/PhoneAPI.h"
 #include "mesh/mesh-pb-constants.h"
 #include "sleep.h"
 #include <NimBLEDevice.h>
+#include <atomic>
+
+// Largest MTU we ask for, a whole ToRadio/FromRadio (512 bytes) plus the ATT header
+#define BLE_MTU_WANTED 517
+// LE data length extension, the most payload bytes per link layer packet
+#define BLE_DATA_LEN_WANTED 251
+// Longest value of the FromRadio stream characteristic (the most ATT allows)
+#define BLE_STREAM_MAX_VALUE 512
+// While a client streams FromRadios we leave the host this many buffers (for ACKs and the like) before we notify again
+#define BLE_STREAM_MIN_FREE_MBUFS 4
+#define BLE_STREAM_POLL_MSEC 5
+// How often the link rates are logged while a client is connected
+#define BLE_STATS_MSEC (30 * 1000)
 
 NimBLECharacteristic *fromNumCharacteristic;
+NimBLECharacteristic *fromRadioStreamCharacteristic;
 NimBLECharacteristic *BatteryCharacteristic;
 NimBLECharacteristic *logRadioCharacteristic;
 NimBLEServer *bleServer;
 
 static bool passkeyShowing;
 
+/// What went over the link since the stats were last logged, updated from both the main loop and the NimBLE host task
+static std::atomic<uint32_t> fromRadioMsgCount, fromRadioByteCount, toRadioMsgCount, toRadioByteCount;
+
+/// PhoneAPI and the stream's partly sent frame: the main loop notifies, the NimBLE host task writes, reads and disconnects
+static concurrency::Lock *fromRadioLock;
+
+/**
+ * FROMRADIOSTREAM_UUID: the FromRadios as one byte stream, framed like the serial API, cut into pieces as big as the MTU allows.
+ *
+ * Clients read it (each read returns as much as fits in one ATT response) or better subscribe to it, then
+ * BluetoothFromRadioStream notifies whatever we have without waiting to be asked.  Either way one round trip carries several
+ * FromRadios instead of one, which matters most while downloading the config and NodeDB.  A client uses either this or the
+ * FROMRADIO_UUID characteristic, not both.
+ */
+class BluetoothFromRadioStream : public concurrency::OSThread
+{
+  public:
+    BluetoothFromRadioStream() : concurrency::OSThread("BluetoothFromRadioStream", BLE_STATS_MSEC) {}
+
+    std::atomic<bool> subscribed{false};
+
+    /// Copy up to max bytes of the stream to out, returns how many
+    size_t read(PhoneAPI *api, uint8_t *out, size_t max);
+
+    /// Forget the partly sent frame, call with fromRadioLock held
+    void reset() { frameLen = frameSent = 0; }
+
+    /// Notify FromRadios as soon as we get to run (also from the NimBLE host task, while the main loop sleeps)
+    void wake()
+    {
+        setIntervalFromNow(0);
+        concurrency::mainDelay.interrupt();
+    }
+
+  protected:
+    virtual int32_t runOnce() override;
+
+  private:
+    uint8_t frame[STREAM_HEADER_LEN + MAX_TO_FROM_RADIO_SIZE]; // the FromRadio we are in the middle of
+    size_t frameLen = 0, frameSent = 0;
+    uint32_t statsStartMsec = 0;
+
+    void logStats();
+};
+
+static BluetoothFromRadioStream *fromRadioStream;
+
 class BluetoothPhoneAPI : public PhoneAPI
 {
     /**
@@ -26,6 +90,11 @@ class BluetoothPhoneAPI : public PhoneAPI
     {
         PhoneAPI::onNowHasData(fromRadioNum);
 
+        if (fromRadioStream->subscribed) {
+            fromRadioStream->wake(); // the packet itself is on its way, no need to tell the client to come and get it
+            return;
+        }
+
         LOG_INFO("BLE notify fromNum");
 
         uint8_t val[4];
@@ -40,9 +109,64 @@ class BluetoothPhoneAPI : public PhoneAPI
 };
 
 static BluetoothPhoneAPI *bluetoothPhoneAPI;
-/**
- * Subclasses can use this as a hook to provide custom notifications for their transport (i.e. bluetooth notifies)
- */
+
+size_t BluetoothFromRadioStream::read(PhoneAPI *api, uint8_t *out, size_t max)
+{
+    concurrency::LockGuard guard(fromRadioLock);
+    size_t n = 0;
+    while (n < max) {
+        if (frameSent == frameLen) {
+            frameSent = 0;
+            frameLen = api->getFromRadioFramed(frame);
+            if (!frameLen)
+                break;
+            fromRadioMsgCount++;
+        }
+        size_t len = std::min(max - n, frameLen - frameSent);
+        memcpy(out + n, frame + frameSent, len);
+        frameSent += len;
+        n += len;
+    }
+    fromRadioByteCount += n;
+    return n;
+}
+
+int32_t BluetoothFromRadioStream::runOnce()
+{
+    logStats();
+    if (!subscribed || !bleServer || bleServer->getConnectedCount() == 0)
+        return BLE_STATS_MSEC;
+
+    // Notifications are taken from the host's buffer pool, if we use it all up the client's requests can't be answered
+    uint8_t buf[BLE_STREAM_MAX_VALUE];
+    uint16_t max = std::min<uint16_t>(bleServer->getPeerMTU(bleServer->getPeerInfo(0).getConnHandle()) - 3, sizeof(buf));
+    while (os_msys_num_free() > BLE_STREAM_MIN_FREE_MBUFS) {
+        size_t n = read(bluetoothPhoneAPI, buf, max);
+        if (!n)
+            return BLE_STATS_MSEC; // BluetoothPhoneAPI wakes us when there is more
+        fromRadioStreamCharacteristic->notify(buf, n);
+        if (n < max)
+            return BLE_STREAM_POLL_MSEC; // PhoneAPI might have more soon (e.g. the next part of the config)
+    }
+    return BLE_STREAM_POLL_MSEC;
+}
+
+void BluetoothFromRadioStream::logStats()
+{
+    uint32_t now = millis();
+    uint32_t elapsed = now - statsStartMsec;
+    if (elapsed < BLE_STATS_MSEC)
+        return;
+    statsStartMsec = now;
+
+    // In hundredths per second
+    auto rate = [elapsed](uint32_t count) { return (uint32_t)((uint64_t)count * 100000 / elapsed); };
+    uint32_t msgs = rate(fromRadioMsgCount.exchange(0)), bytes = rate(fromRadioByteCount.exchange(0));
+    uint32_t inMsgs = rate(toRadioMsgCount.exchange(0)), inBytes = rate(toRadioByteCount.exchange(0));
+    if (msgs || inMsgs)
+        LOG_INFO("BLE FromRadio %u.%02u msgs/s %u B/s, ToRadio %u.%02u msgs/s %u B/s", msgs / 100, msgs % 100, bytes / 100,
+                 inMsgs / 100, inMsgs % 100, inBytes / 100);
+}
 
 // Last ToRadio value received from the phone
 static uint8_t lastToRadio[MAX_TO_FROM_RADIO_SIZE];
@@ -57,6 +181,10 @@ class NimbleBluetoothToRadioCallback : public NimBLECharacteristicCallbacks
         if (memcmp(lastToRadio, val.data(), val.length()) != 0) {
             LOG_DEBUG("New ToRadio packet");
             memcpy(lastToRadio, val.data(), val.length());
+            toRadioMsgCount++;
+            toRadioByteCount += val.length();
+            // want_config resets what getFromRadio() is in the middle of sending, which the main loop may be doing right now
+            concurrency::LockGuard guard(fromRadioLock);
             bluetoothPhoneAPI->handleToRadio(val.data(), val.length());
         } else {
             LOG_DEBUG("Drop dup ToRadio packet we just saw");
@@ -69,11 +197,36 @@ class NimbleBluetoothFromRadioCallback : public NimBLECharacteristicCallbacks
     virtual void onRead(NimBLECharacteristic *pCharacteristic)
     {
         uint8_t fromRadioBytes[meshtastic_FromRadio_size];
-        size_t numBytes = bluetoothPhoneAPI->getFromRadio(fromRadioBytes);
+        size_t numBytes;
+        {
+            concurrency::LockGuard guard(fromRadioLock);
+            numBytes = bluetoothPhoneAPI->getFromRadio(fromRadioBytes);
+        }
+        if (numBytes) {
+            fromRadioMsgCount++;
+            fromRadioByteCount += numBytes;
+        }
 
-        std::string fromRadioByteString(fromRadioBytes, fromRadioBytes + numBytes);
+        pCharacteristic->setValue(fromRadioBytes, numBytes);
+    }
+};
 
-        pCharacteristic->setValue(fromRadioByteString);
+class NimbleBluetoothFromRadioStreamCallback : public NimBLECharacteristicCallbacks
+{
+    virtual void onRead(NimBLECharacteristic *pCharacteristic, ble_gap_conn_desc *desc)
+    {
+        // What fits in one read response, longer values would need a Read Blob round trip for each MTU's worth
+        uint8_t buf[BLE_STREAM_MAX_VALUE];
+        size_t max = std::min<size_t>(bleServer->getPeerMTU(desc->conn_handle) - 1, sizeof(buf));
+        pCharacteristic->setValue(buf, fromRadioStream->read(bluetoothPhoneAPI, buf, max));
+    }
+
+    virtual void onSubscribe(NimBLECharacteristic *pCharacteristic, ble_gap_conn_desc *desc, uint16_t subValue)
+    {
+        LOG_INFO("BLE FromRadio stream %s", subValue ? "subscribed" : "unsubscribed");
+        fromRadioStream->subscribed = subValue != 0;
+        if (subValue)
+            fromRadioStream->wake();
     }
 };
 
@@ -133,10 +286,25 @@ class NimbleBluetoothServerCallback : public NimBLEServerCallbacks
         }
     }
 
+    virtual void onConnect(NimBLEServer *pServer, ble_gap_conn_desc *desc)
+    {
+        // Longer link layer packets and (where the radio has it) the 2M PHY, so more FromRadio bytes fit in each connection event
+        pServer->setDataLen(desc->conn_handle, BLE_DATA_LEN_WANTED);
+#if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(CONFIG_IDF_TARGET_ESP32C3) || defined(CONFIG_IDF_TARGET_ESP32C6)
+        ble_gap_set_prefered_le_phy(desc->conn_handle, BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_2M_MASK, BLE_GAP_LE_PHY_CODED_ANY);
+#endif
+    }
+
+    virtual void onMTUChange(uint16_t MTU, ble_gap_conn_desc *desc) { LOG_INFO("BLE MTU %u", MTU); }
+
     virtual void onDisconnect(NimBLEServer *pServer, ble_gap_conn_desc *desc)
     {
         LOG_INFO("BLE disconnect");
 
+        fromRadioStream->subscribed = false;
+
+        concurrency::LockGuard guard(fromRadioLock);
+        fromRadioStream->reset();
         if (bluetoothPhoneAPI) {
             bluetoothPhoneAPI->close();
         }
@@ -145,6 +313,7 @@ class NimbleBluetoothServerCallback : public NimBLEServerCallbacks
 
 static NimbleBluetoothToRadioCallback *toRadioCallbacks;
 static NimbleBluetoothFromRadioCallback *fromRadioCallbacks;
+static NimbleBluetoothFromRadioStreamCallback *fromRadioStreamCallbacks;
 
 void NimbleBluetooth::shutdown()
 {
@@ -164,6 +333,7 @@ void NimbleBluetooth::deinit()
 #ifdef ARCH_ESP32
     LOG_INFO("Disable bluetooth until reboot");
     NimBLEDevice::deinit();
+    powerMon->clearState(meshtastic_PowerMon_State_BT_On);
 #endif
 }
 
@@ -197,6 +367,7 @@ void NimbleBluetooth::setup()
 
     NimBLEDevice::init(getDeviceName());
     NimBLEDevice::setPower(ESP_PWR_LVL_P9);
+    NimBLEDevice::setMTU(BLE_MTU_WANTED);
 
     if (config.bluetooth.mode != meshtastic_Config_BluetoothConfig_PairingMode_NO_PIN) {
         NimBLEDevice::setSecurityAuth(BLE_SM_PAIR_AUTHREQ_BOND | BLE_SM_PAIR_AUTHREQ_MITM | BLE_SM_PAIR_AUTHREQ_SC);
@@ -221,6 +392,9 @@ void NimbleBluetooth::setupService()
     if (config.bluetooth.mode == meshtastic_Config_BluetoothConfig_PairingMode_NO_PIN) {
         ToRadioCharacteristic = bleService->createCharacteristic(TORADIO_UUID, NIMBLE_PROPERTY::WRITE);
         FromRadioCharacteristic = bleService->createCharacteristic(FROMRADIO_UUID, NIMBLE_PROPERTY::READ);
+        fromRadioStreamCharacteristic =
+            bleService->createCharacteristic(FROMRADIOSTREAM_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY,
+                                            BLE_STREAM_MAX_VALUE);
         fromNumCharacteristic = bleService->createCharacteristic(FROMNUM_UUID, NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ);
         logRadioCharacteristic =
             bleService->createCharacteristic(LOGRADIO_UUID, NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ, 512U);
@@ -229,6 +403,10 @@ void NimbleBluetooth::setupService()
             TORADIO_UUID, NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_AUTHEN | NIMBLE_PROPERTY::WRITE_ENC);
         FromRadioCharacteristic = bleService->createCharacteristic(
             FROMRADIO_UUID, NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::READ_AUTHEN | NIMBLE_PROPERTY::READ_ENC);
+        fromRadioStreamCharacteristic = bleService->createCharacteristic(
+            FROMRADIOSTREAM_UUID,
+            NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ_AUTHEN | NIMBLE_PROPERTY::READ_ENC,
+            BLE_STREAM_MAX_VALUE);
         fromNumCharacteristic =
             bleService->createCharacteristic(FROMNUM_UUID, NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ |
                                                                NIMBLE_PROPERTY::READ_AUTHEN | NIMBLE_PROPERTY::READ_ENC);
@@ -237,6 +415,10 @@ void NimbleBluetooth::setupService()
             NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::READ_AUTHEN | NIMBLE_PROPERTY::READ_ENC, 512U);
     }
     bluetoothPhoneAPI = new BluetoothPhoneAPI();
+    if (!fromRadioLock)
+        fromRadioLock = new concurrency::Lock();
+    if (!fromRadioStream)
+        fromRadioStream = new BluetoothFromRadioStream();
 
     toRadioCallbacks = new NimbleBluetoothToRadioCallback();
     ToRadioCharacteristic->setCallbacks(toRadioCallbacks);
@@ -244,6 +426,9 @@ void NimbleBluetooth::setupService()
     fromRadioCallbacks = new NimbleBluetoothFromRadioCallback();
     FromRadioCharacteristic->setCallbacks(fromRadioCallbacks);
 
+    fromRadioStreamCallbacks = new NimbleBluetoothFromRadioStreamCallback();
+    fromRadioStreamCharacteristic->setCallbacks(fromRadioStreamCallbacks);
+
     bleService->start();
 
     // Setup the battery service
@@ -0,0 +1,409 @@
+#include "MeshSimulator.h"
+#include "DisplayFormatters.h"
+#include "RadioInterface.h"
+#include <Arduino.h>
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+// We don't model the region, any sub-GHz band is close enough for path loss
+#define SIM_FREQ_MHZ 915.0f
+#define SIM_NOISE_FIGURE_DB 6.0f
+// An overlapping packet this much weaker doesn't keep us from decoding (LoRa capture effect)
+#define SIM_CAPTURE_DB 6.0f
+#define SIM_PREAMBLE_LENGTH 16 // same as RadioInterface
+#define SIM_MAX_NODES 4000     // the link table is nodes^2 floats
+// The radios don't report an SNR above this, however strong the signal
+#define SIM_MAX_REPORTED_SNR 15.0f
+
+bool MeshSimConfig::parse(const char *spec)
+{
+    std::string s(spec);
+    size_t pos = 0;
+    while (pos < s.size()) {
+        size_t end = s.find(',', pos);
+        if (end == std::string::npos)
+            end = s.size();
+        std::string item = s.substr(pos, end - pos);
+        pos = end + 1;
+
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            printf("--sim: expected key=value, got '%s'\n", item.c_str());
+            return false;
+        }
+        std::string key = item.substr(0, eq);
+        const char *value = item.c_str() + eq + 1;
+        float f = atof(value);
+
+        if (key == "nodes")
+            numNodes = atoi(value);
+        else if (key == "routers")
+            numRouters = atoi(value);
+        else if (key == "seed")
+            seed = strtoull(value, NULL, 10);
+        else if (key == "minutes")
+            durationMsec = f * 60 * 1000;
+        else if (key == "area")
+            areaMeters = f;
+        else if (key == "hops")
+            hopLimit = atoi(value);
+        else if (key == "rate")
+            msgsPerHour = f;
+        else if (key == "size")
+            payloadLen = atoi(value);
+        else if (key == "power")
+            txPowerDbm = f;
+        else if (key == "exponent")
+            pathLossExponent = f;
+        else if (key == "shadowing")
+            shadowingDb = f;
+        else if (key == "preset") {
+            bool found = false;
+            for (int p = _meshtastic_Config_LoRaConfig_ModemPreset_MIN; p <= _meshtastic_Config_LoRaConfig_ModemPreset_MAX; p++) {
+                auto preset = (meshtastic_Config_LoRaConfig_ModemPreset)p;
+                if (strcasecmp(value, DisplayFormatters::getModemPresetDisplayName(preset, false)) == 0) {
+                    this->preset = preset;
+                    found = true;
+                }
+            }
+            if (!found) {
+                printf("--sim: unknown preset '%s'\n", value);
+                return false;
+            }
+        } else {
+            printf("--sim: unknown key '%s'\n", key.c_str());
+            return false;
+        }
+    }
+
+    if (numNodes < 2 || numNodes > SIM_MAX_NODES || numRouters > numNodes || hopLimit > 7 ||
+        payloadLen + sizeof(PacketHeader) > MAX_LORA_PAYLOAD_LEN || areaMeters <= 0) {
+        printf("--sim: out of range, need 2 <= nodes <= %d, routers <= nodes, hops <= 7, size <= %u\n", SIM_MAX_NODES,
+               (unsigned)(MAX_LORA_PAYLOAD_LEN - sizeof(PacketHeader)));
+        return false;
+    }
+    return true;
+}
+
+void MeshSimReport::print() const
+{
+    printf("node role      x      y  orig    tx relay cancel drops    rx  dupes colls airtime\n");
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const MeshSimNodeStats &n = nodes[i];
+        printf("%4u %-6s %6.0f %6.0f %5u %5u %5u %6u %5u %5u %6u %5u %6.1fs\n", (unsigned)i, n.router ? "router" : "client", n.x,
+               n.y, n.originated, n.transmitted, n.relayed, n.relayCanceled, n.queueDrops, n.received, n.duplicates, n.collisions,
+               n.airtimeMsec / 1000.0f);
+    }
+    printf("%u messages, delivery ratio %.1f%%, latency avg %u ms, p95 %u ms, max %u ms\n", messages, deliveryRatio * 100,
+           latencyAvgMsec, latencyP95Msec, latencyMaxMsec);
+    printf("Total airtime %.1fs, %.1fs of mesh simulated in %.1fs\n", airtimeMsec / 1000.0f, virtualMsec / 1000.0f,
+           realMsec / 1000.0f);
+}
+
+MeshSimulator::MeshSimulator(const MeshSimConfig &_config) : config(_config), rngState(_config.seed)
+{
+    RadioInterface::getPresetParams(config.preset, false, bw, sf, cr);
+    slotTimeMsec = RadioInterface::computeSlotTimeMsec(bw, sf);
+    airtime.build(bw, sf, cr, SIM_PREAMBLE_LENGTH);
+    packetTimeMsec = airtime.getMsec(config.payloadLen + sizeof(PacketHeader));
+
+    noiseFloorDbm = -174 + 10 * log10f(bw * 1000) + SIM_NOISE_FIGURE_DB;
+    // Demodulator SNR limits from the Semtech datasheets, SF5 to SF12
+    static const float snrLimits[] = {-2.5, -5, -7.5, -10, -12.5, -15, -17.5, -20};
+    minSnr = snrLimits[constrain(sf, 5, 12) - 5];
+}
+
+// splitmix64, the same on every platform unlike random() and the <random> distributions
+uint32_t MeshSimulator::random32()
+{
+    uint64_t z = (rngState += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+uint32_t MeshSimulator::randomBetween(uint32_t lo, uint32_t hi)
+{
+    return hi > lo ? lo + random32() % (hi - lo) : lo;
+}
+
+float MeshSimulator::uniform()
+{
+    return (random32() >> 8) / 16777216.0f; // [0, 1)
+}
+
+float MeshSimulator::gaussian()
+{
+    float u1 = 1.0f - uniform(), u2 = uniform(); // u1 in (0, 1]
+    return sqrtf(-2 * logf(u1)) * cosf(2 * (float)M_PI * u2);
+}
+
+void MeshSimulator::schedule(uint64_t at, EventType type, uint32_t index)
+{
+    events.push({at, nextSeq++, type, index});
+}
+
+void MeshSimulator::placeNodes()
+{
+    uint32_t n = config.numNodes;
+    nodes.assign(n, Node());
+    for (Node &node : nodes) {
+        node.stats.x = uniform() * config.areaMeters;
+        node.stats.y = uniform() * config.areaMeters;
+    }
+
+    // Pick the routers with a partial shuffle
+    std::vector<uint32_t> order(n);
+    for (uint32_t i = 0; i < n; i++)
+        order[i] = i;
+    for (uint32_t i = 0; i < config.numRouters; i++) {
+        std::swap(order[i], order[randomBetween(i, n)]);
+        nodes[order[i]].stats.router = true;
+    }
+
+    // Log-distance path loss from the free space loss at 1m, plus shadowing that is the same in both directions
+    float loss1m = 20 * log10f(SIM_FREQ_MHZ) - 27.55f;
+    rssi.assign((size_t)n * n, -1000);
+    for (uint32_t i = 0; i < n; i++) {
+        for (uint32_t j = i + 1; j < n; j++) {
+            float dx = nodes[i].stats.x - nodes[j].stats.x, dy = nodes[i].stats.y - nodes[j].stats.y;
+            float d = max(sqrtf(dx * dx + dy * dy), 1.0f);
+            float loss = loss1m + 10 * config.pathLossExponent * log10f(d) + config.shadowingDb * gaussian();
+            rssi[i * n + j] = rssi[j * n + i] = config.txPowerDbm - loss;
+        }
+    }
+}
+
+MeshSimReport MeshSimulator::run()
+{
+    uint32_t started = millis();
+    placeNodes();
+
+    // Everyone starts at a random point of their sending interval
+    if (config.msgsPerHour > 0) {
+        for (uint32_t i = 0; i < config.numNodes; i++)
+            schedule(uniform() * 3600 * 1000 / config.msgsPerHour, EV_ORIGINATE, i); // originate() ignores late ones
+    }
+
+    while (!events.empty()) {
+        Event e = events.top();
+        events.pop();
+        now = e.msec;
+
+        switch (e.type) {
+        case EV_ORIGINATE:
+            originate(e.index);
+            break;
+        case EV_TX_TIMER:
+            transmitTimer(e.index);
+            break;
+        case EV_TX_END:
+            transmitEnd(e.index);
+            break;
+        }
+    }
+
+    MeshSimReport report;
+    uint64_t delivered = 0;
+    for (const Message &m : messages)
+        delivered += m.delivered;
+    for (const Node &node : nodes) {
+        report.nodes.push_back(node.stats);
+        report.airtimeMsec += node.stats.airtimeMsec;
+    }
+    report.messages = messages.size();
+    if (!messages.empty())
+        report.deliveryRatio = (float)delivered / ((float)messages.size() * (config.numNodes - 1));
+    if (!latencies.empty()) {
+        uint64_t sum = 0;
+        for (uint32_t l : latencies)
+            sum += l;
+        report.latencyAvgMsec = sum / latencies.size();
+        report.latencyMaxMsec = *std::max_element(latencies.begin(), latencies.end());
+        auto p95 = latencies.begin() + latencies.size() * 95 / 100;
+        std::nth_element(latencies.begin(), p95, latencies.end());
+        report.latencyP95Msec = *p95;
+    }
+    report.virtualMsec = now;
+    report.realMsec = millis() - started;
+    return report;
+}
+
+void MeshSimulator::originate(uint32_t n)
+{
+    if (now >= config.durationMsec)
+        return;
+
+    uint32_t message = messages.size();
+    messages.push_back({now, 0});
+    nodes[n].seen.insert(message); // FloodingRouter::send() ignores our own message coming back
+    nodes[n].stats.originated++;
+    enqueue(n, {message, config.hopLimit, 0});
+
+    float interval = -logf(1.0f - uniform()) * 3600 * 1000 / config.msgsPerHour;
+    if (now + interval < config.durationMsec)
+        schedule(now + (uint64_t)interval + 1, EV_ORIGINATE, n);
+}
+
+void MeshSimulator::enqueue(uint32_t n, const Queued &q)
+{
+    if (nodes[n].txQueue.size() >= MAX_TX_QUEUE) {
+        nodes[n].stats.queueDrops++; // RadioLibInterface::send() can't queue it either
+        return;
+    }
+    nodes[n].txQueue.push_back(q);
+    startTransmitTimer(n, true);
+}
+
+void MeshSimulator::startTransmitTimer(uint32_t n, bool weighted)
+{
+    // Like notifyLater(..., false), a timer that is already running wins
+    Node &node = nodes[n];
+    if (node.timerPending || node.txQueue.empty())
+        return;
+
+    // RadioLibInterface::setTransmitDelay() goes by the packet at the front of the queue
+    float snr = node.txQueue.front().snr;
+    uint32_t delay = weighted && snr != 0 ? getTxDelayMsecWeighted(n, snr) : getTxDelayMsec(n);
+    node.timerPending = true;
+    schedule(now + delay, EV_TX_TIMER, n);
+}
+
+void MeshSimulator::transmitTimer(uint32_t n)
+{
+    Node &node = nodes[n];
+    node.timerPending = false;
+    if (node.txQueue.empty() || node.transmitting)
+        return;
+
+    if (isChannelActive(n)) {
+        startTransmitTimer(n, true); // try again after this packet
+        return;
+    }
+
+    Queued q = node.txQueue.front();
+    node.txQueue.pop_front();
+    node.transmitting = true;
+    node.stats.transmitted++;
+    node.stats.airtimeMsec += packetTimeMsec;
+    if (q.snr != 0)
+        node.stats.relayed++;
+    node.busy.push_back({now, now + packetTimeMsec});
+
+    uint32_t t = transmissions.size();
+    transmissions.push_back({n, q.message, q.hopLimit, now, now + packetTimeMsec});
+    onAir.push_back(t);
+    schedule(now + packetTimeMsec, EV_TX_END, t);
+}
+
+void MeshSimulator::transmitEnd(uint32_t t)
+{
+    const Transmission tx = transmissions[t];
+    nodes[tx.sender].transmitting = false;
+
+    // Forget transmissions that ended before this one started, they can't overlap with anything from now on
+    onAir.erase(std::remove_if(onAir.begin(), onAir.end(), [&](uint32_t u) { return transmissions[u].end <= tx.start; }),
+                onAir.end());
+
+    for (uint32_t r = 0; r < config.numNodes; r++) {
+        if (r == tx.sender)
+            continue;
+        float signal = linkRssi(tx.sender, r);
+        float snr = signal - noiseFloorDbm;
+        if (snr < minSnr)
+            continue; // too far away to even notice
+
+        nodes[r].busy.push_back({tx.start, tx.end});
+
+        bool lost = false;
+        for (uint32_t u : onAir) {
+            const Transmission &other = transmissions[u];
+            if (u == t || other.end <= tx.start || other.start >= tx.end)
+                continue;
+            if (other.sender == r || signal - linkRssi(other.sender, r) < SIM_CAPTURE_DB) {
+                lost = true;
+                break;
+            }
+        }
+
+        if (lost)
+            nodes[r].stats.collisions++;
+        else
+            deliver(r, tx, min(snr, SIM_MAX_REPORTED_SNR));
+    }
+
+    // RadioLibInterface::onNotify(ISR_TX)
+    startTransmitTimer(tx.sender, false);
+}
+
+void MeshSimulator::deliver(uint32_t n, const Transmission &tx, float snr)
+{
+    Node &node = nodes[n];
+
+    if (!node.seen.insert(tx.message).second) {
+        // FloodingRouter::shouldFilterReceived()
+        node.stats.duplicates++;
+        if (!node.stats.router) {
+            for (auto i = node.txQueue.begin(); i != node.txQueue.end(); i++) {
+                if (i->message == tx.message) {
+                    node.txQueue.erase(i);
+                    node.stats.relayCanceled++;
+                    break;
+                }
+            }
+        }
+        return;
+    }
+
+    node.stats.received++;
+    messages[tx.message].delivered++;
+    latencies.push_back(now - messages[tx.message].sentMsec);
+
+    // FloodingRouter::perhapsRebroadcast()
+    if (tx.hopLimit > 0)
+        enqueue(n, {tx.message, (uint8_t)(tx.hopLimit - 1), snr});
+}
+
+bool MeshSimulator::isChannelActive(uint32_t n) const
+{
+    for (uint32_t u : onAir) {
+        const Transmission &other = transmissions[u];
+        if (other.start <= now && other.end > now && other.sender != n && linkRssi(other.sender, n) - noiseFloorDbm >= minSnr)
+            return true;
+    }
+    return false;
+}
+
+float MeshSimulator::channelUtilizationPercent(uint32_t n, uint32_t windowMsec)
+{
+    std::deque<std::pair<uint64_t, uint64_t>> &busy = nodes[n].busy;
+    while (!busy.empty() && busy.front().second + AIRTIME_WINDOW_LONG_MSEC < now)
+        busy.pop_front();
+
+    uint64_t from = now > windowMsec ? now - windowMsec : 0, sum = 0;
+    for (auto &b : busy) {
+        uint64_t start = max(b.first, from), end = min(b.second, now);
+        if (end > start)
+            sum += end - start;
+    }
+    return sum * 100.0f / windowMsec;
+}
+
+// RadioInterface::getTxDelayMsec() with getCWsize()
+uint32_t MeshSimulator::getTxDelayMsec(uint32_t n)
+{
+    float channelUtil =
+        max(channelUtilizationPercent(n, AIRTIME_WINDOW_MEDIUM_MSEC), channelUtilizationPercent(n, AIRTIME_WINDOW_LONG_MSEC));
+    return RadioInterface::computeTxDelayMsec(RadioInterface::computeCWsize(channelUtil), slotTimeMsec,
+                                              [this](long lo, long hi) { return (long)randomBetween(lo, hi); });
+}
+
+uint32_t MeshSimulator::getTxDelayMsecWeighted(uint32_t n, float snr)
+{
+    return RadioInterface::computeTxDelayMsecWeighted(RadioInterface::computeCWsizeWeighted(snr), nodes[n].stats.router,
+                                                      slotTimeMsec,
+                                                      [this](long lo, long hi) { return (long)randomBetween(lo, hi); });
+}
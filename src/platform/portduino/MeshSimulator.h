@@ -0,0 +1,159 @@
+#pragma once
+
+#include "AirtimeTable.h"
+#include "meshtastic/config.pb.h"
+#include <deque>
+#include <queue>
+#include <stdint.h>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * What to simulate.  parse() takes the --sim argument of the native build, a comma separated list of key=value pairs:
+ *
+ *   nodes=200,routers=5,seed=2,minutes=60,area=10000,preset=LongFast,hops=3,rate=4,size=40,power=20,exponent=2.7,shadowing=4
+ */
+struct MeshSimConfig {
+    uint32_t numNodes = 50;
+    uint32_t numRouters = 0; // this many of the nodes (picked at random) are ROUTERs
+    uint64_t seed = 1;
+    uint32_t durationMsec = 30 * 60 * 1000; // nodes stop sending new messages after this, then the mesh drains
+    float areaMeters = 8000;                // nodes are placed at random in a square this wide
+    meshtastic_Config_LoRaConfig_ModemPreset preset = meshtastic_Config_LoRaConfig_ModemPreset_LONG_FAST;
+    uint8_t hopLimit = 3;
+    float msgsPerHour = 4;    // broadcasts each node sends
+    uint16_t payloadLen = 40; // encrypted payload bytes, the PacketHeader comes on top
+    float txPowerDbm = 20;
+    float pathLossExponent = 2.7;
+    float shadowingDb = 4; // standard deviation of the log-normal shadowing, fixed per link
+
+    /// @return false (and prints why) if spec has an unknown key or a bad value
+    bool parse(const char *spec);
+};
+
+struct MeshSimNodeStats {
+    bool router;
+    float x, y;
+    uint32_t originated;    // messages this node sent
+    uint32_t transmitted;   // packets put on the air (ours and relays)
+    uint32_t relayed;       // of which rebroadcasts
+    uint32_t relayCanceled; // rebroadcasts dropped because someone else was faster
+    uint32_t queueDrops;    // packets dropped because our TX queue was full
+    uint32_t received;      // distinct messages decoded
+    uint32_t duplicates;    // copies of messages we already had
+    uint32_t collisions;    // packets we would have decoded but lost to interference or our own transmitting
+    uint32_t airtimeMsec;   // time we spent transmitting
+};
+
+struct MeshSimReport {
+    std::vector<MeshSimNodeStats> nodes;
+    uint32_t messages = 0;
+    float deliveryRatio = 0; // fraction of (message, other node) pairs that got through
+    uint32_t latencyAvgMsec = 0, latencyP95Msec = 0, latencyMaxMsec = 0;
+    uint64_t airtimeMsec = 0;
+    uint64_t virtualMsec = 0; // how long the simulated mesh ran
+    uint32_t realMsec = 0;    // and how long that took us
+
+    void print() const;
+};
+
+/**
+ * Discrete-event simulation of a whole mesh of flooding nodes on one shared LoRa channel.
+ *
+ * The firmware is full of singletons (router, nodeDB, config...) so we can't run many real stacks in one process.  Instead each
+ * node follows what FloodingRouter and RadioLibInterface do with a broadcast: the SNR weighted rebroadcast delay, cancelling our
+ * rebroadcast when we hear someone else's (unless we are a router), channel activity detection before sending, and the
+ * contention window from channel utilization.  Airtime comes from the same AirtimeTable getPacketTime() uses.
+ *
+ * The radio model is log-distance path loss with fixed per-link shadowing, a packet is decoded if its SNR clears the demodulator
+ * limit for the spreading factor, the receiver wasn't transmitting, and every overlapping packet was at least 6dB weaker.
+ *
+ * Time is virtual, so an hour of a busy mesh takes seconds.  All randomness comes from the seed (not from the platform random()),
+ * so a run is repeatable and can be checked in CI.
+ */
+class MeshSimulator
+{
+  public:
+    explicit MeshSimulator(const MeshSimConfig &config);
+
+    MeshSimReport run();
+
+  private:
+    enum EventType { EV_ORIGINATE, EV_TX_TIMER, EV_TX_END };
+
+    struct Event {
+        uint64_t msec;
+        uint64_t seq; // keeps events at the same msec in the order they were scheduled
+        EventType type;
+        uint32_t index; // node, or transmission for EV_TX_END
+
+        bool operator>(const Event &o) const { return msec != o.msec ? msec > o.msec : seq > o.seq; }
+    };
+
+    struct Queued {
+        uint32_t message;
+        uint8_t hopLimit;
+        float snr; // what we heard it with, 0 for our own messages (just like rx_snr)
+    };
+
+    struct Node {
+        MeshSimNodeStats stats = {};
+        std::deque<Queued> txQueue;
+        bool timerPending = false;
+        bool transmitting = false;
+        std::unordered_set<uint32_t> seen;
+        std::deque<std::pair<uint64_t, uint64_t>> busy; // when we heard or sent something, for the contention window
+    };
+
+    struct Transmission {
+        uint32_t sender;
+        uint32_t message;
+        uint8_t hopLimit;
+        uint64_t start, end;
+    };
+
+    struct Message {
+        uint64_t sentMsec;
+        uint32_t delivered;
+    };
+
+    MeshSimConfig config;
+    uint64_t rngState;
+    float bw = 0;
+    uint8_t sf = 0, cr = 0;
+    uint32_t slotTimeMsec = 0;
+    uint32_t packetTimeMsec = 0;
+    float noiseFloorDbm = 0, minSnr = 0;
+    AirtimeTable airtime;
+
+    uint64_t now = 0;
+    uint64_t nextSeq = 0;
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+    std::vector<Node> nodes;
+    std::vector<float> rssi; // rssi[from * numNodes + to]
+    std::vector<Transmission> transmissions;
+    std::vector<uint32_t> onAir; // transmissions that could still overlap with one ending now
+    std::vector<Message> messages;
+    std::vector<uint32_t> latencies;
+
+    uint32_t random32();
+    uint32_t randomBetween(uint32_t lo, uint32_t hi); // [lo, hi) like Arduino random()
+    float uniform();
+    float gaussian();
+
+    void schedule(uint64_t at, EventType type, uint32_t index);
+    void placeNodes();
+    float linkRssi(uint32_t from, uint32_t to) const { return rssi[from * config.numNodes + to]; }
+
+    void originate(uint32_t n);
+    void enqueue(uint32_t n, const Queued &q);
+    void startTransmitTimer(uint32_t n, bool weighted);
+    void transmitTimer(uint32_t n);
+    void transmitEnd(uint32_t t);
+    void deliver(uint32_t n, const Transmission &tx, float snr);
+
+    bool isChannelActive(uint32_t n) const;
+    float channelUtilizationPercent(uint32_t n, uint32_t windowMsec);
+    uint32_t getTxDelayMsec(uint32_t n);
+    uint32_t getTxDelayMsecWeighted(uint32_t n, float snr);
+};
@@ -0,0 +1,211 @@
+#include "PacketCapture.h"
+#include "SimRadio.h"
+#include "configuration.h"
+#include <math.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define PCAP_MAGIC 0xa1b2c3d4 // microsecond timestamps, written in our own byte order
+
+struct PcapHeader {
+    uint32_t magic;
+    uint16_t versionMajor, versionMinor;
+    int32_t thisZone;
+    uint32_t sigFigs;
+    uint32_t snapLen;
+    uint32_t linkType;
+};
+
+struct PcapRecord {
+    uint32_t sec, usec;
+    uint32_t inclLen, origLen;
+};
+
+PacketCapture *packetCapture;
+
+bool CapturedPacket::toMeshPacket(meshtastic_MeshPacket &mp) const
+{
+    if (len < sizeof(PacketHeader))
+        return false;
+
+    PacketHeader h;
+    memcpy(&h, bytes, sizeof(h));
+    if (h.from == 0)
+        return false;
+
+    mp = meshtastic_MeshPacket_init_zero;
+    mp.from = h.from;
+    mp.to = h.to;
+    mp.id = h.id;
+    mp.channel = h.channel;
+    mp.hop_limit = h.flags & PACKET_FLAGS_HOP_LIMIT_MASK;
+    mp.hop_start = (h.flags & PACKET_FLAGS_HOP_START_MASK) >> PACKET_FLAGS_HOP_START_SHIFT;
+    mp.want_ack = !!(h.flags & PACKET_FLAGS_WANT_ACK_MASK);
+    mp.via_mqtt = !!(h.flags & PACKET_FLAGS_VIA_MQTT_MASK);
+    mp.rx_snr = meta.snrQuarterDb / 4.0f;
+    mp.rx_rssi = meta.rssi;
+
+    mp.which_payload_variant = meshtastic_MeshPacket_encrypted_tag;
+    mp.encrypted.size = len - sizeof(PacketHeader);
+    memcpy(mp.encrypted.bytes, bytes + sizeof(PacketHeader), mp.encrypted.size);
+    return true;
+}
+
+PacketCapture::PacketCapture() : concurrency::OSThread("PacketCapture", PACKET_CAPTURE_FLUSH_MSEC)
+{
+    // Room for one more record past the flush threshold, so write() never reallocates
+    buffer.reserve(PACKET_CAPTURE_BUFFER_BYTES + sizeof(PcapRecord) + sizeof(PacketCaptureMeta) + MAX_LORA_PAYLOAD_LEN + 1);
+}
+
+PacketCapture::~PacketCapture()
+{
+    flush();
+    if (file)
+        fclose(file);
+}
+
+bool PacketCapture::open(const char *path)
+{
+    file = fopen(path, "a+b");
+    if (!file) {
+        LOG_ERROR("Can't open capture file %s", path);
+        return false;
+    }
+
+    PcapHeader h;
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) == 0) {
+        h = {PCAP_MAGIC, 2, 4, 0, 0, sizeof(PacketCaptureMeta) + MAX_LORA_PAYLOAD_LEN + 1, PACKET_CAPTURE_LINKTYPE};
+        fwrite(&h, sizeof(h), 1, file);
+        fflush(file);
+    } else {
+        rewind(file);
+        if (fread(&h, sizeof(h), 1, file) != 1 || h.magic != PCAP_MAGIC || h.linkType != PACKET_CAPTURE_LINKTYPE) {
+            LOG_ERROR("%s exists and is not a packet capture, not appending to it", path);
+            fclose(file);
+            file = NULL;
+            return false;
+        }
+        fseek(file, 0, SEEK_END); // appending ignores the position anyway, but reads and writes mustn't switch without a seek
+    }
+    LOG_INFO("Capture received packets to %s", path);
+    return true;
+}
+
+void PacketCapture::write(const uint8_t *bytes, size_t len, float snr, float rssi, float bw, uint8_t sf, uint8_t cr)
+{
+    if (!file || len > MAX_LORA_PAYLOAD_LEN + 1)
+        return;
+
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+
+    PacketCaptureMeta meta = {PACKET_CAPTURE_META_VERSION, sf, cr, 0, (uint16_t)lroundf(bw * 10), (int16_t)lroundf(rssi),
+                              (int16_t)lroundf(snr * 4)};
+    PcapRecord r = {(uint32_t)tv.tv_sec, (uint32_t)tv.tv_usec, (uint32_t)(sizeof(meta) + len), (uint32_t)(sizeof(meta) + len)};
+
+    buffer.insert(buffer.end(), (const uint8_t *)&r, (const uint8_t *)&r + sizeof(r));
+    buffer.insert(buffer.end(), (const uint8_t *)&meta, (const uint8_t *)&meta + sizeof(meta));
+    buffer.insert(buffer.end(), bytes, bytes + len);
+
+    if (buffer.size() >= PACKET_CAPTURE_BUFFER_BYTES)
+        flush();
+}
+
+void PacketCapture::flush()
+{
+    if (!file || buffer.empty())
+        return;
+
+    if (fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size() || fflush(file) != 0)
+        LOG_ERROR("Packet capture write failed, %u bytes lost", (uint32_t)buffer.size());
+    buffer.clear();
+}
+
+int32_t PacketCapture::runOnce()
+{
+    flush();
+    return PACKET_CAPTURE_FLUSH_MSEC;
+}
+
+PacketCaptureReader::~PacketCaptureReader()
+{
+    if (file)
+        fclose(file);
+}
+
+bool PacketCaptureReader::open(const char *path)
+{
+    file = fopen(path, "rb");
+    if (!file)
+        return false;
+
+    PcapHeader h;
+    if (fread(&h, sizeof(h), 1, file) != 1 || h.magic != PCAP_MAGIC || h.linkType != PACKET_CAPTURE_LINKTYPE) {
+        fclose(file);
+        file = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool PacketCaptureReader::next(CapturedPacket &p)
+{
+    PcapRecord r;
+    if (!file || fread(&r, sizeof(r), 1, file) != 1)
+        return false;
+
+    if (r.inclLen < sizeof(p.meta) || r.inclLen - sizeof(p.meta) > sizeof(p.bytes)) {
+        LOG_WARN("Damaged packet capture record (%u bytes), stopping there", r.inclLen);
+        return false;
+    }
+    p.usec = (uint64_t)r.sec * 1000000 + r.usec;
+    p.len = r.inclLen - sizeof(p.meta);
+    return fread(&p.meta, sizeof(p.meta), 1, file) == 1 && fread(p.bytes, 1, p.len, file) == p.len;
+}
+
+PacketReplay::PacketReplay(const char *path, float speed) : concurrency::OSThread("PacketReplay"), speed(speed)
+{
+    if (!reader.open(path)) {
+        LOG_ERROR("Can't replay %s, not a packet capture", path);
+        disable();
+    } else if (!SimRadio::instance) {
+        LOG_ERROR("Replay needs the simulated radio");
+        disable();
+    } else {
+        LOG_INFO("Replay %s at %gx speed", path, speed);
+    }
+}
+
+int32_t PacketReplay::runOnce()
+{
+    if (!havePacket) {
+        if (!reader.next(next)) {
+            LOG_INFO("Replay done, %u packets replayed, %u skipped", replayed, skipped);
+            return disable();
+        }
+        havePacket = true;
+        if (replayed + skipped == 0) {
+            firstUsec = next.usec;
+            startMsec = millis();
+        }
+    }
+
+    if (speed > 0) {
+        // The clock might have been set back while capturing, don't wait for that
+        uint32_t dueMsec = next.usec > firstUsec ? (next.usec - firstUsec) / 1000 / speed : 0;
+        uint32_t elapsedMsec = millis() - startMsec;
+        if (elapsedMsec < dueMsec)
+            return dueMsec - elapsedMsec;
+    }
+
+    havePacket = false;
+    meshtastic_MeshPacket mp;
+    if (next.toMeshPacket(mp)) {
+        SimRadio::instance->startReceive(&mp);
+        replayed++;
+    } else {
+        skipped++;
+    }
+    return 0;
+}
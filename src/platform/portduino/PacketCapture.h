@@ -0,0 +1,106 @@
+#pragma once
+
+#include "RadioInterface.h"
+#include "concurrency/OSThread.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+// pcap link type of our records, one of the DLT_USER values set aside for private use
+#define PACKET_CAPTURE_LINKTYPE 147
+// Records are collected in RAM and written once this much is waiting, or PACKET_CAPTURE_FLUSH_MSEC passed
+#define PACKET_CAPTURE_BUFFER_BYTES (16 * 1024)
+#define PACKET_CAPTURE_FLUSH_MSEC 2000
+
+/// What we know about each packet besides its bytes, stored (little endian) in front of them in every pcap record
+struct __attribute__((packed)) PacketCaptureMeta {
+    uint8_t version; // PACKET_CAPTURE_META_VERSION
+    uint8_t sf;
+    uint8_t cr;
+    uint8_t reserved;
+    uint16_t bw100Hz; // 62.5kHz is 625
+    int16_t rssi;
+    int16_t snrQuarterDb;
+};
+#define PACKET_CAPTURE_META_VERSION 1
+
+struct CapturedPacket {
+    uint64_t usec; // wall clock time we received it
+    PacketCaptureMeta meta;
+    uint16_t len;
+    uint8_t bytes[MAX_LORA_PAYLOAD_LEN + 1]; // PacketHeader and payload, exactly as they came out of the radio
+
+    /// Fill in an encrypted packet the way RadioLibInterface does, returns false if it is too short or has no sender
+    bool toMeshPacket(meshtastic_MeshPacket &mp) const;
+};
+
+/**
+ * Records every raw packet the radio hands us to a pcap file (Logging: CaptureFile: in config.yaml).
+ *
+ * Unlike the JSON trace this keeps the PacketHeader bytes, SNR, RSSI and modem settings exactly as received, costs a memcpy on the
+ * receive path (the file is written from our own thread, PACKET_CAPTURE_BUFFER_BYTES at a time) and can be played back with
+ * --replay.  Wireshark opens the files too, the records show up as user link type 0.
+ */
+class PacketCapture : private concurrency::OSThread
+{
+  public:
+    PacketCapture();
+    ~PacketCapture();
+
+    /// Append to path, writing the pcap header if the file is new. Returns false if it isn't a capture of ours.
+    bool open(const char *path);
+
+    /// Called by RadioLibInterface for each packet read from the radio
+    void write(const uint8_t *bytes, size_t len, float snr, float rssi, float bw, uint8_t sf, uint8_t cr);
+
+    void flush();
+
+  protected:
+    int32_t runOnce() override;
+
+  private:
+    FILE *file = NULL;
+    std::vector<uint8_t> buffer;
+    uint32_t lastFlushMsec = 0;
+};
+
+extern PacketCapture *packetCapture;
+
+/// Reads back what PacketCapture wrote
+class PacketCaptureReader
+{
+  public:
+    ~PacketCaptureReader();
+
+    bool open(const char *path);
+
+    /// Returns false at the end of the capture (or at a damaged record)
+    bool next(CapturedPacket &p);
+
+  private:
+    FILE *file = NULL;
+};
+
+/**
+ * Plays a capture back through SimRadio, as if the packets arrived over the air again (--replay FILE on the native build).
+ *
+ * The gaps between packets are kept, divided by speed.  With speed 0 packets are delivered as fast as we get to run, whatever
+ * the router can't keep up with is dropped just like on a real radio.
+ */
+class PacketReplay : private concurrency::OSThread
+{
+  public:
+    PacketReplay(const char *path, float speed);
+
+  protected:
+    int32_t runOnce() override;
+
+  private:
+    PacketCaptureReader reader;
+    float speed;
+    CapturedPacket next;
+    bool havePacket = false;
+    uint64_t firstUsec = 0;
+    uint32_t startMsec = 0;
+    uint32_t replayed = 0, skipped = 0;
+};
@@ -5,6 +5,7 @@
 #include "sleep.h"
 #include "target_specific.h"
 
+#include "MeshSimulator.h"
 #include "PortduinoGlue.h"
 #include "api/ServerAPI.h"
 #include "linux/gpio/LinuxGPIOPin.h"
@@ -41,6 +42,12 @@ void cpuDeepSleep(uint32_t msecs)
 void updateBatteryLevel(uint8_t level) NOT_IMPLEMENTED("updateBatteryLevel");
 
 int TCPPort = SERVER_API_DEFAULT_PORT;
+static const char *simSpec = nullptr;
+const char *replayPath = nullptr;
+float replaySpeed = 1;
+
+// argp keys for options that only have a long name
+#define OPT_REPLAY_SPEED 0x100
 
 static error_t parse_opt(int key, char *arg, struct argp_state *state)
 {
@@ -57,6 +64,15 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
     case 'h':
         optionMac = arg;
         break;
+    case 's':
+        simSpec = arg;
+        break;
+    case 'r':
+        replayPath = arg;
+        break;
+    case OPT_REPLAY_SPEED:
+        replaySpeed = atof(arg);
+        break;
 
     case ARGP_KEY_ARG:
         return 0;
@@ -71,6 +87,13 @@ void portduinoCustomInit()
     static struct argp_option options[] = {{"port", 'p', "PORT", 0, "The TCP port to use."},
                                            {"config", 'c', "CONFIG_PATH", 0, "Full path of the .yaml config file to use."},
                                            {"hwid", 'h', "HWID", 0, "The mac address to assign to this virtual machine"},
+                                           {"sim", 's', "SPEC", 0,
+                                            "Simulate a mesh (e.g. nodes=200,routers=5,minutes=60,seed=1), print a report and exit."},
+                                           {"replay", 'r', "CAPTURE", 0,
+                                            "Feed a packet capture (see Logging: CaptureFile) to the simulated radio instead of using a "
+                                            "LoRa module."},
+                                           {"replay-speed", OPT_REPLAY_SPEED, "FACTOR", 0,
+                                            "How much faster than captured to replay, 0 for as fast as possible (default 1)."},
                                            {0}};
     static void *childArguments;
     static char doc[] = "Meshtastic native build.";
@@ -130,6 +153,14 @@ void getMacAddr(uint8_t *dmac)
  */
 void portduinoSetup()
 {
+    if (simSpec) {
+        MeshSimConfig simConfig;
+        if (!simConfig.parse(simSpec))
+            exit(EXIT_FAILURE);
+        MeshSimulator(simConfig).run().print();
+        exit(EXIT_SUCCESS);
+    }
+
     printf("Set up Meshtastic on Portduino...\n");
     int max_GPIO = 0;
     const configNames GPIO_lines[] = {cs,
@@ -283,6 +314,18 @@ void portduinoSetup()
             initGPIOPin(settingsMap[touchscreenIRQ], gpioChipName);
     }
 
+    if (replayPath) {
+        // The replayed packets stand in for the radio, so use SimRadio whatever config.yaml says
+        std::cout << "Replaying " << replayPath << ", ignoring the Lora module in the config" << std::endl;
+        settingsMap[use_sx1262] = false;
+        settingsMap[use_rf95] = false;
+        settingsMap[use_sx1280] = false;
+        settingsMap[use_lr1110] = false;
+        settingsMap[use_lr1120] = false;
+        settingsMap[use_lr1121] = false;
+        settingsMap[use_sx1268] = false;
+    }
+
     if (settingsStrings[spidev] != "") {
         SPI.begin(settingsStrings[spidev].c_str());
     }
@@ -336,6 +379,8 @@ bool loadConfig(const char *configPath)
                 settingsMap[logoutputlevel] = level_error;
             }
             settingsStrings[traceFilename] = yamlConfig["Logging"]["TraceFile"].as<std::string>("");
+            settingsStrings[captureFilename] = yamlConfig["Logging"]["CaptureFile"].as<std::string>("");
+            settingsStrings[powerTraceFilename] = yamlConfig["Logging"]["PowerTraceFile"].as<std::string>("");
             if (yamlConfig["Logging"]["AsciiLogs"]) {
                 // Default is !isatty(1) but can be set explicitly in config.yaml
                 settingsMap[ascii_logs] = yamlConfig["Logging"]["AsciiLogs"].as<bool>();
@@ -53,6 +53,8 @@ enum configNames {
     keyboardDevice,
     logoutputlevel,
     traceFilename,
+    captureFilename,
+    powerTraceFilename,
     webserver,
     webserverport,
     webserverrootpath,
@@ -69,6 +71,8 @@ enum { level_error, level_warn, level_info, level_debug, level_trace };
 extern std::map<configNames, int> settingsMap;
 extern std::map<configNames, std::string> settingsStrings;
 extern std::ofstream traceFile;
+extern const char *replayPath;
+extern float replaySpeed;
 int initGPIOPin(int pinNum, std::string gpioChipname);
 bool loadConfig(const char *configPath);
 static bool ends_with(std::string_view str, std::string_view suffix);
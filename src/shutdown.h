@@ -1,6 +1,7 @@
 #include "buzz.h"
 #include "configuration.h"
 #include "graphics/Screen.h"
+#include "NodeDB.h"
 #include "main.h"
 #include "power.h"
 #if defined(ARCH_PORTDUINO)
@@ -13,6 +14,8 @@ void powerCommandsCheck()
 {
     if (rebootAtMsec && millis() > rebootAtMsec) {
         LOG_INFO("Rebooting");
+        if (nodeDB)
+            nodeDB->flushPendingSaves();
 #if defined(ARCH_ESP32)
         ESP.restart();
 #elif defined(ARCH_NRF52)
@@ -44,6 +47,8 @@ void powerCommandsCheck()
 
     if (shutdownAtMsec && millis() > shutdownAtMsec) {
         LOG_INFO("Shut down from admin command");
+        if (nodeDB)
+            nodeDB->flushPendingSaves();
 #if defined(ARCH_NRF52) || defined(ARCH_ESP32) || defined(ARCH_RP2040)
         playShutdownMelody();
         power->shutdown();
@@ -221,6 +221,8 @@ void doDeepSleep(uint32_t msecToWake, bool skipPreflight = false, bool skipSaveN
 
     if (!skipSaveNodeDb) {
         nodeDB->saveToDisk();
+    } else {
+        nodeDB->flushPendingSaves(); // at least keep what was asked to be saved
     }
 
 #ifdef PIN_POWER_EN
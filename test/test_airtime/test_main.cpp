@@ -0,0 +1,117 @@
+#include "AirtimeTable.h"
+
+#include <Arduino.h>
+#include <math.h>
+#include <unity.h>
+
+struct ModemSettings {
+    const char *name;
+    float bw;
+    uint8_t sf;
+    uint8_t cr;
+};
+
+// Every preset from RadioInterface::applyModemConfig(), with normal and wide (2.4GHz) bandwidths
+static const ModemSettings presets[] = {
+    {"ShortTurbo", 500, 7, 5},
+    {"ShortTurbo wide", 1625, 7, 5},
+    {"ShortFast", 250, 7, 5},
+    {"ShortFast wide", 812.5, 7, 5},
+    {"ShortSlow", 250, 8, 5},
+    {"ShortSlow wide", 812.5, 8, 5},
+    {"MediumFast", 250, 9, 5},
+    {"MediumFast wide", 812.5, 9, 5},
+    {"MediumSlow", 250, 10, 5},
+    {"MediumSlow wide", 812.5, 10, 5},
+    {"LongFast", 250, 11, 5},
+    {"LongFast wide", 812.5, 11, 5},
+    {"LongModerate", 125, 11, 8},
+    {"LongModerate wide", 406.25, 11, 8},
+    {"LongSlow", 125, 12, 8},
+    {"LongSlow wide", 406.25, 12, 8},
+    {"VeryLongSlow", 62.5, 12, 8},
+    {"VeryLongSlow wide", 203.125, 12, 8},
+};
+
+// The float formula RadioInterface::getPacketTime() used before the table
+static uint32_t floatPacketTime(float bw, uint8_t sf, uint8_t cr, uint16_t preambleLength, uint32_t pl)
+{
+    float bandwidthHz = bw * 1000.0f;
+    bool headDisable = false;
+    float tSym = (1 << sf) / bandwidthHz;
+
+    bool lowDataOptEn = tSym > 16e-3 ? true : false;
+
+    float tPreamble = (preambleLength + 4.25f) * tSym;
+    float numPayloadSym =
+        8 + max(ceilf(((8.0f * pl - 4 * sf + 28 + 16 - 20 * headDisable) / (4 * (sf - 2 * lowDataOptEn))) * cr), 0.0f);
+    float tPayload = numPayloadSym * tSym;
+    float tPacket = tPreamble + tPayload;
+
+    return tPacket * 1000;
+}
+
+static AirtimeTable table;
+
+void test_PresetsMatchFloatFormula()
+{
+    const uint16_t preambles[] = {16, 12}; // our default, and what SX128x/LR11x0 use at 2.4GHz
+    char msg[96];
+
+    for (const ModemSettings &m : presets) {
+        for (uint16_t preambleLength : preambles) {
+            table.build(m.bw, m.sf, m.cr, preambleLength);
+            TEST_ASSERT_TRUE(table.matches(m.bw, m.sf, m.cr, preambleLength));
+
+            for (uint32_t pl = 0; pl <= AIRTIME_TABLE_MAX_LEN; pl++) {
+                int32_t expected = floatPacketTime(m.bw, m.sf, m.cr, preambleLength, pl);
+                int32_t actual = table.getMsec(pl);
+                // float rounding can make the old formula one msec longer than the exact value
+                snprintf(msg, sizeof(msg), "%s, preamble %u, %u bytes", m.name, preambleLength, pl);
+                TEST_ASSERT_INT32_WITHIN_MESSAGE(1, expected, actual, msg);
+            }
+        }
+    }
+}
+
+void test_KnownAirtimes()
+{
+    // LongFast with a 16 symbol preamble: 8.192ms symbols, 16 + 4.25 preamble + 8 header symbols
+    table.build(250, 11, 5, 16);
+    TEST_ASSERT_EQUAL_UINT32(231, table.getMsec(0));
+    TEST_ASSERT_EQUAL_UINT32(floatPacketTime(250, 11, 5, 16, 255), table.getMsec(255));
+
+    // Lengths past the table are still computed
+    TEST_ASSERT_TRUE(table.getMsec(AIRTIME_TABLE_MAX_LEN + 1) >= table.getMsec(AIRTIME_TABLE_MAX_LEN));
+
+    // Airtime never decreases with length
+    for (uint32_t pl = 1; pl <= AIRTIME_TABLE_MAX_LEN; pl++)
+        TEST_ASSERT_TRUE(table.getMsec(pl) >= table.getMsec(pl - 1));
+}
+
+void test_RebuildOnChange()
+{
+    table.build(250, 11, 5, 16);
+    uint32_t longFast = table.getMsec(100);
+    table.build(250, 7, 5, 16);
+    TEST_ASSERT_FALSE(table.matches(250, 11, 5, 16));
+    TEST_ASSERT_TRUE(table.getMsec(100) < longFast);
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_PresetsMatchFloatFormula);
+    RUN_TEST(test_KnownAirtimes);
+    RUN_TEST(test_RebuildOnChange);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
@@ -0,0 +1,113 @@
+#include "configuration.h"
+
+#include <unity.h>
+
+#ifdef ARCH_PORTDUINO
+#include "platform/portduino/MeshSimulator.h"
+
+static MeshSimConfig smallMesh()
+{
+    MeshSimConfig config;
+    config.numNodes = 40;
+    config.numRouters = 3;
+    config.seed = 42;
+    config.durationMsec = 20 * 60 * 1000;
+    config.areaMeters = 20000;
+    return config;
+}
+
+void test_SameSeedSameReport()
+{
+    MeshSimReport a = MeshSimulator(smallMesh()).run();
+    MeshSimReport b = MeshSimulator(smallMesh()).run();
+
+    TEST_ASSERT_TRUE(a.messages > 0);
+    TEST_ASSERT_EQUAL_UINT32(a.messages, b.messages);
+    TEST_ASSERT_EQUAL_FLOAT(a.deliveryRatio, b.deliveryRatio);
+    TEST_ASSERT_EQUAL_UINT32(a.latencyAvgMsec, b.latencyAvgMsec);
+    TEST_ASSERT_EQUAL_UINT32(a.latencyMaxMsec, b.latencyMaxMsec);
+    TEST_ASSERT_EQUAL_UINT64(a.virtualMsec, b.virtualMsec);
+    TEST_ASSERT_EQUAL(a.nodes.size(), b.nodes.size());
+    for (size_t i = 0; i < a.nodes.size(); i++) {
+        TEST_ASSERT_EQUAL_UINT32(a.nodes[i].transmitted, b.nodes[i].transmitted);
+        TEST_ASSERT_EQUAL_UINT32(a.nodes[i].received, b.nodes[i].received);
+        TEST_ASSERT_EQUAL_UINT32(a.nodes[i].collisions, b.nodes[i].collisions);
+    }
+
+    a.print();
+}
+
+void test_OtherSeedOtherMesh()
+{
+    MeshSimConfig config = smallMesh();
+    MeshSimReport a = MeshSimulator(config).run();
+    config.seed++;
+    MeshSimReport b = MeshSimulator(config).run();
+
+    TEST_ASSERT_TRUE(a.nodes[0].x != b.nodes[0].x || a.nodes[0].y != b.nodes[0].y);
+}
+
+void test_TwoNodesAlwaysDeliver()
+{
+    MeshSimConfig config;
+    config.numNodes = 2;
+    config.areaMeters = 100;
+    config.msgsPerHour = 20;
+    MeshSimReport report = MeshSimulator(config).run();
+
+    // Nobody else to collide with, and the relay of each message only goes back to its sender
+    TEST_ASSERT_TRUE(report.messages > 0);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, report.deliveryRatio);
+    TEST_ASSERT_EQUAL_UINT32(0, report.nodes[0].collisions + report.nodes[1].collisions);
+    TEST_ASSERT_EQUAL_UINT32(report.messages, report.nodes[0].relayed + report.nodes[1].relayed);
+}
+
+void test_OutOfRangeNeverDelivers()
+{
+    MeshSimConfig config;
+    config.numNodes = 2;
+    config.areaMeters = 1000 * 1000; // two nodes somewhere in a 1000km square
+    config.shadowingDb = 0;
+    config.seed = 7;
+    MeshSimReport report = MeshSimulator(config).run();
+
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, report.deliveryRatio);
+}
+
+void test_ParseSpec()
+{
+    MeshSimConfig config;
+    TEST_ASSERT_TRUE(config.parse("nodes=200,routers=5,seed=9,minutes=60,preset=MediumFast,hops=5"));
+    TEST_ASSERT_EQUAL_UINT32(200, config.numNodes);
+    TEST_ASSERT_EQUAL_UINT32(5, config.numRouters);
+    TEST_ASSERT_EQUAL_UINT32(60 * 60 * 1000, config.durationMsec);
+    TEST_ASSERT_EQUAL(meshtastic_Config_LoRaConfig_ModemPreset_MEDIUM_FAST, config.preset);
+    TEST_ASSERT_EQUAL_UINT8(5, config.hopLimit);
+
+    TEST_ASSERT_FALSE(config.parse("nodes=1"));
+    TEST_ASSERT_FALSE(config.parse("bogus=1"));
+    TEST_ASSERT_FALSE(config.parse("preset=Nope"));
+}
+#endif
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+#ifdef ARCH_PORTDUINO
+    RUN_TEST(test_SameSeedSameReport);
+    RUN_TEST(test_OtherSeedOtherMesh);
+    RUN_TEST(test_TwoNodesAlwaysDeliver);
+    RUN_TEST(test_OutOfRangeNeverDelivers);
+    RUN_TEST(test_ParseSpec);
+#endif
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
@@ -0,0 +1,182 @@
+#include "FSCommon.h"
+#include "NodeJournal.h"
+#include "configuration.h"
+
+#include <unity.h>
+
+#ifdef FSCom
+
+#define TEST_NODES 8
+
+static const char *snapshotFileName = "/jnltest/db.proto";
+static const char *journalFileName = "/prefs/nodes.jnl"; // where NodeJournal keeps it
+
+static std::vector<meshtastic_NodeInfoLite> nodes;
+static pb_size_t numNodes;
+
+static void writeFile(const char *filename, const uint8_t *data, size_t len)
+{
+    auto f = FSCom.open(filename, FILE_O_WRITE);
+    TEST_ASSERT_TRUE((bool)f);
+    TEST_ASSERT_EQUAL(len, f.write(data, len));
+    f.close();
+}
+
+static void writeSnapshot(uint8_t contents)
+{
+    uint8_t data[32];
+    memset(data, contents, sizeof(data));
+    writeFile(snapshotFileName, data, sizeof(data));
+}
+
+/// Nodes 1, 2 and 3, as they are in the snapshot
+static void loadSnapshotNodes(std::vector<meshtastic_NodeInfoLite> &v, pb_size_t &n)
+{
+    v.assign(TEST_NODES, meshtastic_NodeInfoLite());
+    for (n = 0; n < 3; n++) {
+        v[n] = meshtastic_NodeInfoLite_init_default;
+        v[n].num = n + 1;
+        v[n].snr = 1.0f;
+    }
+}
+
+static const meshtastic_NodeInfoLite *findNode(const std::vector<meshtastic_NodeInfoLite> &v, pb_size_t n, NodeNum num)
+{
+    for (pb_size_t i = 0; i < n; i++)
+        if (v[i].num == num)
+            return &v[i];
+    return NULL;
+}
+
+/// Change node 2, remove node 3 and add node 4, then journal that
+static void journalSomeChanges(NodeJournal &journal)
+{
+    nodes[1].snr = 7.5f;
+    nodes[2] = meshtastic_NodeInfoLite_init_default;
+    nodes[2].num = 4;
+    TEST_ASSERT_TRUE(journal.append(nodes, numNodes));
+}
+
+void setUp(void)
+{
+    FSCom.mkdir("/prefs");
+    FSCom.mkdir("/jnltest");
+    FSCom.remove(journalFileName);
+    writeSnapshot(0x11);
+    loadSnapshotNodes(nodes, numNodes);
+}
+
+void tearDown(void)
+{
+    FSCom.remove(journalFileName);
+}
+
+void test_ReplayAppliesChanges(void)
+{
+    NodeJournal journal;
+    journal.rebase(nodes, numNodes, 0, NodeJournal::fileCrc(snapshotFileName));
+    journalSomeChanges(journal);
+
+    // Nothing changed since, so nothing more is written
+    uint32_t bytes = journal.getBytes();
+    TEST_ASSERT_TRUE(journal.append(nodes, numNodes));
+    TEST_ASSERT_EQUAL_UINT32(bytes, journal.getBytes());
+
+    // Reboot
+    std::vector<meshtastic_NodeInfoLite> loaded;
+    pb_size_t numLoaded;
+    loadSnapshotNodes(loaded, numLoaded);
+    NodeJournal replayed;
+    TEST_ASSERT_TRUE(replayed.replay(loaded, numLoaded, NodeJournal::fileCrc(snapshotFileName)));
+
+    TEST_ASSERT_EQUAL(3, numLoaded);
+    TEST_ASSERT_NOT_NULL(findNode(loaded, numLoaded, 1));
+    TEST_ASSERT_NOT_NULL(findNode(loaded, numLoaded, 4));
+    TEST_ASSERT_NULL(findNode(loaded, numLoaded, 3));
+    TEST_ASSERT_EQUAL_FLOAT(7.5f, findNode(loaded, numLoaded, 2)->snr);
+    TEST_ASSERT_EQUAL_UINT32(bytes, replayed.getBytes());
+}
+
+void test_DamagedRecordStopsReplay(void)
+{
+    NodeJournal journal;
+    journal.rebase(nodes, numNodes, 0, NodeJournal::fileCrc(snapshotFileName));
+    journalSomeChanges(journal);
+
+    // Flip a bit in the last record (the removal of node 3), like a write torn by a power loss
+    uint8_t data[1024];
+    auto f = FSCom.open(journalFileName, FILE_O_READ);
+    size_t len = f.read(data, sizeof(data));
+    f.close();
+    TEST_ASSERT_TRUE(len > 0 && len < sizeof(data));
+    data[len - 1] ^= 0x01;
+    writeFile(journalFileName, data, len);
+
+    std::vector<meshtastic_NodeInfoLite> loaded;
+    pb_size_t numLoaded;
+    loadSnapshotNodes(loaded, numLoaded);
+    NodeJournal replayed;
+    TEST_ASSERT_FALSE(replayed.replay(loaded, numLoaded, NodeJournal::fileCrc(snapshotFileName)));
+
+    // Everything before the damage was applied, the removal wasn't
+    TEST_ASSERT_EQUAL_FLOAT(7.5f, findNode(loaded, numLoaded, 2)->snr);
+    TEST_ASSERT_NOT_NULL(findNode(loaded, numLoaded, 4));
+    TEST_ASSERT_NOT_NULL(findNode(loaded, numLoaded, 3));
+}
+
+void test_JournalOfOlderSnapshotIgnored(void)
+{
+    NodeJournal journal;
+    journal.rebase(nodes, numNodes, 0, NodeJournal::fileCrc(snapshotFileName));
+    journalSomeChanges(journal);
+
+    // Compaction wrote a new snapshot, but we lost power before the journal was removed
+    writeSnapshot(0x22);
+
+    std::vector<meshtastic_NodeInfoLite> loaded;
+    pb_size_t numLoaded;
+    loadSnapshotNodes(loaded, numLoaded);
+    NodeJournal replayed;
+    TEST_ASSERT_TRUE(replayed.replay(loaded, numLoaded, NodeJournal::fileCrc(snapshotFileName)));
+
+    TEST_ASSERT_EQUAL(3, numLoaded);
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, findNode(loaded, numLoaded, 2)->snr);
+    TEST_ASSERT_NULL(findNode(loaded, numLoaded, 4));
+    TEST_ASSERT_FALSE(FSCom.exists(journalFileName));
+    TEST_ASSERT_EQUAL_UINT32(0, replayed.getBytes());
+}
+
+void test_SnapshotNeededAfterHeaderChange(void)
+{
+    NodeJournal journal;
+    TEST_ASSERT_FALSE(journal.canAppend(0)); // we don't know what is on disk yet
+
+    journal.rebase(nodes, numNodes, 0x1234, NodeJournal::fileCrc(snapshotFileName));
+    TEST_ASSERT_TRUE(journal.canAppend(0x1234));
+    TEST_ASSERT_FALSE(journal.canAppend(0x4321));
+
+    journal.invalidate();
+    TEST_ASSERT_FALSE(journal.canAppend(0x1234));
+}
+#endif
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+#ifdef FSCom
+    RUN_TEST(test_ReplayAppliesChanges);
+    RUN_TEST(test_DamagedRecordStopsReplay);
+    RUN_TEST(test_JournalOfOlderSnapshotIgnored);
+    RUN_TEST(test_SnapshotNeededAfterHeaderChange);
+#endif
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
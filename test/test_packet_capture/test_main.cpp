@@ -0,0 +1,128 @@
+#include "configuration.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#ifdef ARCH_PORTDUINO
+#include "platform/portduino/PacketCapture.h"
+
+#define CAPTURE_PATH "/tmp/test_packet_capture.pcap"
+
+static size_t makeRaw(uint8_t *buf, uint32_t i)
+{
+    PacketHeader h = {};
+    h.to = 0xffffffff;
+    h.from = 0x1000 + i;
+    h.id = 0xabc00 + i;
+    h.flags = 3 | (5 << PACKET_FLAGS_HOP_START_SHIFT) | (i % 2 ? PACKET_FLAGS_WANT_ACK_MASK : 0);
+    h.channel = 8;
+    memcpy(buf, &h, sizeof(h));
+
+    size_t payloadLen = 10 + i * 20;
+    for (size_t j = 0; j < payloadLen; j++)
+        buf[sizeof(h) + j] = i + j;
+    return sizeof(h) + payloadLen;
+}
+
+void test_WriteAndReadBack()
+{
+    remove(CAPTURE_PATH);
+    {
+        PacketCapture capture;
+        TEST_ASSERT_TRUE(capture.open(CAPTURE_PATH));
+        uint8_t buf[MAX_LORA_PAYLOAD_LEN + 1];
+        for (uint32_t i = 0; i < 10; i++) {
+            size_t len = makeRaw(buf, i);
+            capture.write(buf, len, 6.25 - i, -100 + (int)i, 250, 11, 5);
+        }
+    } // the destructor flushes
+
+    PacketCaptureReader reader;
+    TEST_ASSERT_TRUE(reader.open(CAPTURE_PATH));
+
+    CapturedPacket c;
+    uint8_t expected[MAX_LORA_PAYLOAD_LEN + 1];
+    for (uint32_t i = 0; i < 10; i++) {
+        TEST_ASSERT_TRUE(reader.next(c));
+        size_t len = makeRaw(expected, i);
+        TEST_ASSERT_EQUAL(len, c.len);
+        TEST_ASSERT_EQUAL_MEMORY(expected, c.bytes, len);
+        TEST_ASSERT_EQUAL(11, c.meta.sf);
+        TEST_ASSERT_EQUAL(2500, c.meta.bw100Hz);
+
+        meshtastic_MeshPacket mp;
+        TEST_ASSERT_TRUE(c.toMeshPacket(mp));
+        TEST_ASSERT_EQUAL_UINT32(0x1000 + i, mp.from);
+        TEST_ASSERT_EQUAL_UINT32(0xabc00 + i, mp.id);
+        TEST_ASSERT_EQUAL(3, mp.hop_limit);
+        TEST_ASSERT_EQUAL(5, mp.hop_start);
+        TEST_ASSERT_EQUAL(i % 2, mp.want_ack);
+        TEST_ASSERT_EQUAL_FLOAT(6.25 - i, mp.rx_snr);
+        TEST_ASSERT_EQUAL(-100 + (int)i, mp.rx_rssi);
+        TEST_ASSERT_EQUAL(len - sizeof(PacketHeader), mp.encrypted.size);
+    }
+    TEST_ASSERT_FALSE(reader.next(c));
+}
+
+void test_AppendKeepsOneHeader()
+{
+    uint8_t buf[MAX_LORA_PAYLOAD_LEN + 1];
+    size_t len = makeRaw(buf, 0);
+    for (int run = 0; run < 2; run++) {
+        PacketCapture capture;
+        TEST_ASSERT_TRUE(capture.open(CAPTURE_PATH));
+        capture.write(buf, len, 0, -80, 125, 9, 5);
+    }
+
+    PacketCaptureReader reader;
+    TEST_ASSERT_TRUE(reader.open(CAPTURE_PATH));
+    CapturedPacket c;
+    uint32_t count = 0;
+    while (reader.next(c))
+        count++;
+    TEST_ASSERT_EQUAL_UINT32(12, count); // 10 from the test before
+}
+
+void test_RefuseOtherFiles()
+{
+    FILE *f = fopen(CAPTURE_PATH, "w");
+    fputs("{\"not\": \"a capture\"}\n", f);
+    fclose(f);
+
+    PacketCapture capture;
+    TEST_ASSERT_FALSE(capture.open(CAPTURE_PATH));
+    PacketCaptureReader reader;
+    TEST_ASSERT_FALSE(reader.open(CAPTURE_PATH));
+}
+
+void test_TooShortIsNotAPacket()
+{
+    CapturedPacket c = {};
+    c.len = sizeof(PacketHeader) - 1;
+    meshtastic_MeshPacket mp;
+    TEST_ASSERT_FALSE(c.toMeshPacket(mp));
+}
+#endif
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+#ifdef ARCH_PORTDUINO
+    RUN_TEST(test_WriteAndReadBack);
+    RUN_TEST(test_AppendKeepsOneHeader);
+    RUN_TEST(test_RefuseOtherFiles);
+    RUN_TEST(test_TooShortIsNotAPacket);
+    remove(CAPTURE_PATH);
+#endif
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
@@ -0,0 +1,93 @@
+#include "PowerMon.h"
+
+#include <Arduino.h>
+#include <unity.h>
+
+// millis() isn't exact, allow this much either way
+#define SLACK_MSEC 15
+
+static PowerMon *pm;
+
+void setUp(void)
+{
+    pm = new PowerMon();
+}
+
+void tearDown(void)
+{
+    delete pm;
+}
+
+static void assertAbout(uint32_t expected, uint64_t actual)
+{
+    TEST_ASSERT_UINT32_WITHIN(SLACK_MSEC, expected, (uint32_t)actual);
+}
+
+void test_AwakeUntilSleeping(void)
+{
+    delay(50);
+    pm->setState(meshtastic_PowerMon_State_CPU_LightSleep);
+    delay(100);
+    pm->clearState(meshtastic_PowerMon_State_CPU_LightSleep);
+    delay(50);
+
+    assertAbout(100, pm->getMsec(PowerMon::CPU_AWAKE));
+    assertAbout(100, pm->getMsec(PowerMon::CPU_LIGHTSLEEP));
+}
+
+void test_TransmitNotChargedAsReceive(void)
+{
+    pm->setState(meshtastic_PowerMon_State_Lora_RXOn);
+    delay(100);
+    pm->setState(meshtastic_PowerMon_State_Lora_TXOn); // RX isn't cleared first
+    delay(50);
+    pm->clearState(meshtastic_PowerMon_State_Lora_TXOn);
+    delay(100);
+    pm->clearState(meshtastic_PowerMon_State_Lora_RXOn);
+    delay(50);
+
+    assertAbout(200, pm->getMsec(PowerMon::LORA_RX));
+    assertAbout(50, pm->getMsec(PowerMon::LORA_TX));
+}
+
+void test_RepeatedStateCountsOnce(void)
+{
+    pm->setState(meshtastic_PowerMon_State_GPS_Active);
+    delay(50);
+    pm->setState(meshtastic_PowerMon_State_GPS_Active);
+    delay(50);
+    pm->clearState(meshtastic_PowerMon_State_GPS_Active);
+    pm->clearState(meshtastic_PowerMon_State_GPS_Active);
+
+    assertAbout(100, pm->getMsec(PowerMon::GPS));
+    TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)pm->getMsec(PowerMon::SCREEN));
+}
+
+void test_ChargeFromCurrent(void)
+{
+    pm->setState(meshtastic_PowerMon_State_Screen_On);
+    delay(200);
+    pm->clearState(meshtastic_PowerMon_State_Screen_On);
+
+    uint64_t msec = pm->getMsec(PowerMon::SCREEN);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, msec * POWERMON_SCREEN_MA / 3600000.0f, pm->getMah(PowerMon::SCREEN));
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_AwakeUntilSleeping);
+    RUN_TEST(test_TransmitNotChargedAsReceive);
+    RUN_TEST(test_RepeatedStateCountsOnce);
+    RUN_TEST(test_ChargeFromCurrent);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
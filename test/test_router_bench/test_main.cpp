@@ -0,0 +1,368 @@
+#include "MeshModule.h"
+#include "MeshPacketQueue.h"
+#include "MeshService.h"
+#include "NodeDB.h"
+#include "ReliableRouter.h"
+#include "airtime.h"
+#include "configuration.h"
+#include "mesh-pb-constants.h"
+#include "modules/Modules.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unity.h>
+#include <unordered_map>
+#include <vector>
+
+#ifdef ARCH_PORTDUINO
+#include "platform/portduino/PacketCapture.h"
+#include "platform/portduino/SimRadio.h"
+
+// Packets per run, and how many different nodes they come from
+#define BENCH_PACKETS 2000
+#define BENCH_SENDERS 50
+// Give up on the router if it hasn't handed a batch to the modules by then
+#define BENCH_TIMEOUT_MSEC 5000
+// Packets we give the router at once, the default depth of its fromRadioQueue
+#define BENCH_BATCH 8
+
+extern RadioInterface *rIf;
+
+// Count every heap allocation in the process (the router stack, the RX workers and us)
+static std::atomic<uint32_t> allocations(0);
+
+void *operator new(size_t size)
+{
+    allocations++;
+    void *p = malloc(size ? size : 1);
+    if (!p)
+        abort();
+    return p;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+struct StageResult {
+    const char *name;
+    uint32_t count;
+    uint32_t p50Us, p99Us, maxUs;
+    float allocsPerPacket;
+};
+
+static std::vector<StageResult> results;
+static float throughputPps;
+
+static StageResult summarize(const char *name, std::vector<uint32_t> &us, uint32_t allocs)
+{
+    StageResult r = {name, (uint32_t)us.size(), 0, 0, 0, 0};
+    if (!us.empty()) {
+        std::sort(us.begin(), us.end());
+        r.p50Us = us[us.size() / 2];
+        r.p99Us = us[us.size() * 99 / 100];
+        r.maxUs = us.back();
+        r.allocsPerPacket = (float)allocs / us.size();
+    }
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%-14s p50 %5u us, p99 %5u us, max %6u us, %.1f allocs/packet", name, r.p50Us, r.p99Us, r.maxUs,
+             r.allocsPerPacket);
+    TEST_MESSAGE(msg);
+    results.push_back(r);
+    return r;
+}
+
+/// What main.cpp's setup() builds, minus the hardware
+static void setupStack()
+{
+    nodeDB = new NodeDB;
+    config.lora.region = meshtastic_Config_LoRaConfig_RegionCode_US;
+    initRegion();
+    router = new ReliableRouter();
+    airTime = new AirTime();
+    service = new MeshService();
+    service->init();
+    setupModules();
+
+    rIf = new SimRadio;
+    rIf->init();
+    router->addInterface(rIf);
+}
+
+/// A mix of what a busy mesh carries: texts, positions, telemetry and node infos from BENCH_SENDERS nodes
+static meshtastic_MeshPacket makeDecoded(uint32_t i)
+{
+    meshtastic_MeshPacket p = meshtastic_MeshPacket_init_zero;
+    p.which_payload_variant = meshtastic_MeshPacket_decoded_tag;
+    p.from = 0x10000 + i % BENCH_SENDERS;
+    p.to = NODENUM_BROADCAST;
+    p.id = generatePacketId();
+    p.channel = 0;
+    p.hop_limit = 0; // measure receiving, not our rebroadcasts
+    p.hop_start = 3;
+    p.rx_snr = 5.25;
+    p.rx_rssi = -90;
+
+    meshtastic_Data &d = p.decoded;
+    switch (i % 4) {
+    case 0: {
+        d.portnum = meshtastic_PortNum_TEXT_MESSAGE_APP;
+        d.payload.size = snprintf((char *)d.payload.bytes, sizeof(d.payload.bytes), "Benchmark message number %u", i);
+        break;
+    }
+    case 1: {
+        meshtastic_Position pos = meshtastic_Position_init_zero;
+        pos.has_latitude_i = pos.has_longitude_i = pos.has_altitude = true;
+        pos.latitude_i = 520000000 + i;
+        pos.longitude_i = 43000000 - i;
+        pos.altitude = 12;
+        pos.time = 1700000000 + i;
+        d.portnum = meshtastic_PortNum_POSITION_APP;
+        d.payload.size = pb_encode_to_bytes(d.payload.bytes, sizeof(d.payload.bytes), &meshtastic_Position_msg, &pos);
+        break;
+    }
+    case 2: {
+        meshtastic_Telemetry t = meshtastic_Telemetry_init_zero;
+        t.time = 1700000000 + i;
+        t.which_variant = meshtastic_Telemetry_device_metrics_tag;
+        t.variant.device_metrics.has_battery_level = t.variant.device_metrics.has_voltage = true;
+        t.variant.device_metrics.battery_level = 80;
+        t.variant.device_metrics.voltage = 3.9;
+        d.portnum = meshtastic_PortNum_TELEMETRY_APP;
+        d.payload.size = pb_encode_to_bytes(d.payload.bytes, sizeof(d.payload.bytes), &meshtastic_Telemetry_msg, &t);
+        break;
+    }
+    default: {
+        meshtastic_User u = meshtastic_User_init_zero;
+        snprintf(u.id, sizeof(u.id), "!%08x", p.from);
+        snprintf(u.long_name, sizeof(u.long_name), "Bench node %u", p.from & 0xff);
+        snprintf(u.short_name, sizeof(u.short_name), "B%02x", p.from & 0xff);
+        d.portnum = meshtastic_PortNum_NODEINFO_APP;
+        d.payload.size = pb_encode_to_bytes(d.payload.bytes, sizeof(d.payload.bytes), &meshtastic_User_msg, &u);
+        break;
+    }
+    }
+    return p;
+}
+
+/// Fresh packet ids every time, the router drops anything it has seen before
+static std::vector<meshtastic_MeshPacket> makeEncryptedStream(uint32_t count)
+{
+    std::vector<meshtastic_MeshPacket> stream;
+    stream.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        meshtastic_MeshPacket p = makeDecoded(i);
+        TEST_ASSERT_EQUAL(meshtastic_Routing_Error_NONE, perhapsEncode(&p));
+        stream.push_back(p);
+    }
+    return stream;
+}
+
+/**
+ * The packets of a capture (set ROUTER_BENCH_CAPTURE to its path) instead of our made up mix, minus the duplicates and whatever
+ * our channels can't decrypt, the router would never hand those to the modules.
+ */
+static std::vector<meshtastic_MeshPacket> loadCapture(const char *path)
+{
+    std::vector<meshtastic_MeshPacket> stream;
+    PacketCaptureReader reader;
+    TEST_ASSERT_TRUE_MESSAGE(reader.open(path), "ROUTER_BENCH_CAPTURE is not a packet capture");
+
+    std::unordered_map<uint64_t, bool> seen;
+    CapturedPacket c;
+    meshtastic_MeshPacket p;
+    while (reader.next(c)) {
+        if (!c.toMeshPacket(p) || !seen.emplace(((uint64_t)p.from << 32) | p.id, true).second)
+            continue;
+        meshtastic_MeshPacket decoded = p;
+        if (perhapsDecode(&decoded))
+            stream.push_back(p);
+    }
+    TEST_ASSERT_TRUE_MESSAGE(!stream.empty(), "No packets in the capture that we can decrypt");
+    return stream;
+}
+
+static std::vector<meshtastic_MeshPacket> makeStream()
+{
+    const char *capture = getenv("ROUTER_BENCH_CAPTURE");
+    return capture ? loadCapture(capture) : makeEncryptedStream(BENCH_PACKETS);
+}
+
+/// Sees every packet that makes it through the router, to time it end to end
+class BenchModule : public MeshModule
+{
+  public:
+    std::unordered_map<PacketId, uint32_t> enqueuedUs; // packets we are waiting for
+    std::vector<uint32_t> latencyUs;
+    uint32_t handled = 0;
+
+    BenchModule() : MeshModule("bench") { isPromiscuous = true; }
+
+  protected:
+    bool wantPacket(const meshtastic_MeshPacket *p) override { return true; }
+
+    ProcessMessage handleReceived(const meshtastic_MeshPacket &mp) override
+    {
+        auto i = enqueuedUs.find(mp.id);
+        if (i != enqueuedUs.end()) {
+            latencyUs.push_back(micros() - i->second);
+            enqueuedUs.erase(i);
+            handled++;
+        }
+        return ProcessMessage::CONTINUE;
+    }
+};
+
+static BenchModule *benchModule;
+
+void test_PerhapsDecode()
+{
+    std::vector<meshtastic_MeshPacket> stream = makeStream();
+    std::vector<uint32_t> us;
+
+    uint32_t allocs = allocations;
+    for (const meshtastic_MeshPacket &enc : stream) {
+        meshtastic_MeshPacket p = enc;
+        uint32_t start = micros();
+        bool ok = perhapsDecode(&p);
+        us.push_back(micros() - start);
+        TEST_ASSERT_TRUE(ok);
+    }
+    summarize("perhapsDecode", us, allocations - allocs);
+}
+
+void test_CallModules()
+{
+    std::vector<uint32_t> us;
+
+    uint32_t allocs = allocations;
+    for (uint32_t i = 0; i < BENCH_PACKETS; i++) {
+        meshtastic_MeshPacket p = makeDecoded(i);
+        uint32_t start = micros();
+        MeshModule::callModules(p, RX_SRC_RADIO);
+        us.push_back(micros() - start);
+    }
+    summarize("callModules", us, allocations - allocs);
+}
+
+void test_MeshPacketQueue()
+{
+    MeshPacketQueue queue(MAX_TX_QUEUE);
+    std::vector<uint32_t> us;
+
+    uint32_t allocs = allocations;
+    for (uint32_t i = 0; i < BENCH_PACKETS; i += MAX_TX_QUEUE) {
+        // Fill it with mixed priorities, then drain it
+        for (uint32_t j = 0; j < MAX_TX_QUEUE; j++) {
+            meshtastic_MeshPacket *p = packetPool.allocZeroed();
+            p->id = i + j;
+            p->priority = (meshtastic_MeshPacket_Priority)(j % 3 ? meshtastic_MeshPacket_Priority_DEFAULT
+                                                                 : meshtastic_MeshPacket_Priority_RELIABLE);
+            uint32_t start = micros();
+            queue.enqueue(p);
+            us.push_back(micros() - start);
+        }
+        while (!queue.empty())
+            packetPool.release(queue.dequeue());
+    }
+    summarize("queue enqueue", us, allocations - allocs);
+}
+
+void test_RouterEndToEnd()
+{
+    std::vector<meshtastic_MeshPacket> stream = makeStream();
+    benchModule->enqueuedUs.clear();
+    benchModule->latencyUs.clear();
+    benchModule->handled = 0;
+
+    uint32_t allocs = allocations;
+    uint32_t start = micros();
+    uint32_t next = 0;
+    // Feed the router the way the radio does, as fast as fromRadioQueue takes them
+    while (benchModule->handled < stream.size()) {
+        uint32_t batchStart = millis();
+        while (next < stream.size() && next - benchModule->handled < BENCH_BATCH) {
+            benchModule->enqueuedUs[stream[next].id] = micros();
+            router->enqueueReceivedMessage(packetPool.allocCopy(stream[next]));
+            next++;
+        }
+        while (benchModule->handled < next && millis() - batchStart < BENCH_TIMEOUT_MSEC)
+            router->runOnce();
+        if (benchModule->handled < next)
+            break; // lost some
+    }
+    uint32_t elapsedUs = micros() - start;
+
+    TEST_ASSERT_EQUAL_UINT32(stream.size(), benchModule->handled);
+    throughputPps = benchModule->handled * 1e6f / max(elapsedUs, 1U);
+    summarize("router e2e", benchModule->latencyUs, allocations - allocs);
+
+    char msg[64];
+    snprintf(msg, sizeof(msg), "router throughput %.0f packets/s", throughputPps);
+    TEST_MESSAGE(msg);
+}
+
+/// Machine readable results, so runs from two commits can be diffed
+static void writeJson()
+{
+    const char *path = getenv("ROUTER_BENCH_JSON");
+    if (!path)
+        path = "router_bench.json";
+    FILE *f = fopen(path, "w");
+    if (!f)
+        return;
+
+    fprintf(f, "{\n  \"packets\": %u,\n  \"senders\": %u,\n  \"throughput_pps\": %.1f,\n  \"stages\": {\n", BENCH_PACKETS,
+            BENCH_SENDERS, throughputPps);
+    for (size_t i = 0; i < results.size(); i++) {
+        const StageResult &r = results[i];
+        fprintf(f, "    \"%s\": {\"count\": %u, \"p50_us\": %u, \"p99_us\": %u, \"max_us\": %u, \"allocs_per_packet\": %.2f}%s\n",
+                r.name, r.count, r.p50Us, r.p99Us, r.maxUs, r.allocsPerPacket, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  }\n}\n");
+    fclose(f);
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "Results written to %s", path);
+    TEST_MESSAGE(msg);
+}
+#endif
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+#ifdef ARCH_PORTDUINO
+    setupStack();
+    benchModule = new BenchModule();
+
+    RUN_TEST(test_PerhapsDecode);
+    RUN_TEST(test_CallModules);
+    RUN_TEST(test_MeshPacketQueue);
+    RUN_TEST(test_RouterEndToEnd);
+    writeJson();
+#endif
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
@@ -0,0 +1,103 @@
+#include "FSCommon.h"
+#include "SafeFile.h"
+#include "configuration.h"
+#include "mesh-pb-constants.h"
+
+#include <pb_decode.h>
+#include <pb_encode.h>
+#include <unity.h>
+
+#define BENCH_NODES 1000
+#define BENCH_ROUNDS 5
+
+static const char *benchFileName = "/bench/db.proto";
+
+static meshtastic_DeviceState *state;
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+#ifdef ARCH_PORTDUINO
+/// Same as NodeDB::saveDeviceStateToDisk(), but with a DeviceState far bigger than any real device would keep
+static bool saveState()
+{
+    auto f = SafeFile(benchFileName, false);
+    pb_ostream_t stream = {&writecb, static_cast<Print *>(&f), sizeof(*state) + BENCH_NODES * meshtastic_NodeInfoLite_size};
+    bool okay = pb_encode(&stream, &meshtastic_DeviceState_msg, state);
+    return f.close() && okay;
+}
+
+void test_SaveLargeDeviceState(void)
+{
+    uint32_t best = UINT32_MAX, total = 0;
+    for (int i = 0; i < BENCH_ROUNDS; i++) {
+        uint32_t start = micros();
+        TEST_ASSERT_TRUE(saveState());
+        uint32_t t = micros() - start;
+        total += t;
+        best = min(best, t);
+    }
+
+    auto f = FSCom.open(benchFileName, FILE_O_READ);
+    TEST_ASSERT_TRUE((bool)f);
+    size_t size = f.size();
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%d nodes, %u bytes: best %u us, average %u us per save (including readback)", BENCH_NODES,
+             (unsigned)size, best, total / BENCH_ROUNDS);
+    TEST_MESSAGE(msg);
+
+    // And make sure what we wrote decodes to the same nodes
+    meshtastic_DeviceState *loaded = new meshtastic_DeviceState();
+    pb_istream_t stream = {&readcb, &f, size};
+    TEST_ASSERT_TRUE(pb_decode(&stream, &meshtastic_DeviceState_msg, loaded));
+    f.close();
+    TEST_ASSERT_EQUAL(BENCH_NODES, loaded->node_db_lite.size());
+    TEST_ASSERT_EQUAL_UINT32(state->node_db_lite[BENCH_NODES - 1].num, loaded->node_db_lite[BENCH_NODES - 1].num);
+    TEST_ASSERT_EQUAL_STRING(state->node_db_lite[BENCH_NODES - 1].user.long_name,
+                             loaded->node_db_lite[BENCH_NODES - 1].user.long_name);
+    delete loaded;
+}
+#endif
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    state = new meshtastic_DeviceState();
+    state->version = 23;
+    state->has_my_node = true;
+    state->has_owner = true;
+    for (int i = 0; i < BENCH_NODES; i++) {
+        meshtastic_NodeInfoLite node = meshtastic_NodeInfoLite_init_default;
+        node.num = 0x10000 + i;
+        node.has_user = true;
+        snprintf(node.user.long_name, sizeof(node.user.long_name), "Bench node %d", i);
+        snprintf(node.user.short_name, sizeof(node.user.short_name), "%04x", i);
+        node.user.public_key.size = 32;
+        memset(node.user.public_key.bytes, i & 0xff, 32);
+        node.has_position = true;
+        node.position.latitude_i = 374000000 + i;
+        node.position.longitude_i = -1220000000 - i;
+        node.last_heard = 1700000000 + i;
+        node.snr = 5.25f;
+        state->node_db_lite.push_back(node);
+    }
+#ifdef FSCom
+    FSCom.mkdir("/bench");
+#endif
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+#ifdef ARCH_PORTDUINO
+    RUN_TEST(test_SaveLargeDeviceState);
+#endif
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
@@ -0,0 +1,120 @@
+#include "concurrency/OSThread.h"
+#include "configuration.h"
+
+#include <unity.h>
+
+using namespace concurrency;
+
+// Roughly the number of threads a fully loaded build has running
+#define BENCH_THREADS (MAX_THREADS < 40 ? MAX_THREADS : 40)
+#define BENCH_MSEC 5000
+
+class BenchThread : public OSThread
+{
+  public:
+    uint32_t period;
+    uint32_t runs = 0;
+
+    BenchThread(uint32_t _period) : OSThread("Bench", _period), period(_period) {}
+
+  protected:
+    int32_t runOnce() override
+    {
+        runs++;
+        return period;
+    }
+};
+
+static BenchThread *threads[BENCH_THREADS];
+
+struct BenchResult {
+    uint32_t wakeups = 0;
+    uint64_t busyUs = 0;
+};
+
+static void resetThreads()
+{
+    for (int i = 0; i < BENCH_THREADS; i++) {
+        threads[i]->runs = 0;
+        threads[i]->setIntervalFromNow(threads[i]->period);
+    }
+}
+
+/// Run the main loop for BENCH_MSEC using either the old polling controller or the heap scheduler
+static BenchResult runLoop(bool useScheduler)
+{
+    BenchResult r;
+    resetThreads();
+
+    uint32_t start = millis();
+    while (millis() - start < BENCH_MSEC) {
+        uint32_t t0 = micros();
+        long delayMsec = useScheduler ? mainScheduler.runOrDelay() : mainController.runOrDelay();
+        r.busyUs += micros() - t0;
+        r.wakeups++;
+
+        uint32_t left = BENCH_MSEC - (millis() - start);
+        mainDelay.delay(delayMsec < (long)left ? delayMsec : left);
+    }
+    return r;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_SchedulerRunsLikePolling(void)
+{
+    runLoop(false);
+    uint32_t pollRuns[BENCH_THREADS];
+    for (int i = 0; i < BENCH_THREADS; i++)
+        pollRuns[i] = threads[i]->runs;
+
+    runLoop(true);
+    for (int i = 0; i < BENCH_THREADS; i++) {
+        // Allow some slack for loop start/stop and for intervals being measured from the actual run time
+        uint32_t expected = BENCH_MSEC / threads[i]->period;
+        TEST_ASSERT_UINT32_WITHIN(pollRuns[i] / 20 + 1, pollRuns[i], threads[i]->runs);
+        TEST_ASSERT_UINT32_WITHIN(expected / 10 + 1, expected, threads[i]->runs);
+    }
+}
+
+void test_SchedulerIdleCost(void)
+{
+    BenchResult poll = runLoop(false);
+    BenchResult sched = runLoop(true);
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%d threads, polling: %u wakeups %lu us busy, scheduler: %u wakeups %lu us busy", BENCH_THREADS,
+             poll.wakeups, (unsigned long)poll.busyUs, sched.wakeups, (unsigned long)sched.busyUs);
+    TEST_MESSAGE(msg);
+
+    // The scheduler must not wake up more often than polling did
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(poll.wakeups + 1, sched.wakeups);
+
+    const OSThread::Stats &stats = threads[0]->getStats();
+    TEST_ASSERT_GREATER_THAN_UINT32(0, stats.runCount);
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    hasBeenSetup = true;
+    OSThread::setup();
+    // Periods from 20ms to ~2s, like a mix of radio, screen, button and module threads
+    for (int i = 0; i < BENCH_THREADS; i++)
+        threads[i] = new BenchThread(20 + i * i * 1200 / (BENCH_THREADS * BENCH_THREADS / 2));
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_SchedulerRunsLikePolling);
+    RUN_TEST(test_SchedulerIdleCost);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}
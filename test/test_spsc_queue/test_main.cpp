@@ -0,0 +1,99 @@
+#include "concurrency/SPSCQueue.h"
+#include "configuration.h"
+
+#include <atomic>
+#include <thread>
+#include <unity.h>
+
+using namespace concurrency;
+
+#define STRESS_COUNT 200000
+#define STRESS_BURST 16
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_SPSCQueueBasics(void)
+{
+    SPSCQueue<uint32_t> q(5); // rounded up to 8
+    TEST_ASSERT_EQUAL_UINT32(8, q.capacity());
+    TEST_ASSERT_TRUE(q.isEmpty());
+
+    for (uint32_t i = 0; i < 8; i++)
+        TEST_ASSERT_TRUE(q.enqueue(i));
+    TEST_ASSERT_FALSE(q.enqueue(99));
+    TEST_ASSERT_EQUAL_UINT32(1, q.getDropped());
+    TEST_ASSERT_EQUAL_UINT32(8, q.getHighWater());
+    TEST_ASSERT_EQUAL(0, q.numFree());
+
+    uint32_t v;
+    for (uint32_t i = 0; i < 8; i++) {
+        TEST_ASSERT_TRUE(q.dequeue(&v));
+        TEST_ASSERT_EQUAL_UINT32(i, v);
+    }
+    TEST_ASSERT_FALSE(q.dequeue(&v));
+}
+
+/// One thread plays the radio ISR and pushes bursts of packets, the test thread plays the Router and drains them.
+void test_SPSCQueueStress(void)
+{
+    SPSCQueue<uint32_t> q(8);
+    std::atomic<bool> done{false};
+    uint32_t pushed = 0, accepted = 0;
+
+    std::thread producer([&]() {
+        while (pushed < STRESS_COUNT) {
+            for (int i = 0; i < STRESS_BURST && pushed < STRESS_COUNT; i++) {
+                // Sequence numbers only advance for accepted elements, so the consumer can check ordering
+                if (q.enqueue(accepted))
+                    accepted++;
+                pushed++;
+            }
+            std::this_thread::yield();
+        }
+        done = true;
+    });
+
+    uint32_t received = 0;
+    uint32_t v;
+    bool inOrder = true;
+    for (;;) {
+        bool finished = done; // read before draining, so nothing can be left behind after we stop
+        while (q.dequeue(&v)) {
+            if (v != received)
+                inOrder = false;
+            received++;
+        }
+        if (finished)
+            break;
+    }
+    producer.join();
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "pushed %u, received %u, dropped %u, high water %u", pushed, received, q.getDropped(),
+             q.getHighWater());
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_TRUE(inOrder);
+    TEST_ASSERT_EQUAL_UINT32(accepted, received);
+    TEST_ASSERT_EQUAL_UINT32(pushed, received + q.getDropped());
+    TEST_ASSERT_TRUE(q.isEmpty());
+}
+
+void setup()
+{
+    // NOTE!!! Wait for >2 secs
+    // if board doesn't support software reset via Serial.DTR/RTS
+    delay(10);
+    delay(2000);
+
+    UNITY_BEGIN(); // IMPORTANT LINE!
+    RUN_TEST(test_SPSCQueueBasics);
+    RUN_TEST(test_SPSCQueueStress);
+}
+
+void loop()
+{
+    UNITY_END(); // stop unit testing
+}